@@ -0,0 +1,212 @@
+#include <iso646.h>
+#include <math.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "../mmzklist.h"
+#include "../mmzknumlist.h"
+
+// The number of times each measurement is repeated; the fastest run is reported.
+#define REPEAT 5
+
+// Equality function for int elements.
+static bool int_eq(const void *i1, const void *i2) {
+  return *(int32_t *)i1 == *(int32_t *)i2;
+}
+
+// Copy function for int elements.
+static void *int_copy(const void *i1) {
+  int32_t *result = malloc(sizeof(int32_t));
+  *result = *(int32_t *)i1;
+  return result;
+}
+
+// Free function for int elements.
+static void int_free(void *i1) {
+  free(i1);
+}
+
+// Comparator for int elements.
+static int int_cmp(const void *i1, const void *i2) {
+  return (*(int32_t *)i1 > *(int32_t *)i2) - (*(int32_t *)i1 < *(int32_t *)i2);
+}
+
+// Primitive functions for the construction of an int list
+static mmzk_funs_t int_funs = (mmzk_funs_t){&int_eq, &int_copy, &int_free};
+
+// Wall-clock time in seconds.
+static double now(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+// Worker for mmzk_list_fold_left that adds the element to the accumulator in place.
+static void *sum_worker(void *accum, const void *elem) {
+  *(int64_t *)accum += *(int32_t *)elem;
+  return accum;
+}
+
+// Make a list of LEN pseudo-random ints.
+static mmzk_list_t *random_list(size_t len) {
+  mmzk_list_builder_t *builder = mmzk_list_builder_new(int_funs);
+  uint32_t seed = 1526;
+  for (size_t i = 0; i < len; i++) {
+    seed = seed * 1103515245 + 12345;
+    int32_t elem = (int32_t)(seed >> 8);
+    mmzk_list_builder_append(builder, &elem);
+  }
+
+  return mmzk_list_builder_freeze(builder);
+}
+
+// Walk LIST by the iterator without touching the elements; returns the time taken in seconds.
+static double time_walk(mmzk_list_t *list) {
+  double best = INFINITY;
+  for (int32_t r = 0; r < REPEAT; r++) {
+    double start = now();
+    mmzk_list_iterator_t iter = mmzk_list_iterator(list);
+    uintptr_t checksum = 0;
+    while (mmzk_list_has_next(iter)) {
+      checksum ^= (uintptr_t)mmzk_list_yield(&iter);
+    }
+    double elapsed = now() - start;
+    if (checksum == 1) {
+      puts("");
+    }
+    best = elapsed < best ? elapsed : best;
+  }
+
+  return best;
+}
+
+// Sum LIST by mmzk_list_fold_left; returns the time taken in seconds.
+static double time_fold(mmzk_list_t *list) {
+  double best = INFINITY;
+  for (int32_t r = 0; r < REPEAT; r++) {
+    int64_t sum = 0;
+    double start = now();
+    mmzk_list_fold_left(&sum_worker, &sum, list);
+    double elapsed = now() - start;
+    if (sum == 1) {
+      puts("");
+    }
+    best = elapsed < best ? elapsed : best;
+  }
+
+  return best;
+}
+
+// Print the throughput of traversals taking SECONDS over LEN nodes.
+static void report(const char *caption, size_t len, double seconds) {
+  printf("\t%-32s %8.2f ns/node %10.1f Mnodes/s\n", caption, seconds * 1e9 / (double)len, (double)len / seconds / 1e6);
+}
+
+// Traversal throughput of a fragmented list before and after mmzk_list_compact().
+// The fragmented list is obtained by sorting a list of random ints, which relinks its nodes in an order unrelated to
+// their addresses.
+static void compact_bench(size_t len) {
+  printf("Traversal of a fragmented list of %zu nodes before and after compaction:\n", len);
+  mmzk_list_t *list = random_list(len);
+  mmzk_list_set_persistence(list, false);
+  list = mmzk_list_sort(&int_cmp, list);
+  mmzk_list_set_persistence(list, true);
+
+  report("walk (fragmented):", len, time_walk(list));
+  report("fold_left (fragmented):", len, time_fold(list));
+
+  double start = now();
+  mmzk_list_set_persistence(list, false);
+  list = mmzk_list_compact(list);
+  mmzk_list_set_persistence(list, true);
+  report("compact:", len, now() - start);
+
+  report("walk (compacted):", len, time_walk(list));
+  report("fold_left (compacted):", len, time_fold(list));
+
+  mmzk_list_free(list);
+}
+
+// Searching for an absent element and summing a boxed list against the unboxed numeric list with the same elements.
+static void numlist_bench(size_t len) {
+  printf("Boxed list against numeric list of %zu int32 elements:\n", len);
+  mmzk_list_t *list = random_list(len);
+  mmzk_numlist_t *numlist = mmzk_numlist_from_list(MMZK_INT32, list);
+  int32_t absent = INT32_MAX;
+  double best = INFINITY;
+
+  report("fold_left (boxed):", len, time_fold(list));
+  for (int32_t r = 0; r < REPEAT; r++) {
+    int64_t sum = 0;
+    double start = now();
+    mmzk_numlist_sum(numlist, &sum);
+    double elapsed = now() - start;
+    if (sum == 1) {
+      puts("");
+    }
+    best = elapsed < best ? elapsed : best;
+  }
+  report("sum (numeric):", len, best);
+
+  double start = now();
+  bool found = mmzk_list_is_elem(&absent, list);
+  report("is_elem (boxed):", len, now() - start);
+
+  best = INFINITY;
+  for (int32_t r = 0; r < REPEAT; r++) {
+    start = now();
+    found |= mmzk_numlist_is_elem(&absent, numlist);
+    double elapsed = now() - start;
+    best = elapsed < best ? elapsed : best;
+  }
+  report("is_elem (numeric):", len, best);
+
+  if (found) {
+    puts("");
+  }
+
+  mmzk_numlist_free(numlist);
+  mmzk_list_free(list);
+}
+
+// Repeatedly dropping from and indexing into the same long persistent list, which builds its skip index.
+static void skip_bench(size_t len) {
+  printf("Positional access into a list of %zu nodes:\n", len);
+  mmzk_list_t *list = random_list(len);
+  size_t count = 10000;
+  uint32_t seed = 1526;
+  double start = now();
+
+  for (size_t i = 0; i < count; i++) {
+    seed = seed * 1103515245 + 12345;
+    mmzk_list_t *dropped = mmzk_list_drop(seed % len, list);
+    int32_t *elem = mmzk_list_get(list, seed % len);
+    int_free(elem);
+    mmzk_list_free(dropped);
+  }
+  printf("\t%-32s %8.2f us/op\n", "drop + get:", (now() - start) * 1e6 / (double)count / 2);
+
+  mmzk_list_free(list);
+}
+
+// Takes the number of nodes as an optional argument (10^7 by default).
+int32_t main(int32_t argc, char **argv) {
+  size_t len = 10000000;
+
+  if (argc >= 2) {
+    char *end;
+    len = (size_t)strtoull(argv[1], &end, 10);
+    if (*end != '\0' || len == 0) {
+      puts("Please provide a positive integer as input!");
+      exit(1);
+    }
+  }
+
+  compact_bench(len);
+  numlist_bench(len);
+  skip_bench(len);
+  return 0;
+}
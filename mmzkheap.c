@@ -0,0 +1,327 @@
+#include <assert.h>
+#include <iso646.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "mmzkheap.h"
+
+
+/* Definitions */
+
+// A node of a pairing heap. The children of a node are linked from CHILD through SIBLING, and the SIBLING of a root is
+// NULL. The number of links to a node is PREV_COUNT + 1, as with the nodes of lists.
+struct tree {
+  unsigned int prev_count;
+  const void *elem;
+  struct tree *child;
+  struct tree *sibling;
+};
+
+struct mmzk_heap {
+  bool is_persistent;
+  mmzk_funs_t funs;
+  comparator_t *cmp;
+  size_t size;
+  struct tree *root;
+};
+
+// A growable array of trees.
+struct tree_stack {
+  size_t count;
+  size_t capacity;
+  struct tree **trees;
+};
+
+
+/* Helpers */
+
+#define INIT_HEAP(FUNS, CMP, PERSISTENCE, HEAP) do {\
+  HEAP->funs = FUNS;\
+  HEAP->cmp = CMP;\
+  HEAP->is_persistent = PERSISTENCE;\
+  HEAP->size = 0;\
+  HEAP->root = NULL;\
+} while (false)
+
+static void _stack_init(struct tree_stack *stack) {
+  stack->count = 0;
+  stack->capacity = 16;
+  stack->trees = malloc(stack->capacity * sizeof(struct tree *));
+}
+
+static void _stack_push(struct tree_stack *stack, struct tree *tree) {
+  if (stack->count == stack->capacity) {
+    stack->capacity *= 2;
+    stack->trees = realloc(stack->trees, stack->capacity * sizeof(struct tree *));
+  }
+  stack->trees[stack->count++] = tree;
+}
+
+static inline void _share_tree(struct tree *tree) {
+  if (tree != NULL) {
+    tree->prev_count++;
+  }
+}
+
+// Release a link to TREE, freeing the nodes that are not linked from anything else.
+// Pairing heaps can be as deep as they are large, so the nodes are visited with an explicit stack.
+static void _free_tree(mmzk_funs_t funs, struct tree *tree) {
+  struct tree_stack stack;
+  _stack_init(&stack);
+  _stack_push(&stack, tree);
+
+  while (stack.count > 0) {
+    struct tree *cur = stack.trees[--stack.count];
+    if (cur == NULL) {
+      continue;
+    }
+    if (cur->prev_count > 0) {
+      cur->prev_count--;
+      continue;
+    }
+
+    _stack_push(&stack, cur->child);
+    _stack_push(&stack, cur->sibling);
+    (funs.free_fun)((void *)cur->elem);
+    free(cur);
+  }
+
+  free(stack.trees);
+}
+
+static struct tree *_node(const void *elem, struct tree *child) {
+  struct tree *tree = malloc(sizeof(struct tree));
+  tree->prev_count = 0;
+  tree->elem = elem;
+  tree->child = child;
+  tree->sibling = NULL;
+
+  return tree;
+}
+
+// Make a node that the caller holds a link to writable, i.e. linked from the caller alone. The SIBLING of the result
+// is left for the caller to overwrite, and the link from the original SIBLING is stored in *SIBLING (if not NULL).
+// A node linked from nothing else is returned as it is; otherwise its element is copied and its children are shared.
+static struct tree *_own(mmzk_funs_t funs, struct tree *tree, struct tree **sibling) {
+  if (tree->prev_count == 0) {
+    if (sibling != NULL) {
+      *sibling = tree->sibling;
+    }
+    return tree;
+  }
+
+  tree->prev_count--;
+  if (sibling != NULL) {
+    *sibling = tree->sibling;
+    _share_tree(tree->sibling);
+  }
+  _share_tree(tree->child);
+  return _node((funs.copy_fun)(tree->elem), tree->child);
+}
+
+// Meld two roots the caller holds links to, taking over both.
+static struct tree *_meld(mmzk_heap_t *heap, struct tree *tree1, struct tree *tree2) {
+  if (tree1 == NULL) {
+    return tree2;
+  }
+  if (tree2 == NULL) {
+    return tree1;
+  }
+
+  if ((heap->cmp)(tree2->elem, tree1->elem) < 0) {
+    struct tree *temp = tree1;
+    tree1 = tree2;
+    tree2 = temp;
+  }
+
+  tree1 = _own(heap->funs, tree1, NULL);
+  tree2 = _own(heap->funs, tree2, NULL);
+  tree2->sibling = tree1->child;
+  tree1->child = tree2;
+  tree1->sibling = NULL;
+
+  return tree1;
+}
+
+// Meld the detached roots in STACK into one by the usual two passes: first in pairs from left to right, then the pairs
+// from right to left. The stack is emptied.
+static struct tree *_meld_pairs(mmzk_heap_t *heap, struct tree_stack *stack) {
+  size_t pairs = 0;
+  for (size_t i = 0; i < stack->count; i += 2) {
+    struct tree *pair = i + 1 < stack->count ? stack->trees[i + 1] : NULL;
+    stack->trees[pairs++] = _meld(heap, stack->trees[i], pair);
+  }
+
+  struct tree *result = NULL;
+  while (pairs > 0) {
+    result = _meld(heap, stack->trees[--pairs], result);
+  }
+  stack->count = 0;
+
+  return result;
+}
+
+// New header of the same kind as HEAP holding ROOT with SIZE elements.
+static mmzk_heap_t *_derive(mmzk_heap_t *heap, bool is_persistent, struct tree *root, size_t size) {
+  mmzk_heap_t *result = malloc(sizeof(mmzk_heap_t));
+  INIT_HEAP(heap->funs, heap->cmp, is_persistent, result);
+  result->root = root;
+  result->size = size;
+
+  return result;
+}
+
+// Take the root of HEAP for an update. The tree of a non-persistent heap is taken over, so that nodes linked from
+// nothing else are updated in place.
+static struct tree *_take_root(mmzk_heap_t *heap) {
+  if (heap->is_persistent) {
+    _share_tree(heap->root);
+  }
+
+  return heap->root;
+}
+
+// Release the header of HEAP after _take_root() if it is not persistent.
+static void _drop_header(mmzk_heap_t *heap) {
+  if (!heap->is_persistent) {
+    free(heap);
+  }
+}
+
+
+/* Construction & Destruction */
+
+mmzk_heap_t *mmzk_heap_new(mmzk_funs_t funs, comparator_t *cmp) {
+  mmzk_heap_t *heap = malloc(sizeof(mmzk_heap_t));
+  INIT_HEAP(funs, cmp, true, heap);
+
+  return heap;
+}
+
+mmzk_heap_t *mmzk_heap_from_list(mmzk_funs_t funs, comparator_t *cmp, mmzk_list_t *list) {
+  mmzk_heap_t *heap = mmzk_heap_new(funs, cmp);
+  struct tree_stack stack;
+  _stack_init(&stack);
+
+  mmzk_list_iterator_t iter = mmzk_list_iterator(list);
+  while (mmzk_list_has_next(iter)) {
+    _stack_push(&stack, _node((funs.copy_fun)(mmzk_list_yield(&iter)), NULL));
+  }
+  heap->size = stack.count;
+
+  // Meld in rounds of pairs, which halves the number of trees each round and takes O(n) in total.
+  while (stack.count > 1) {
+    size_t count = 0;
+    for (size_t i = 0; i < stack.count; i += 2) {
+      struct tree *pair = i + 1 < stack.count ? stack.trees[i + 1] : NULL;
+      stack.trees[count++] = _meld(heap, stack.trees[i], pair);
+    }
+    stack.count = count;
+  }
+  heap->root = stack.count == 0 ? NULL : stack.trees[0];
+
+  free(stack.trees);
+
+  return heap;
+}
+
+void mmzk_heap_free(mmzk_heap_t *heap) {
+  _free_tree(heap->funs, heap->root);
+  free(heap);
+}
+
+mmzk_heap_t *mmzk_heap_copy(mmzk_heap_t *heap) {
+  _share_tree(heap->root);
+  return _derive(heap, heap->is_persistent, heap->root, heap->size);
+}
+
+void mmzk_heap_set_persistence(mmzk_heap_t *heap, bool persistence) {
+  heap->is_persistent = persistence;
+}
+
+mmzk_list_t *mmzk_heap_to_list(mmzk_heap_t *heap) {
+  mmzk_list_builder_t *builder = mmzk_list_builder_new(heap->funs);
+  mmzk_heap_t *cur = mmzk_heap_copy(heap);
+  mmzk_heap_set_persistence(cur, false);
+
+  while (cur->root != NULL) {
+    mmzk_list_builder_append(builder, cur->root->elem);
+    cur = mmzk_heap_delete_min(cur);
+  }
+  mmzk_heap_free(cur);
+
+  if (!heap->is_persistent) {
+    mmzk_heap_free(heap);
+  }
+
+  return mmzk_list_builder_freeze(builder);
+}
+
+
+/* Query */
+
+size_t mmzk_heap_size(mmzk_heap_t *heap) {
+  return heap->size;
+}
+
+bool mmzk_heap_find_min(mmzk_heap_t *heap, void **result) {
+  if (heap->root == NULL) {
+    return false;
+  }
+
+  if (result != NULL) {
+    *result = (heap->funs.copy_fun)(heap->root->elem);
+  }
+
+  return true;
+}
+
+
+/* Update */
+
+mmzk_heap_t *mmzk_heap_insert(const void *element, mmzk_heap_t *heap) {
+  struct tree *root = _meld(heap, _take_root(heap), _node((heap->funs.copy_fun)(element), NULL));
+  mmzk_heap_t *result = _derive(heap, heap->is_persistent, root, heap->size + 1);
+  _drop_header(heap);
+
+  return result;
+}
+
+mmzk_heap_t *mmzk_heap_meld(mmzk_heap_t *heap1, mmzk_heap_t *heap2) {
+  struct tree *root = _meld(heap1, _take_root(heap1), _take_root(heap2));
+  mmzk_heap_t *result = _derive(heap1, heap1->is_persistent || heap2->is_persistent, root, heap1->size + heap2->size);
+  _drop_header(heap1);
+  _drop_header(heap2);
+
+  return result;
+}
+
+mmzk_heap_t *mmzk_heap_delete_min(mmzk_heap_t *heap) {
+  struct tree *root = _take_root(heap);
+  if (root == NULL) {
+    mmzk_heap_t *result = _derive(heap, heap->is_persistent, NULL, 0);
+    _drop_header(heap);
+    return result;
+  }
+
+  // Detach the children of the root, copying those that other versions link to.
+  struct tree_stack stack;
+  struct tree *child = root->child;
+  _stack_init(&stack);
+  _share_tree(child);
+  _free_tree(heap->funs, root);
+  while (child != NULL) {
+    struct tree *sibling;
+    struct tree *tree = _own(heap->funs, child, &sibling);
+    tree->sibling = NULL;
+    _stack_push(&stack, tree);
+    child = sibling;
+  }
+
+  mmzk_heap_t *result = _derive(heap, heap->is_persistent, _meld_pairs(heap, &stack), heap->size - 1);
+  free(stack.trees);
+  _drop_header(heap);
+
+  return result;
+}
@@ -0,0 +1,82 @@
+#ifndef MMZK1526
+#define MMZK1526
+#endif /* MMZK1526 */
+
+#ifndef MMZK_HEAP_H
+#define MMZK_HEAP_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "mmzklist.h"
+
+// A persistent min-heap, implemented as a pairing heap.
+//
+// Elements are ordered by a comparator and managed by FUNS (see mmzk_funs_t); the minimum is the first element for
+// which the comparator returns a non-positive result against all others. Updates copy at most a few nodes and share
+// the rest with the original version, so old versions stay valid and snapshots are O(1).
+//
+// The bound of mmzk_heap_delete_min() is amortised over a single history of updates. Deleting the minimum of the same
+// old version again and again repeats its work each time, which can cost O(n) per call in the worst case.
+//
+// The persistence protocol is the same as that of mmzk_list_t.
+typedef struct mmzk_heap mmzk_heap_t;
+
+
+/* Construction & Destruction */
+
+// New empty heap ordered by CMP.
+// O(1).
+mmzk_heap_t *mmzk_heap_new(mmzk_funs_t funs, comparator_t *cmp);
+
+// Make heap of the elements of LIST ordered by CMP. The elements are managed by FUNS.
+// This function never deallocates LIST, regardless of its persistence state.
+// O(n).
+mmzk_heap_t *mmzk_heap_from_list(mmzk_funs_t funs, comparator_t *cmp, mmzk_list_t *list);
+
+// Free the heap.
+void mmzk_heap_free(mmzk_heap_t *heap);
+
+// Construct an identical heap from HEAP.
+// This function never deallocates HEAP, regardless of its persistence state.
+// O(1).
+mmzk_heap_t *mmzk_heap_copy(mmzk_heap_t *heap);
+
+// If PERSISTENCE is TRUE (by default), then passing HEAP to another function in this module does not modify itself.
+// Otherwise, HEAP will be deallocated when used as an argument to a function (unless specified otherwise).
+void mmzk_heap_set_persistence(mmzk_heap_t *heap, bool persistence);
+
+// Turn HEAP into a list of its elements in ascending order.
+// O(n log n).
+mmzk_list_t *mmzk_heap_to_list(mmzk_heap_t *heap);
+
+
+/* Query */
+
+// The number of elements in HEAP.
+// O(1).
+size_t mmzk_heap_size(mmzk_heap_t *heap);
+
+// Store a copy of the minimum of HEAP in RESULT (if not NULL). Returns false (leaving RESULT untouched) if HEAP is
+// empty.
+// This function never deallocates HEAP, regardless of its persistence state.
+// O(1).
+bool mmzk_heap_find_min(mmzk_heap_t *heap, void **result);
+
+
+/* Update */
+
+// Construct a heap by adding ELEMENT to HEAP. ELEMENT is copied.
+// O(1).
+mmzk_heap_t *mmzk_heap_insert(const void *element, mmzk_heap_t *heap);
+
+// Construct a heap of the elements of both HEAP1 and HEAP2, which must have the same functions and comparator.
+// The result is persistent if either heap is.
+// O(1).
+mmzk_heap_t *mmzk_heap_meld(mmzk_heap_t *heap1, mmzk_heap_t *heap2);
+
+// Construct a heap by removing the minimum of HEAP. The result is empty if HEAP is.
+// O(log n) amortised.
+mmzk_heap_t *mmzk_heap_delete_min(mmzk_heap_t *heap);
+
+#endif /* MMZK_HEAP_H */
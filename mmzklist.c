@@ -1,7 +1,10 @@
 #include <assert.h>
 #include <iso646.h>
 #include <math.h>
+#include <pthread.h>
+#include <stdatomic.h>
 #include <stdbool.h>
+#include <stddef.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -10,437 +13,2324 @@
 
 /* Definitions */
 
+#ifdef MMZK_COMPACT_NODES
+
+// In the compact mode, nodes live in pooled blocks and NEXT is the index of the next node (see _node_at()), 0 for NULL.
+struct node {
+  unsigned int prev_count;
+  uint32_t next;
+  const void *elem;
+};
+
+// A block of the node pool, aligned to its size so that it can be found from any of its nodes. ID is its position in
+// the pool table. Blocks are never returned to the system; freed nodes are kept in free lists for reuse.
+// A block that belongs to a region is not on any free list, and NEXT is the ID of the previous block of its arena.
+struct pool_block {
+  uint32_t id;
+  uint32_t next;
+  struct node nodes[];
+};
+
+// The free nodes cached by a thread, linked through NEXT.
+struct node_cache {
+  uint32_t head;
+  size_t count;
+};
+
+#else
+
 struct node {
   unsigned int prev_count;
+  uint32_t slot;
   const void *elem;
   struct node *next;
 };
 
+// Nodes that are allocated together. SLOT of each node is its index in NODES, so that the block can be found from the
+// node. The block is freed when all of its LIVE nodes are.
+struct node_block {
+  size_t live;
+  struct node nodes[];
+};
+
+#endif /* MMZK_COMPACT_NODES */
+
+struct mmzk_pair {
+  size_t ref_count;
+  const void *fst;
+  const void *snd;
+  mmzk_funs_t fst_funs;
+  mmzk_funs_t snd_funs;
+};
+
+struct mmzk_list_builder {
+  mmzk_funs_t funs;
+  mmzk_region_t *region;
+  struct region_arena *arena;
+  struct node *head;
+  struct node *last;
+  size_t length;
+  struct node *spare;
+  size_t spare_count;
+  size_t batch;
+  size_t max_batch;
+  size_t hint;
+};
+
+// A snapshot of an atomic reference (IS_SNAPSHOT) borrows its nodes from the cell, and never gets a hash or skip index.
 struct mmzk_list {
   bool is_persistent;
+  bool is_snapshot;
   mmzk_funs_t funs;
+  mmzk_region_t *region;
   struct node *node;
   size_t length;
+  size_t reach;
+  struct list_index *_Atomic index;
+  atomic_uint queries;
+  struct skip_index *_Atomic skip;
+  atomic_uint seeks;
+};
+
+// A slot of the hash index; POS is SIZE_MAX if the slot is empty.
+struct index_entry {
+  size_t hash;
+  size_t pos;
+  const void *elem;
+};
+
+// Hash index of the first LENGTH elements of the chain starting at HEAD, keeping the first occurrence of each distinct
+// element. It is shared through a global registry by the lists starting at HEAD that are no longer than LENGTH, and is
+// freed when the last list referring to it is freed.
+struct list_index {
+  struct node *head;
+  size_t length;
+  size_t ref_count;
+  size_t capacity;
+  struct index_entry *entries;
+  struct list_index *next;
+};
+
+// Skip index of the chain starting at HEAD: NODES[J] is the node at position J * SKIP_STRIDE, for the first COUNT
+// multiples of the stride within LENGTH. It is shared and freed in the same way as struct list_index, so it covers
+// every list that uses it.
+struct skip_index {
+  struct node *head;
+  size_t length;
+  size_t ref_count;
+  size_t count;
+  struct skip_index *next;
+  struct node *nodes[];
+};
+
+// A chunk of memory of a region, handed out from the front.
+struct region_chunk {
+  struct region_chunk *next;
+  size_t capacity;
+  size_t used;
+  max_align_t data[];
+};
+
+// The nodes of a region whose elements are freed by FREE_FUN. Keeping them apart lets the region free the elements
+// without knowing which list each node belongs to.
+struct region_arena {
+  mmzk_free_fun *free_fun;
+  struct region_arena *next;
+#ifdef MMZK_COMPACT_NODES
+  struct pool_block *block;
+  size_t used;
+#else
+  struct region_chunk *chunks;
+#endif /* MMZK_COMPACT_NODES */
+};
+
+// Lists in a region keep their headers in CHUNKS and their nodes in ARENAS. INDEXED holds the lists that have a hash or
+// skip index, which is released when the region is destroyed.
+struct mmzk_region {
+  struct region_chunk *chunks;
+  struct region_arena *arenas;
+  mmzk_list_t **indexed;
+  size_t indexed_count;
+  size_t indexed_capacity;
 };
 
 
 /* Helpers */
 
+#ifdef MMZK_COMPACT_NODES
+
+// log2 of the number of node-sized slots in a pool block; the first slot holds the header of the block.
+#define POOL_SHIFT 12
+#define POOL_BLOCK_BYTES (sizeof(struct node) << POOL_SHIFT)
+#define POOL_BLOCK_NODES ((POOL_BLOCK_BYTES - offsetof(struct pool_block, nodes)) / sizeof(struct node))
+
+// The number of blocks that 32-bit node indices can address.
+#define POOL_MAX_BLOCKS ((size_t)1 << (32 - POOL_SHIFT))
+
+#define NEXT(NODE) _node_at((NODE)->next)
+#define SET_NEXT(NODE, NEXT_NODE) ((NODE)->next = _node_index(NEXT_NODE))
+
+#else
+
+// The SLOT of a node that is allocated on its own rather than in a block.
+#define STANDALONE UINT32_MAX
+
+#define NEXT(NODE) ((NODE)->next)
+#define SET_NEXT(NODE, NEXT_NODE) ((NODE)->next = (NEXT_NODE))
+
+#endif /* MMZK_COMPACT_NODES */
+
+// The maximum number of nodes allocated at once.
+#define NODE_BATCH 64
+
+// The number of nodes allocated at once when compacting a list.
+#define COMPACT_BATCH 4096
+
+// The minimum number of nodes worth handing to a separate thread.
+#define PARALLEL_GRAIN 4096
+
+// Lists shorter than this are always searched linearly.
+#define INDEX_MIN_LENGTH 32
+
+// The number of membership queries on a list after which its hash index is built.
+#define INDEX_QUERY_THRESHOLD 4
+
+// The number of buckets in the registry of hash indices.
+#define INDEX_BUCKETS 256
+
+// Lists shorter than this are always walked from the head for positional access.
+#define SKIP_MIN_LENGTH 64
+
+// log2 of the distance between the nodes recorded in a skip index.
+#define SKIP_SHIFT 4
+#define SKIP_STRIDE ((size_t)1 << SKIP_SHIFT)
+
+// The size of the first chunk of a region, and the size the following chunks double up to.
+#define REGION_CHUNK_BYTES 4096
+#define REGION_MAX_CHUNK_BYTES 65536
+
+// REACH of a list whose chain ends with its window.
+#define EXACT_REACH 0
+
+// Upper bound of the run stack of the merge sort; enough for 2^64 nodes (see _sort_nodes()).
+#define MAX_RUNS 96
+
+// The number of elements gathered at a time by block traversals (see _gather()).
+#define GATHER_BLOCK 64
+
+#if defined(__GNUC__) || defined(__clang__)
+#define PREFETCH(ADDR) __builtin_prefetch(ADDR)
+#else
+#define PREFETCH(ADDR) ((void)(ADDR))
+#endif
+
 #define INIT_LIST(FUNS, PERSISTENCE, LIST) do {\
   LIST->funs = FUNS;\
   LIST->node = NULL;\
   LIST->is_persistent = PERSISTENCE;\
+  LIST->is_snapshot = false;\
   LIST->length = 0;\
+  LIST->reach = EXACT_REACH;\
+  atomic_init(&LIST->index, NULL);\
+  atomic_init(&LIST->queries, 0);\
+  atomic_init(&LIST->skip, NULL);\
+  atomic_init(&LIST->seeks, 0);\
 } while (false)
 
-static void *_fold(size_t len, void *(*worker)(const void *, void *), void *accum, struct node *node) {
-  if (len == 0) {
-    return accum;
+static struct list_index *index_registry[INDEX_BUCKETS];
+static struct skip_index *skip_registry[INDEX_BUCKETS];
+static pthread_mutex_t index_lock = PTHREAD_MUTEX_INITIALIZER;
+static size_t trim_ratio = 0;
+
+#ifdef MMZK_COMPACT_NODES
+
+// The pool table; block 0 is never allocated so that index 0 stands for NULL.
+static struct pool_block *pool_blocks[POOL_MAX_BLOCKS];
+static uint32_t pool_block_count = 1;
+// Free nodes shared by all threads; each thread takes and returns them in batches of POOL_BLOCK_NODES.
+static struct node_cache pool_free;
+static pthread_mutex_t pool_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_once_t pool_once = PTHREAD_ONCE_INIT;
+static pthread_key_t pool_key;
+static _Thread_local struct node_cache local_free;
+static _Thread_local bool is_local_free_watched;
+
+// The node with the given INDEX, NULL if it is 0.
+static inline struct node *_node_at(uint32_t index) {
+  if (index == 0) {
+    return NULL;
   }
 
-  return worker(node->elem, _fold(len - 1, worker, accum, node->next));
+  return &pool_blocks[index >> POOL_SHIFT]->nodes[index & (((uint32_t)1 << POOL_SHIFT) - 1)];
 }
 
+// The index of NODE, 0 if it is NULL.
+static inline uint32_t _node_index(const struct node *node) {
+  if (node == NULL) {
+    return 0;
+  }
 
-/* Construction & Destruction */
+  struct pool_block *block = (struct pool_block *)((uintptr_t)node & ~(uintptr_t)(POOL_BLOCK_BYTES - 1));
+  return block->id << POOL_SHIFT | (uint32_t)(node - block->nodes);
+}
 
-mmzk_list_t *mmzk_list_new(mmzk_funs_t funs) {
-  mmzk_list_t *list = malloc(sizeof(mmzk_list_t));
-  INIT_LIST(funs, true, list);
+#endif /* MMZK_COMPACT_NODES */
 
-  return list;
+// Scramble the bits of HASH so that poor user hashes (e.g. the identity on integers) still spread over the table.
+static size_t _mix_hash(size_t hash) {
+  uint64_t h = (uint64_t)hash * UINT64_C(0x9E3779B97F4A7C15);
+  return (size_t)(h ^ (h >> 29));
 }
 
-mmzk_list_t *mmzk_list_from_array(mmzk_funs_t funs, size_t len, void *elems[]) {
-  mmzk_list_t *list = malloc(sizeof(mmzk_list_t));
-  INIT_LIST(funs, true, list);
-  list->length = len;
+// Find the position of the first occurrence of ELEMENT recorded in INDEX, SIZE_MAX if there is none.
+static size_t _index_find(struct list_index *index, mmzk_funs_t funs, const void *element) {
+  size_t hash = (funs.hash_fun)(element);
+  size_t mask = index->capacity - 1;
 
-  for (size_t i = len; i > 0; i--) {
-    struct node *node = malloc(sizeof(struct node));
-    node->elem = (list->funs.copy_fun)(elems[i - 1]);
-    node->next = list->node;
-    node->prev_count = 0;
-    list->node = node;
+  for (size_t i = _mix_hash(hash) & mask; index->entries[i].pos != SIZE_MAX; i = (i + 1) & mask) {
+    if (index->entries[i].hash == hash && (funs.eq_fun)(element, index->entries[i].elem)) {
+      return index->entries[i].pos;
+    }
   }
 
-  return list;
+  return SIZE_MAX;
 }
 
-void **mmzk_list_to_array(mmzk_list_t *list, mmzk_funs_t *funs, size_t *len) {
-  void **result = malloc(list->length * sizeof(void *));
-  struct node *node = list->node;
-
-  for (size_t i = 0; i < list->length; (node = node->next, i++)) {
-    result[i] = (list->funs.copy_fun)(node->elem);
+// Build the hash index of the first LEN elements of the chain starting at HEAD.
+static struct list_index *_build_index(mmzk_funs_t funs, struct node *head, size_t len) {
+  struct list_index *index = malloc(sizeof(struct list_index));
+  index->head = head;
+  index->length = len;
+  index->ref_count = 0;
+  index->capacity = 1;
+  while (index->capacity < 2 * len) {
+    index->capacity <<= 1;
   }
-
-  if (funs != NULL) {
-    *funs = list->funs;
+  index->entries = malloc(index->capacity * sizeof(struct index_entry));
+  for (size_t i = 0; i < index->capacity; i++) {
+    index->entries[i].pos = SIZE_MAX;
   }
 
-  if (len != NULL) {
-    *len = list->length;
+  size_t mask = index->capacity - 1;
+  struct node *node = head;
+  for (size_t pos = 0; pos < len; (node = NEXT(node), pos++)) {
+    size_t hash = (funs.hash_fun)(node->elem);
+    size_t i = _mix_hash(hash) & mask;
+    while (index->entries[i].pos != SIZE_MAX
+        && !(index->entries[i].hash == hash && (funs.eq_fun)(node->elem, index->entries[i].elem))) {
+      i = (i + 1) & mask;
+    }
+    if (index->entries[i].pos == SIZE_MAX) {
+      index->entries[i] = (struct index_entry) { .hash = hash, .pos = pos, .elem = node->elem };
+    }
   }
 
-  if (!list->is_persistent) {
-    mmzk_list_free(list);
+  return index;
+}
+
+// Remember that LIST, which is about to get a hash or skip index, needs it released when its region is destroyed.
+static void _region_track(mmzk_list_t *list) {
+  mmzk_region_t *region = list->region;
+  if (region == NULL || list->index != NULL || list->skip != NULL) {
+    return;
   }
 
-  return result;
+  if (region->indexed_count == region->indexed_capacity) {
+    region->indexed_capacity = region->indexed_capacity == 0 ? 8 : 2 * region->indexed_capacity;
+    region->indexed = realloc(region->indexed, region->indexed_capacity * sizeof(mmzk_list_t *));
+  }
+  region->indexed[region->indexed_count++] = list;
 }
 
-void mmzk_list_free(mmzk_list_t *list) {
-  struct node *node = list->node;
-
-  if (node != NULL) {
-    while (node != NULL) {
-      if (node->prev_count > 0) {
-        node->prev_count--;
-        break;
-      }
-      struct node *temp = node;
-      node = node->next;
-      (list->funs.free_fun)((void *)(temp->elem));
-      free(temp);
+// Drop the reference to INDEX from a list, freeing it if no list refers to it.
+static void _release_index(struct list_index *index) {
+  pthread_mutex_lock(&index_lock);
+  if (--index->ref_count == 0) {
+    struct list_index **slot = &index_registry[_mix_hash((size_t)(uintptr_t)index->head) % INDEX_BUCKETS];
+    while (*slot != index) {
+      slot = &(*slot)->next;
     }
+    *slot = index->next;
+    free(index->entries);
+    free(index);
   }
+  pthread_mutex_unlock(&index_lock);
+}
 
-  free(list);
+// The registered hash index that covers LIST, with a new reference to it. If there is none, BUILT is registered in its
+// place unless it is NULL. The registry must be locked.
+static struct list_index *_adopt_index(mmzk_list_t *list, struct list_index *built) {
+  size_t bucket = _mix_hash((size_t)(uintptr_t)list->node) % INDEX_BUCKETS;
+  struct list_index *index = index_registry[bucket];
+  while (index != NULL && (index->head != list->node || index->length < list->length)) {
+    index = index->next;
+  }
+  // An index built for a shorter list with the same head does not cover LIST, so a new one is registered alongside it.
+  if (index == NULL && built != NULL) {
+    index = built;
+    index->next = index_registry[bucket];
+    index_registry[bucket] = index;
+  }
+  if (index != NULL) {
+    index->ref_count++;
+  }
+
+  return index;
 }
 
-mmzk_list_t *mmzk_list_copy(mmzk_list_t *list) {
-  mmzk_list_t *result = malloc(sizeof(mmzk_list_t));
-  result->funs = list->funs;
-  result->length = list->length;
-  result->node = list->node;
-  result->is_persistent = list->is_persistent;
+// Get the hash index of LIST, building it if LIST is queried often enough.
+// NULL if LIST has no hash function or is a snapshot, or if it is not worth indexing (yet).
+// The same list may be queried from several threads at once: the index is published with a CAS, and a thread that
+// loses the race drops its reference and uses the published one.
+static struct list_index *_get_index(mmzk_list_t *list) {
+  struct list_index *index = atomic_load_explicit(&list->index, memory_order_acquire);
+  if (index != NULL) {
+    return index;
+  }
 
-  if (list->node != NULL) {
-    list->node->prev_count++;
+  if (list->is_snapshot || list->funs.hash_fun == NULL || list->length < INDEX_MIN_LENGTH
+      || atomic_fetch_add_explicit(&list->queries, 1, memory_order_relaxed) + 1 < INDEX_QUERY_THRESHOLD) {
+    return NULL;
   }
 
-  return result;
-}
+  pthread_mutex_lock(&index_lock);
+  index = _adopt_index(list, NULL);
+  pthread_mutex_unlock(&index_lock);
+
+  // The index is built outside the lock: building is O(n) and calls the functions of LIST, which may query other
+  // indexed lists. Another thread may have registered an equal index meanwhile, in which case that one is adopted.
+  if (index == NULL) {
+    struct list_index *built = _build_index(list->funs, list->node, list->length);
+    pthread_mutex_lock(&index_lock);
+    index = _adopt_index(list, built);
+    pthread_mutex_unlock(&index_lock);
+    if (index != built) {
+      free(built->entries);
+      free(built);
+    }
+  }
 
-void mmzk_list_set_persistence(mmzk_list_t *list, bool persistence) {
-  list->is_persistent = persistence;
+  _region_track(list);
+  struct list_index *published = NULL;
+  if (!atomic_compare_exchange_strong_explicit(&list->index, &published, index, memory_order_acq_rel,
+      memory_order_acquire)) {
+    _release_index(index);
+    return published;
+  }
+  return index;
 }
 
+// Drop the reference to SKIP from a list, freeing it if no list refers to it.
+static void _release_skip(struct skip_index *skip) {
+  pthread_mutex_lock(&index_lock);
+  if (--skip->ref_count == 0) {
+    struct skip_index **slot = &skip_registry[_mix_hash((size_t)(uintptr_t)skip->head) % INDEX_BUCKETS];
+    while (*slot != skip) {
+      slot = &(*slot)->next;
+    }
+    *slot = skip->next;
+    free(skip);
+  }
+  pthread_mutex_unlock(&index_lock);
+}
 
-/* Query */
+// The registered skip index that covers LIST, with a new reference to it. If there is none, BUILT is registered in its
+// place unless it is NULL. The registry must be locked.
+static struct skip_index *_adopt_skip(mmzk_list_t *list, struct skip_index *built) {
+  size_t bucket = _mix_hash((size_t)(uintptr_t)list->node) % INDEX_BUCKETS;
+  struct skip_index *skip = skip_registry[bucket];
+  while (skip != NULL && (skip->head != list->node || skip->length < list->length)) {
+    skip = skip->next;
+  }
+  // As with hash indices, a skip index built for a shorter list is left to the lists already using it.
+  if (skip == NULL && built != NULL) {
+    skip = built;
+    skip->next = skip_registry[bucket];
+    skip_registry[bucket] = skip;
+  }
+  if (skip != NULL) {
+    skip->ref_count++;
+  }
 
-size_t mmzk_list_length(mmzk_list_t *list) {
-  return list->length;
+  return skip;
 }
 
-void *mmzk_list_get(mmzk_list_t *list, size_t index) {
-  struct node *node = list->node;
+// Get the skip index of LIST, building it if LIST is accessed by position often enough.
+// NULL if LIST is a snapshot or is not persistent (and thus about to be consumed), or if it is not worth indexing
+// (yet).
+// As with _get_index(), the index is built outside the lock and published with a CAS. Until then, each call costs a
+// relaxed atomic increment of SEEKS.
+static struct skip_index *_get_skip(mmzk_list_t *list) {
+  struct skip_index *skip = atomic_load_explicit(&list->skip, memory_order_acquire);
+  if (skip != NULL) {
+    return skip;
+  }
 
-  if (index >= list->length) {
+  if (!list->is_persistent || list->is_snapshot || list->length < SKIP_MIN_LENGTH
+      || atomic_fetch_add_explicit(&list->seeks, 1, memory_order_relaxed) + 1 < INDEX_QUERY_THRESHOLD) {
     return NULL;
   }
 
-  while (node != NULL) {
-    if (index == 0) {
-      return (list->funs.copy_fun)(node->elem);
+  pthread_mutex_lock(&index_lock);
+  skip = _adopt_skip(list, NULL);
+  pthread_mutex_unlock(&index_lock);
+
+  if (skip == NULL) {
+    size_t count = (list->length + SKIP_STRIDE - 1) >> SKIP_SHIFT;
+    struct skip_index *built = malloc(sizeof(struct skip_index) + count * sizeof(struct node *));
+    built->head = list->node;
+    built->length = list->length;
+    built->ref_count = 0;
+    built->count = count;
+    struct node *node = list->node;
+    for (size_t pos = 0; pos < list->length; (node = NEXT(node), pos++)) {
+      if ((pos & (SKIP_STRIDE - 1)) == 0) {
+        built->nodes[pos >> SKIP_SHIFT] = node;
+      }
+    }
+    pthread_mutex_lock(&index_lock);
+    skip = _adopt_skip(list, built);
+    pthread_mutex_unlock(&index_lock);
+    if (skip != built) {
+      free(built);
     }
-    index--;
-    node = node->next;
   }
 
-  return UNREACHABLE(NULL);
+  _region_track(list);
+  struct skip_index *published = NULL;
+  if (!atomic_compare_exchange_strong_explicit(&list->skip, &published, skip, memory_order_acq_rel,
+      memory_order_acquire)) {
+    _release_skip(skip);
+    return published;
+  }
+  return skip;
 }
 
-void *mmzk_list_get_end(mmzk_list_t *list, size_t index) {
-  struct node *slow = list->node;
-  struct node *fast = list->node;
-  index++;
+// The node at position I of LIST, which must be within its length. Uses the skip index of LIST if there is one.
+static struct node *_seek(mmzk_list_t *list, size_t i) {
+  struct skip_index *skip = _get_skip(list);
+  struct node *node = list->node;
 
-  if (index >= list->length) {
-    return NULL;
+  if (skip != NULL) {
+    node = skip->nodes[i >> SKIP_SHIFT];
+    i &= SKIP_STRIDE - 1;
   }
 
-  while (fast != NULL) {
-    if (index == 0) {
-      break;
-    }
-    index--;
-    fast = fast->next;
+  while (i != 0) {
+    node = NEXT(node);
+    i--;
   }
 
-  while (fast != NULL) {
-    fast = fast->next;
-    slow = slow->next;
+  return node;
+}
+
+#ifdef MMZK_COMPACT_NODES
+
+// Move the first COUNT nodes of the free list FROM to the front of TO.
+static void _move_free_nodes(struct node_cache *from, struct node_cache *to, size_t count) {
+  uint32_t head = from->head;
+  struct node *last = _node_at(head);
+  for (size_t i = 1; i < count; i++) {
+    last = NEXT(last);
   }
 
-  return (list->funs.copy_fun)(slow->elem);
+  from->head = last->next;
+  from->count -= count;
+  last->next = to->head;
+  to->head = head;
+  to->count += count;
 }
 
-bool mmzk_list_is_elem(const void *element, mmzk_list_t *list) {
-  struct node *node = list->node;
-  while (node != NULL) {
-    if ((list->funs.eq_fun)(element, node->elem)) {
-      return true;
-    }
-    node = node->next;
+// Return the free nodes of an exiting thread to the pool.
+static void _release_local_free(void *cache) {
+  pthread_mutex_lock(&pool_lock);
+  if (((struct node_cache *)cache)->count > 0) {
+    _move_free_nodes(cache, &pool_free, ((struct node_cache *)cache)->count);
   }
+  pthread_mutex_unlock(&pool_lock);
+}
 
-  return false;
+static void _init_pool(void) {
+  pthread_key_create(&pool_key, _release_local_free);
 }
 
-bool mmzk_list_equal(mmzk_list_t *list1, mmzk_list_t *list2) {
-  if (list1->length != list2->length) {
-    return false;
+// Make sure that the free nodes of this thread go back to the pool when it exits.
+static void _watch_local_free(void) {
+  if (!is_local_free_watched) {
+    pthread_once(&pool_once, _init_pool);
+    pthread_setspecific(pool_key, &local_free);
+    is_local_free_watched = true;
   }
+}
 
-  struct node *node1 = list1->node;
-  struct node *node2 = list2->node;
-
-  while (node1 != NULL) {
-    assert(node2 != NULL);
+// Add a new block to the pool table. The caller must hold POOL_LOCK.
+static struct pool_block *_new_pool_block(void) {
+  assert(pool_block_count < POOL_MAX_BLOCKS);
+  struct pool_block *block = aligned_alloc(POOL_BLOCK_BYTES, POOL_BLOCK_BYTES);
+  block->id = pool_block_count;
+  block->next = 0;
+  pool_blocks[pool_block_count++] = block;
 
-    if (!(list1->funs.eq_fun)(node1->elem, node2->elem)) {
-      return false;
-    }
+  return block;
+}
 
-    node1 = node1->next;
-    node2 = node2->next;
+// Put all nodes of BLOCK on the free list CACHE.
+// They are linked in address order, so that fresh nodes are handed out contiguously.
+static void _free_pool_block(struct pool_block *block, struct node_cache *cache) {
+  uint32_t base = block->id << POOL_SHIFT;
+  for (uint32_t i = 0; i < POOL_BLOCK_NODES; i++) {
+    block->nodes[i].next = i + 1 < POOL_BLOCK_NODES ? base | (i + 1) : cache->head;
   }
-
-  return true;
+  cache->head = base;
+  cache->count += POOL_BLOCK_NODES;
 }
 
+// Fill the free list of this thread from the shared one, or from a new block if there are no shared free nodes.
+static void _refill_local_free(void) {
+  _watch_local_free();
 
-/* Composition */
+  pthread_mutex_lock(&pool_lock);
+  if (pool_free.count > 0) {
+    _move_free_nodes(&pool_free, &local_free, pool_free.count < POOL_BLOCK_NODES ? pool_free.count : POOL_BLOCK_NODES);
+  } else {
+    _free_pool_block(_new_pool_block(), &local_free);
+  }
+  pthread_mutex_unlock(&pool_lock);
+}
 
-mmzk_list_t *mmzk_list_cons(const void *elem, mmzk_list_t *list) {
-  mmzk_list_t *result = malloc(sizeof(mmzk_list_t));
-  result->funs = list->funs;
-  result->length = list->length + 1;
-  result->is_persistent = list->is_persistent;
-  struct node *node = malloc(sizeof(struct node));
-  node->elem = (list->funs.copy_fun)(elem);
-  node->next = list->node;
+// Take a node from the free list of this thread.
+static struct node *_new_node(void) {
+  if (local_free.count == 0) {
+    _refill_local_free();
+  }
+
+  struct node *node = _node_at(local_free.head);
+  local_free.head = node->next;
+  local_free.count--;
   node->prev_count = 0;
-  result->node = node;
 
-  if (!list->is_persistent) {
-    free(list);
-  } else if (list->node != NULL) {
-    list->node->prev_count++;
+  return node;
+}
+
+// Put NODE on the free list of this thread, handing a batch to the shared list if it grows too long.
+static void _delete_node(struct node *node) {
+  if (local_free.count == 0) {
+    _watch_local_free();
   }
 
-  return result;
+  node->next = local_free.head;
+  local_free.head = _node_index(node);
+  if (++local_free.count >= 2 * POOL_BLOCK_NODES) {
+    pthread_mutex_lock(&pool_lock);
+    _move_free_nodes(&local_free, &pool_free, POOL_BLOCK_NODES);
+    pthread_mutex_unlock(&pool_lock);
+  }
 }
 
-mmzk_list_t *mmzk_list_concat(mmzk_list_t *list1, mmzk_list_t *list2) {
-  struct node *node1 = list1->node;
-  struct node *node2 = list2->node;
+#else
 
-  mmzk_list_t *result = malloc(sizeof(mmzk_list_t));
-  result->is_persistent = list1->is_persistent || list2->is_persistent;
-  result->funs = list1->funs;
-  result->length = list1->length + list2->length;
+// Allocate a node on its own.
+static struct node *_new_node(void) {
+  struct node *node = malloc(sizeof(struct node));
+  node->prev_count = 0;
+  node->slot = STANDALONE;
 
-  if (!list2->is_persistent) {
-    free(list2);
-  } else if (list2->node != NULL) {
-    list2->node->prev_count++;
-  }
+  return node;
+}
 
-  if (node1 == NULL) {
-    result->node = node2;
-  } else {
-    struct node *node = malloc(sizeof(struct node));
-    result->node = node;
-    node->elem = (list1->funs.copy_fun)(node1->elem);
-    node->prev_count = 0;
-    struct node *cur = node;
-    node1 = node1->next;
-    while (node1 != NULL) {
-      node = malloc(sizeof(struct node));
-      node->elem = (list1->funs.copy_fun)(node1->elem);
-      node->prev_count = 0;
-      cur->next = node;
-      cur = cur->next;
-      node1 = node1->next;
-    }
-    cur->next = node2;
+// Allocate LEN contiguous nodes in a block.
+static struct node *_new_nodes(size_t len) {
+  if (len == 1) {
+    return _new_node();
   }
 
-  if (!list1->is_persistent) {
-    mmzk_list_free(list1);
+  struct node_block *block = malloc(sizeof(struct node_block) + len * sizeof(struct node));
+  block->live = len;
+  for (size_t i = 0; i < len; i++) {
+    block->nodes[i].prev_count = 0;
+    block->nodes[i].slot = (uint32_t)i;
   }
 
-  return result;
+  return block->nodes;
 }
 
-
-/* Decomposition */
-
-void *mmzk_list_tail(mmzk_list_t *list) {
-  if (list->length == 0) {
-    if (!list->is_persistent) {
-      mmzk_list_free(list);
-    }
-    return NULL;
+// Deallocate NODE; the block it lives in is freed with its last node.
+static void _delete_node(struct node *node) {
+  if (node->slot == STANDALONE) {
+    free(node);
+    return;
   }
 
-  struct node *node = list->node;
-
-  mmzk_list_t *result = malloc(sizeof(mmzk_list_t));
-  result->funs = list->funs;
-  result->length = list->length - 1;
-  result->is_persistent = list->is_persistent;
-  result->node = node->next;
-  if (result->node != NULL) {
-    result->node->prev_count++;
+  struct node_block *block = (struct node_block *)((char *)(node - node->slot) - offsetof(struct node_block, nodes));
+  if (--block->live == 0) {
+    free(block);
   }
+}
 
-  if (!list->is_persistent) {
-    mmzk_list_free(list);
+#endif /* MMZK_COMPACT_NODES */
+
+// Allocate SIZE bytes from the first of CHUNKS, adding a new chunk in front if it does not have enough room.
+static void *_chunk_alloc(struct region_chunk **chunks, size_t size) {
+  struct region_chunk *chunk = *chunks;
+  size = (size + sizeof(void *) - 1) & ~(sizeof(void *) - 1);
+
+  if (chunk == NULL || chunk->capacity - chunk->used < size) {
+    size_t capacity = chunk == NULL ? REGION_CHUNK_BYTES : 2 * chunk->capacity;
+    capacity = capacity < REGION_MAX_CHUNK_BYTES ? capacity : REGION_MAX_CHUNK_BYTES;
+    capacity = capacity > size ? capacity : size;
+    chunk = malloc(sizeof(struct region_chunk) + capacity);
+    chunk->next = *chunks;
+    chunk->capacity = capacity;
+    chunk->used = 0;
+    *chunks = chunk;
   }
 
+  void *result = (char *)chunk->data + chunk->used;
+  chunk->used += size;
+
   return result;
 }
 
-void *mmzk_list_init(mmzk_list_t *list) {
-  if (list->length == 0) {
-    if (!list->is_persistent) {
-      mmzk_list_free(list);
-    }
-    return NULL;
+// The arena of REGION for elements freed by FREE_FUN, created if there is none yet.
+static struct region_arena *_region_arena(mmzk_region_t *region, mmzk_free_fun *free_fun) {
+  struct region_arena *arena = region->arenas;
+  while (arena != NULL && arena->free_fun != free_fun) {
+    arena = arena->next;
   }
 
-  mmzk_list_t *result = malloc(sizeof(mmzk_list_t));
-  struct node *node = list->node;
-  result->is_persistent = list->is_persistent;
-  result->funs = list->funs;
-  result->length = list->length - 1;
-  if (list->is_persistent) {
-    node->prev_count++;
-  } else {
-    free(list);
+  if (arena == NULL) {
+    arena = _chunk_alloc(&region->chunks, sizeof(struct region_arena));
+    arena->free_fun = free_fun;
+    arena->next = region->arenas;
+#ifdef MMZK_COMPACT_NODES
+    arena->block = NULL;
+    arena->used = 0;
+#else
+    arena->chunks = NULL;
+#endif /* MMZK_COMPACT_NODES */
+    region->arenas = arena;
   }
-  result->node = node;
 
-  return result;
+  return arena;
 }
 
-void *mmzk_list_take(size_t i, mmzk_list_t *list) {
-  mmzk_list_t *result = malloc(sizeof(mmzk_list_t));
-  struct node *node = list->node;
-  result->funs = list->funs;
-  result->is_persistent = list->is_persistent;
-  result->length = list->length > i ? i : list->length;
-  result->node = node;
-
-  if (!list->is_persistent) {
-    free(list);
-  } else if (list->node != NULL) {
-    list->node->prev_count++;
+// Allocate a node in ARENA.
+static struct node *_arena_node(struct region_arena *arena) {
+#ifdef MMZK_COMPACT_NODES
+  if (arena->block == NULL || arena->used == POOL_BLOCK_NODES) {
+    pthread_mutex_lock(&pool_lock);
+    struct pool_block *block = _new_pool_block();
+    pthread_mutex_unlock(&pool_lock);
+    block->next = arena->block == NULL ? 0 : arena->block->id;
+    arena->block = block;
+    arena->used = 0;
   }
+  struct node *node = &arena->block->nodes[arena->used++];
+#else
+  struct node *node = _chunk_alloc(&arena->chunks, sizeof(struct node));
+#endif /* MMZK_COMPACT_NODES */
+  node->prev_count = 0;
 
-  return result;
+  return node;
 }
 
-void *mmzk_list_drop(size_t i, mmzk_list_t *list) {
-  mmzk_list_t *result = malloc(sizeof(mmzk_list_t));
-  INIT_LIST(list->funs, list->is_persistent, result);
-
-  if (i >= list->length) {
-    if (!list->is_persistent) {
-      mmzk_list_free(list);
+// Free the elements of all nodes in ARENA with its FREE_FUN.
+static void _arena_free_elems(struct region_arena *arena) {
+#ifdef MMZK_COMPACT_NODES
+  size_t used = arena->used;
+  struct pool_block *block = arena->block;
+  while (block != NULL) {
+    for (size_t i = 0; i < used; i++) {
+      (arena->free_fun)((void *)block->nodes[i].elem);
     }
-    return result;
+    used = POOL_BLOCK_NODES;
+    block = block->next == 0 ? NULL : pool_blocks[block->next];
   }
-
-  struct node *node = list->node;
-  result->length = list->length - i;
-  while (i != 0) {
-    node = node->next;
-    i--;
+#else
+  for (struct region_chunk *chunk = arena->chunks; chunk != NULL; chunk = chunk->next) {
+    struct node *nodes = (struct node *)chunk->data;
+    for (size_t i = 0; i < chunk->used / sizeof(struct node); i++) {
+      (arena->free_fun)((void *)nodes[i].elem);
+    }
   }
+#endif /* MMZK_COMPACT_NODES */
+}
 
-  node->prev_count++;
-  result->node = node;
-  if (!list->is_persistent) {
-    mmzk_list_free(list);
+// Free all chunks in the chain starting at CHUNK.
+static void _free_chunks(struct region_chunk *chunk) {
+  while (chunk != NULL) {
+    struct region_chunk *next = chunk->next;
+    free(chunk);
+    chunk = next;
   }
+}
 
-  return result;
+// Allocate the header of a list in REGION, or on its own if REGION is NULL.
+static mmzk_list_t *_new_header(mmzk_region_t *region) {
+  mmzk_list_t *list = region == NULL ? malloc(sizeof(mmzk_list_t)) : _chunk_alloc(&region->chunks, sizeof(mmzk_list_t));
+  list->region = region;
+
+  return list;
 }
 
-mmzk_list_tuple_t mmzk_list_split_at(size_t i, mmzk_list_t *list) {
-  mmzk_list_t *result1 = malloc(sizeof(mmzk_list_t));
-  mmzk_list_t *result2 = malloc(sizeof(mmzk_list_t));
-  INIT_LIST(list->funs, list->is_persistent, result2);
-  result1->is_persistent = list->is_persistent;
-  struct node *node = list->node;
+// Allocate a node for an element of FUNS in REGION, or on its own if REGION is NULL.
+static struct node *_new_node_in(mmzk_region_t *region, mmzk_funs_t funs) {
+  return region == NULL ? _new_node() : _arena_node(_region_arena(region, funs.free_fun));
+}
 
-  result1->funs = list->funs;
-  result1->node = node;
-  if (node != NULL && list->is_persistent) {
+// Add a reference to NODE from a list in REGION. Nodes in a region are freed together, so they are not counted.
+static inline void _share_node(struct node *node, mmzk_region_t *region) {
+  if (region == NULL) {
     node->prev_count++;
   }
+}
+
+// Start building a chain of nodes in REGION (NULL if none). HINT is the number of nodes expected, 0 if unknown.
+static void _builder_init(struct mmzk_list_builder *builder, mmzk_funs_t funs, mmzk_region_t *region, size_t hint) {
+  builder->funs = funs;
+  builder->region = region;
+  builder->arena = region == NULL ? NULL : _region_arena(region, funs.free_fun);
+  builder->head = NULL;
+  builder->last = NULL;
+  builder->length = 0;
+  builder->spare = NULL;
+  builder->spare_count = 0;
+  builder->batch = 4;
+  builder->max_batch = NODE_BATCH;
+  builder->hint = hint;
+}
+
+// Append an existing NODE owned by the caller to the chain.
+static void _builder_link(struct mmzk_list_builder *builder, struct node *node) {
+  if (builder->last == NULL) {
+    builder->head = node;
+  } else {
+    SET_NEXT(builder->last, node);
+  }
+  builder->last = node;
+  builder->length++;
+}
+
+// Append a new node holding ELEM to the chain. ELEM is not copied.
+// Nodes are taken from batches: as many as the hint asks for, otherwise batches that double up to the maximum.
+static void _builder_push(struct mmzk_list_builder *builder, const void *elem) {
+  if (builder->arena != NULL) {
+    struct node *node = _arena_node(builder->arena);
+    node->elem = elem;
+    _builder_link(builder, node);
+    return;
+  }
+
+#ifdef MMZK_COMPACT_NODES
+  // Pooled nodes are already handed out in batches by the free list of the thread.
+  struct node *node = _new_node();
+#else
+  if (builder->spare_count == 0) {
+    size_t len = builder->batch;
+    if (builder->hint != 0) {
+      len = builder->hint < builder->max_batch ? builder->hint : builder->max_batch;
+      builder->hint -= len;
+    } else if (builder->batch < builder->max_batch) {
+      builder->batch *= 2;
+    }
+    builder->spare = _new_nodes(len);
+    builder->spare_count = len;
+  }
+
+  struct node *node = builder->spare++;
+  builder->spare_count--;
+#endif /* MMZK_COMPACT_NODES */
+  node->elem = elem;
+  _builder_link(builder, node);
+}
+
+// Finish the chain by linking TAIL after it, returning its first node. The unused nodes of the last batch are freed.
+static struct node *_builder_finish(struct mmzk_list_builder *builder, struct node *tail) {
+  if (builder->last == NULL) {
+    builder->head = tail;
+  } else {
+    SET_NEXT(builder->last, tail);
+  }
+
+  while (builder->spare_count > 0) {
+    _delete_node(builder->spare++);
+    builder->spare_count--;
+  }
+
+  return builder->head;
+}
+
+// The number of nodes in the chain of LIST, which is more than its length if it only sees a prefix of the chain.
+// REACH is kept by the functions that make views of a chain, and is EXACT_REACH for a chain built to its length.
+static inline size_t _reach(mmzk_list_t *list) {
+  return list->reach > list->length ? list->reach : list->length;
+}
+
+// Trim RESULT of mmzk_list_take() or mmzk_list_init() if it keeps alive too many nodes beyond its length.
+static mmzk_list_t *_trim_by_policy(mmzk_list_t *result) {
+  if (trim_ratio == 0 || result->region != NULL || _reach(result) - result->length <= trim_ratio * result->length) {
+    return result;
+  }
+
+  bool is_persistent = result->is_persistent;
+  result->is_persistent = false;
+  result = mmzk_list_trim(result);
+  result->is_persistent = is_persistent;
+
+  return result;
+}
+
+// Free the header of LIST without touching its nodes. Headers in a region are freed with the region.
+static void _free_header(mmzk_list_t *list) {
+  if (list->region != NULL) {
+    return;
+  }
+
+  if (list->index != NULL) {
+    _release_index(list->index);
+  }
+  if (list->skip != NULL) {
+    _release_skip(list->skip);
+  }
+  free(list);
+}
+
+// Store the elements of the LEN nodes from *NODE in BUF, leaving *NODE at the node after them.
+// The walk only chases the chain, and each element is prefetched as it is stored, so that loading the elements for
+// the caller overlaps with the walk instead of stalling it.
+static void _gather(struct node **node, size_t len, const void **buf) {
+  struct node *cur = *node;
+
+  for (size_t i = 0; i < len; i++) {
+    buf[i] = cur->elem;
+    PREFETCH(buf[i]);
+    cur = NEXT(cur);
+  }
+
+  *node = cur;
+}
+
+// Release the reference to the chain starting at NODE, freeing the nodes that are not referred to by anything else.
+static void _free_nodes(mmzk_funs_t funs, struct node *node) {
+  while (node != NULL) {
+    if (node->prev_count > 0) {
+      node->prev_count--;
+      break;
+    }
+    struct node *temp = node;
+    node = NEXT(node);
+    (funs.free_fun)((void *)(temp->elem));
+    _delete_node(temp);
+  }
+}
+
+// Make a NULL-terminated chain with the elements of LIST that is exclusively owned by the caller.
+// If LIST is not persistent, it is consumed: its leading nodes that are not shared with any other list are taken over
+// as they are, and only the rest are copied.
+static struct node *_own_nodes(mmzk_list_t *list) {
+  struct mmzk_list_builder builder;
+  struct node *node = list->node;
+  size_t len = list->length;
+  _builder_init(&builder, list->funs, list->region, 0);
+
+  if (!list->is_persistent) {
+    while (len > 0 && node->prev_count == 0) {
+      struct node *next = NEXT(node);
+      _builder_link(&builder, node);
+      node = next;
+      len--;
+    }
+  }
+
+  struct node *rest = node;
+  builder.hint = len;
+  while (len > 0) {
+    _builder_push(&builder, (list->funs.copy_fun)(node->elem));
+    node = NEXT(node);
+    len--;
+  }
+
+  if (!list->is_persistent) {
+    _free_nodes(list->funs, rest);
+    _free_header(list);
+  }
+
+  return _builder_finish(&builder, NULL);
+}
+
+// Make the chain of LIST with the K sorted updates applied, which is exclusively owned by the caller up to the last
+// updated node and shares the rest.
+// If LIST is not persistent, it is consumed: its leading nodes that are not shared with any other list are updated in
+// place, and only the rest up to the last update are copied.
+static struct node *_update_nodes(mmzk_list_t *list, size_t k, const size_t indices[], void *elems[]) {
+  struct mmzk_list_builder builder;
+  struct node *node = list->node;
+  size_t last = indices[k - 1];
+  size_t i = 0;
+  size_t j = 0;
+  _builder_init(&builder, list->funs, list->region, 0);
+
+  if (!list->is_persistent) {
+    for (; i <= last && node->prev_count == 0; i++) {
+      struct node *next = NEXT(node);
+      if (j < k && indices[j] == i) {
+        while (j < k && indices[j] == i) {
+          j++;
+        }
+        (list->funs.free_fun)((void *)node->elem);
+        node->elem = (list->funs.copy_fun)(elems[j - 1]);
+      }
+      _builder_link(&builder, node);
+      node = next;
+    }
+  }
+
+  struct node *rest = node;
+  builder.hint = last + 1 - i;
+  for (; i <= last; i++) {
+    const void *elem = node->elem;
+    while (j < k && indices[j] == i) {
+      elem = elems[j++];
+    }
+    _builder_push(&builder, (list->funs.copy_fun)(elem));
+    node = NEXT(node);
+  }
+
+  struct node *tail = last + 1 < list->length ? node : NULL;
+  if (tail != NULL) {
+    _share_node(tail, list->region);
+  }
+
+  if (!list->is_persistent) {
+    _free_nodes(list->funs, rest);
+    _free_header(list);
+  }
+
+  return _builder_finish(&builder, tail);
+}
+
+// A requested index and where its result goes, for gathering in list order.
+struct gather_request {
+  size_t index;
+  size_t pos;
+};
+
+static int _gather_cmp(const void *r1, const void *r2) {
+  const struct gather_request *request1 = r1;
+  const struct gather_request *request2 = r2;
+  return (request1->index > request2->index) - (request1->index < request2->index);
+}
+
+// What is known about a node while accounting for memory. REFS counts the references from the lists being accounted
+// for and from the other nodes reachable from them.
+struct node_info {
+  struct node *node;
+  size_t refs;
+  bool is_visited;
+  bool is_in_window;
+  bool is_external;
+};
+
+// Open-addressing table of struct node_info, keyed by the address of the node.
+struct node_table {
+  size_t count;
+  size_t capacity;
+  struct node_info *entries;
+};
+
+static void _table_init(struct node_table *table) {
+  table->count = 0;
+  table->capacity = 64;
+  table->entries = calloc(table->capacity, sizeof(struct node_info));
+}
+
+// Double the capacity of TABLE.
+static void _table_grow(struct node_table *table) {
+  struct node_info *entries = table->entries;
+  size_t capacity = table->capacity;
+  table->capacity *= 2;
+  table->entries = calloc(table->capacity, sizeof(struct node_info));
+
+  for (size_t i = 0; i < capacity; i++) {
+    if (entries[i].node != NULL) {
+      size_t j = _mix_hash((size_t)(uintptr_t)entries[i].node) & (table->capacity - 1);
+      while (table->entries[j].node != NULL) {
+        j = (j + 1) & (table->capacity - 1);
+      }
+      table->entries[j] = entries[i];
+    }
+  }
+  free(entries);
+}
+
+// Find the info of NODE, adding it if it is not in TABLE yet. Adding may move the other entries.
+static struct node_info *_table_get(struct node_table *table, struct node *node) {
+  while (true) {
+    size_t mask = table->capacity - 1;
+    size_t i = _mix_hash((size_t)(uintptr_t)node) & mask;
+    while (table->entries[i].node != NULL && table->entries[i].node != node) {
+      i = (i + 1) & mask;
+    }
+    if (table->entries[i].node == node) {
+      return &table->entries[i];
+    }
+    if (2 * (table->count + 1) <= table->capacity) {
+      table->entries[i].node = node;
+      table->count++;
+      return &table->entries[i];
+    }
+    _table_grow(table);
+  }
+}
+
+// Open-addressing table of distinct elements, keyed by the functions of the elements. POS of each entry is a value
+// chosen by the user of the table.
+struct elem_table {
+  size_t count;
+  size_t capacity;
+  struct index_entry *entries;
+};
+
+static void _elem_table_init(struct elem_table *table) {
+  table->count = 0;
+  table->capacity = 64;
+  table->entries = malloc(table->capacity * sizeof(struct index_entry));
+  for (size_t i = 0; i < table->capacity; i++) {
+    table->entries[i].pos = SIZE_MAX;
+  }
+}
+
+// Find the entry of ELEMENT in TABLE, adding it with POS if it is not there yet; *IS_NEW tells which happened.
+// Without a hash function, all elements collide and the table degrades into a linear search.
+static struct index_entry *_elem_table_put(struct elem_table *table, mmzk_funs_t funs, const void *element, size_t pos,
+    bool *is_new) {
+  size_t hash = funs.hash_fun == NULL ? 0 : (funs.hash_fun)(element);
+  size_t mask = table->capacity - 1;
+  size_t i = _mix_hash(hash) & mask;
+
+  while (table->entries[i].pos != SIZE_MAX) {
+    if (table->entries[i].hash == hash && (funs.eq_fun)(element, table->entries[i].elem)) {
+      *is_new = false;
+      return &table->entries[i];
+    }
+    i = (i + 1) & mask;
+  }
+
+  *is_new = true;
+  if (2 * (table->count + 1) > table->capacity) {
+    struct index_entry *entries = table->entries;
+    size_t capacity = table->capacity;
+    table->capacity *= 2;
+    mask = table->capacity - 1;
+    table->entries = malloc(table->capacity * sizeof(struct index_entry));
+    for (size_t j = 0; j < table->capacity; j++) {
+      table->entries[j].pos = SIZE_MAX;
+    }
+    for (size_t j = 0; j < capacity; j++) {
+      if (entries[j].pos != SIZE_MAX) {
+        size_t k = _mix_hash(entries[j].hash) & mask;
+        while (table->entries[k].pos != SIZE_MAX) {
+          k = (k + 1) & mask;
+        }
+        table->entries[k] = entries[j];
+      }
+    }
+    free(entries);
+
+    i = _mix_hash(hash) & mask;
+    while (table->entries[i].pos != SIZE_MAX) {
+      i = (i + 1) & mask;
+    }
+  }
+
+  table->entries[i] = (struct index_entry) { .hash = hash, .pos = pos, .elem = element };
+  table->count++;
+  return &table->entries[i];
+}
+
+// Hands out the elements of a list one by one, which then belong to the caller.
+// If the list is not persistent, elements are moved out of the nodes that only the list refers to, and those nodes are
+// freed on the way; the other elements are copied.
+struct elem_cursor {
+  mmzk_funs_t funs;
+  struct node *node;
+  struct node *shared;
+  bool is_persistent;
+};
+
+static void _cursor_init(struct elem_cursor *cursor, mmzk_list_t *list) {
+  cursor->funs = list->funs;
+  cursor->node = list->node;
+  cursor->shared = NULL;
+  cursor->is_persistent = list->is_persistent;
+}
+
+static const void *_cursor_take(struct elem_cursor *cursor) {
+  struct node *node = cursor->node;
+  cursor->node = NEXT(node);
+
+  if (!cursor->is_persistent && cursor->shared == NULL) {
+    if (node->prev_count == 0) {
+      const void *elem = node->elem;
+      _delete_node(node);
+      return elem;
+    }
+    cursor->shared = node;
+  }
+
+  return (cursor->funs.copy_fun)(node->elem);
+}
+
+// Release what is left of the list after the cursor is done with it. The header of the list is not freed.
+static void _cursor_close(struct elem_cursor *cursor) {
+  if (!cursor->is_persistent) {
+    _free_nodes(cursor->funs, cursor->shared == NULL ? cursor->node : cursor->shared);
+  }
+}
+
+// Merge two sorted NULL-terminated chains. On ties, nodes from LEFT come first so that the merge is stable.
+static struct node *_merge_nodes(comparator_t *comparator, struct node *left, struct node *right) {
+  struct node dummy;
+  struct node *node = &dummy;
+
+  while (left != NULL && right != NULL) {
+    if (comparator(left->elem, right->elem) <= 0) {
+      SET_NEXT(node, left);
+      left = NEXT(left);
+    } else {
+      SET_NEXT(node, right);
+      right = NEXT(right);
+    }
+    node = NEXT(node);
+  }
+  SET_NEXT(node, left != NULL ? left : right);
+
+  return NEXT(&dummy);
+}
+
+struct run {
+  struct node *node;
+  size_t length;
+};
+
+// The ways of combining two sorted lists in _merge_sorted().
+enum merge_kind {
+  MERGE_ALL,
+  MERGE_UNION,
+  MERGE_INTERSECT,
+  MERGE_DIFF
+};
+
+// Combine the sorted LIST1 and LIST2 in one pass according to KIND. Once either list runs out, what is left of the
+// other is shared by the result if it belongs there.
+static mmzk_list_t *_merge_sorted(comparator_t *comparator, mmzk_list_t *list1, mmzk_list_t *list2,
+    enum merge_kind kind) {
+  mmzk_list_t *result = _new_header(list1->region);
+  INIT_LIST(list1->funs, list1->is_persistent || list2->is_persistent, result);
+  struct mmzk_list_builder builder;
+  _builder_init(&builder, list1->funs, list1->region, 0);
+  struct node *node1 = list1->node;
+  struct node *node2 = list2->node;
+  size_t i1 = 0;
+  size_t i2 = 0;
+
+  while (i1 < list1->length && i2 < list2->length) {
+    int cmp = comparator(node1->elem, node2->elem);
+    if (cmp < 0 || (cmp == 0 && kind == MERGE_ALL)) {
+      if (kind != MERGE_INTERSECT) {
+        _builder_push(&builder, (list1->funs.copy_fun)(node1->elem));
+      }
+      node1 = NEXT(node1);
+      i1++;
+    } else if (cmp > 0) {
+      if (kind == MERGE_ALL || kind == MERGE_UNION) {
+        _builder_push(&builder, (list2->funs.copy_fun)(node2->elem));
+      }
+      node2 = NEXT(node2);
+      i2++;
+    } else {
+      if (kind != MERGE_DIFF) {
+        _builder_push(&builder, (list1->funs.copy_fun)(node1->elem));
+      }
+      node1 = NEXT(node1);
+      node2 = NEXT(node2);
+      i1++;
+      i2++;
+    }
+  }
+
+  mmzk_list_t *rest = NULL;
+  struct node *tail = NULL;
+  size_t i = 0;
+  if (i1 < list1->length && kind != MERGE_INTERSECT) {
+    rest = list1;
+    tail = node1;
+    i = i1;
+  } else if (i2 < list2->length && (kind == MERGE_ALL || kind == MERGE_UNION)) {
+    rest = list2;
+    tail = node2;
+    i = i2;
+  }
+
+  result->length = builder.length;
+  if (rest != NULL) {
+    result->length += rest->length - i;
+    result->reach = builder.length + _reach(rest) - i;
+    _share_node(tail, rest->region);
+  }
+  result->node = _builder_finish(&builder, tail);
+
+  // Freeing a consumed list releases its nodes up to the shared rest, which stays alive with the reference above.
+  if (!list1->is_persistent) {
+    mmzk_list_free(list1);
+  }
+  if (!list2->is_persistent) {
+    mmzk_list_free(list2);
+  }
+
+  return result;
+}
+
+// Merge the AT-th and the (AT + 1)-th runs on the stack of size *COUNT.
+static void _merge_runs(comparator_t *comparator, struct run *runs, size_t *count, size_t at) {
+  runs[at].node = _merge_nodes(comparator, runs[at].node, runs[at + 1].node);
+  runs[at].length += runs[at + 1].length;
+  memmove(&runs[at + 1], &runs[at + 2], (*count - at - 2) * sizeof(struct run));
+  (*count)--;
+}
+
+// Stable bottom-up natural merge sort on a NULL-terminated chain.
+//
+// The chain is cut into maximal non-descending or strictly descending runs (the latter are reversed in place), which
+// are pushed onto a stack and merged with their neighbours following the invariants of TimSort, namely that the run
+// lengths grow at least as fast as the Fibonacci numbers from the top of the stack to the bottom. Therefore sorted
+// input takes one pass, and the stack never exceeds MAX_RUNS.
+static struct node *_sort_nodes(comparator_t *comparator, struct node *node) {
+  struct run runs[MAX_RUNS];
+  size_t count = 0;
+
+  while (node != NULL) {
+    struct node *head = node;
+    size_t length = 1;
+    node = NEXT(node);
+
+    if (node != NULL && comparator(head->elem, node->elem) > 0) {
+      struct node *last = head;
+      SET_NEXT(head, NULL);
+      while (node != NULL && comparator(last->elem, node->elem) > 0) {
+        struct node *next = NEXT(node);
+        SET_NEXT(node, head);
+        head = node;
+        last = node;
+        node = next;
+        length++;
+      }
+    } else {
+      struct node *last = head;
+      while (node != NULL && comparator(last->elem, node->elem) <= 0) {
+        last = node;
+        node = NEXT(node);
+        length++;
+      }
+      SET_NEXT(last, NULL);
+    }
+
+    runs[count++] = (struct run) { .node = head, .length = length };
+    while (count > 1) {
+      size_t n = count - 2;
+      if ((n > 0 && runs[n - 1].length <= runs[n].length + runs[n + 1].length)
+          || (n > 1 && runs[n - 2].length <= runs[n - 1].length + runs[n].length)) {
+        if (runs[n - 1].length < runs[n + 1].length) {
+          n--;
+        }
+      } else if (runs[n].length > runs[n + 1].length) {
+        break;
+      }
+      _merge_runs(comparator, runs, &count, n);
+    }
+  }
+
+  while (count > 1) {
+    _merge_runs(comparator, runs, &count, count - 2);
+  }
+
+  return count == 0 ? NULL : runs[0].node;
+}
+
+// Run WORKER on each of the COUNT tasks of SIZE bytes in TASKS concurrently, the last one on the calling thread.
+// If a thread cannot be created, its task is run on the calling thread instead.
+static void _run_parallel(void *(*worker)(void *), void *tasks, size_t size, size_t count) {
+  pthread_t *threads = malloc(count * sizeof(pthread_t));
+  bool *spawned = malloc(count * sizeof(bool));
+
+  for (size_t i = 0; i + 1 < count; i++) {
+    spawned[i] = pthread_create(&threads[i], NULL, worker, (char *)tasks + i * size) == 0;
+    if (!spawned[i]) {
+      worker((char *)tasks + i * size);
+    }
+  }
+  worker((char *)tasks + (count - 1) * size);
+
+  for (size_t i = 0; i + 1 < count; i++) {
+    if (spawned[i]) {
+      pthread_join(threads[i], NULL);
+    }
+  }
+
+  free(threads);
+  free(spawned);
+}
+
+struct sort_task {
+  comparator_t *comparator;
+  struct node *node;
+  struct node *other;
+};
+
+// Sort the chain of the task, or merge it with the other sorted chain if there is one.
+static void *_sort_worker(void *arg) {
+  struct sort_task *task = arg;
+  if (task->other == NULL) {
+    task->node = _sort_nodes(task->comparator, task->node);
+  } else {
+    task->node = _merge_nodes(task->comparator, task->node, task->other);
+  }
+
+  return NULL;
+}
+
+// Sort a NULL-terminated chain of LEN nodes by cutting it into at most THREADS segments that are sorted concurrently,
+// and then merging neighbouring segments pairwise, also concurrently, until one remains.
+static struct node *_sort_nodes_parallel(comparator_t *comparator, struct node *node, size_t len, size_t threads) {
+  if (threads > len / PARALLEL_GRAIN) {
+    threads = len / PARALLEL_GRAIN;
+  }
+  if (threads <= 1) {
+    return _sort_nodes(comparator, node);
+  }
+
+  struct sort_task *tasks = malloc(threads * sizeof(struct sort_task));
+  for (size_t i = 0; i < threads; i++) {
+    size_t seg_len = len / threads + (i < len % threads);
+    tasks[i] = (struct sort_task) { .comparator = comparator, .node = node, .other = NULL };
+    for (size_t j = 1; j < seg_len; j++) {
+      node = NEXT(node);
+    }
+    struct node *next = NEXT(node);
+    SET_NEXT(node, NULL);
+    node = next;
+  }
+  _run_parallel(_sort_worker, tasks, sizeof(struct sort_task), threads);
+
+  while (threads > 1) {
+    struct node *odd = threads % 2 == 1 ? tasks[threads - 1].node : NULL;
+    for (size_t i = 0; i < threads / 2; i++) {
+      tasks[i] = (struct sort_task) {
+        .comparator = comparator, .node = tasks[2 * i].node, .other = tasks[2 * i + 1].node
+      };
+    }
+    _run_parallel(_sort_worker, tasks, sizeof(struct sort_task), threads / 2);
+    if (odd != NULL) {
+      tasks[threads / 2].node = odd;
+    }
+    threads = (threads + 1) / 2;
+  }
+
+  node = tasks[0].node;
+  free(tasks);
+
+  return node;
+}
+
+// Cap THREADS so that each thread gets at least PARALLEL_GRAIN elements of LEN.
+static size_t _thread_count(size_t len, size_t threads) {
+  if (threads > len / PARALLEL_GRAIN) {
+    threads = len / PARALLEL_GRAIN;
+  }
+
+  return threads == 0 ? 1 : threads;
+}
+
+struct array_task {
+  mmzk_funs_t funs;
+  void **elems;
+  size_t len;
+  struct node *head;
+  struct node *last;
+};
+
+// Copy the elements of the task into a new chain, keeping both of its ends.
+static void *_from_array_worker(void *arg) {
+  struct array_task *task = arg;
+  struct mmzk_list_builder builder;
+  _builder_init(&builder, task->funs, NULL, task->len);
+
+  for (size_t i = 0; i < task->len; i++) {
+    _builder_push(&builder, (task->funs.copy_fun)(task->elems[i]));
+  }
+  task->head = _builder_finish(&builder, NULL);
+  task->last = builder.last;
+
+  return NULL;
+}
+
+// Copy the elements of the chain of the task from HEAD into its array.
+static void *_to_array_worker(void *arg) {
+  struct array_task *task = arg;
+  struct node *node = task->head;
+
+  for (size_t i = 0; i < task->len; (node = NEXT(node), i++)) {
+    task->elems[i] = (task->funs.copy_fun)(node->elem);
+  }
+
+  return NULL;
+}
+
+struct scan_task {
+  mmzk_funs_t funs;
+  void *(*worker)(const void *, const void *, void *);
+  void *arg;
+  struct node *node;
+  size_t len;
+  const void *offset;
+  void *total;
+  struct node *head;
+  struct node *last;
+};
+
+// First pass of a parallel scan: combine the elements of the segment of the task into its TOTAL.
+static void *_scan_reduce_worker(void *arg) {
+  struct scan_task *task = arg;
+  struct node *node = NEXT(task->node);
+  task->total = (task->funs.copy_fun)(task->node->elem);
+
+  for (size_t i = 1; i < task->len; (node = NEXT(node), i++)) {
+    void *total = task->worker(task->total, node->elem, task->arg);
+    (task->funs.free_fun)(task->total);
+    task->total = total;
+  }
+
+  return NULL;
+}
+
+// Second pass of a parallel scan: scan the segment of the task from its OFFSET into a new chain, keeping both of its
+// ends.
+static void *_scan_worker(void *arg) {
+  struct scan_task *task = arg;
+  struct mmzk_list_builder builder;
+  struct node *node = task->node;
+  const void *accum = task->offset;
+  _builder_init(&builder, task->funs, NULL, task->len);
+
+  for (size_t i = 0; i < task->len; (node = NEXT(node), i++)) {
+    accum = task->worker(accum, node->elem, task->arg);
+    _builder_push(&builder, accum);
+  }
+  task->head = _builder_finish(&builder, NULL);
+  task->last = builder.last;
+
+  return NULL;
+}
+
+// Split the LEN elements of ELEMS into THREADS tasks of nearly equal length.
+static struct array_task *_array_tasks(mmzk_funs_t funs, size_t len, void *elems[], size_t threads) {
+  struct array_task *tasks = malloc(threads * sizeof(struct array_task));
+
+  for (size_t i = 0; i < threads; i++) {
+    size_t seg_len = len / threads + (i < len % threads);
+    tasks[i] = (struct array_task) { .funs = funs, .elems = elems, .len = seg_len, .head = NULL, .last = NULL };
+    elems += seg_len;
+  }
+
+  return tasks;
+}
+
+
+/* Construction & Destruction */
+
+mmzk_list_t *mmzk_list_new(mmzk_funs_t funs) {
+  return mmzk_list_new_in(NULL, funs);
+}
+
+mmzk_list_t *mmzk_list_new_in(mmzk_region_t *region, mmzk_funs_t funs) {
+  mmzk_list_t *list = _new_header(region);
+  INIT_LIST(funs, true, list);
+
+  return list;
+}
+
+mmzk_list_t *mmzk_list_from_array(mmzk_funs_t funs, size_t len, void *elems[]) {
+  return mmzk_list_from_array_in(NULL, funs, len, elems);
+}
+
+mmzk_list_t *mmzk_list_from_array_in(mmzk_region_t *region, mmzk_funs_t funs, size_t len, void *elems[]) {
+  mmzk_list_t *list = _new_header(region);
+  INIT_LIST(funs, true, list);
+  list->length = len;
+
+  struct mmzk_list_builder builder;
+  _builder_init(&builder, funs, region, len);
+  for (size_t i = 0; i < len; i++) {
+    _builder_push(&builder, (funs.copy_fun)(elems[i]));
+  }
+  list->node = _builder_finish(&builder, NULL);
+
+  return list;
+}
+
+mmzk_list_t *mmzk_list_from_array_move(mmzk_funs_t funs, size_t len, void *elems[]) {
+  mmzk_list_t *list = _new_header(NULL);
+  INIT_LIST(funs, true, list);
+  list->length = len;
+
+  struct mmzk_list_builder builder;
+  _builder_init(&builder, funs, NULL, len);
+  for (size_t i = 0; i < len; i++) {
+    _builder_push(&builder, elems[i]);
+  }
+  list->node = _builder_finish(&builder, NULL);
+
+  return list;
+}
+
+mmzk_list_t *mmzk_list_from_array_parallel(mmzk_funs_t funs, size_t len, void *elems[], size_t threads) {
+  threads = _thread_count(len, threads);
+  if (threads == 1) {
+    return mmzk_list_from_array(funs, len, elems);
+  }
+
+  mmzk_list_t *list = _new_header(NULL);
+  INIT_LIST(funs, true, list);
+  list->length = len;
+
+  struct array_task *tasks = _array_tasks(funs, len, elems, threads);
+  _run_parallel(_from_array_worker, tasks, sizeof(struct array_task), threads);
+  for (size_t i = 0; i + 1 < threads; i++) {
+    SET_NEXT(tasks[i].last, tasks[i + 1].head);
+  }
+  list->node = tasks[0].head;
+  free(tasks);
+
+  return list;
+}
+
+void **mmzk_list_to_array(mmzk_list_t *list, mmzk_funs_t *funs, size_t *len) {
+  void **result = malloc(list->length * sizeof(void *));
+  struct node *node = list->node;
+
+  for (size_t i = 0; i < list->length; (node = NEXT(node), i++)) {
+    result[i] = (list->funs.copy_fun)(node->elem);
+  }
+
+  if (funs != NULL) {
+    *funs = list->funs;
+  }
+
+  if (len != NULL) {
+    *len = list->length;
+  }
+
+  if (!list->is_persistent) {
+    mmzk_list_free(list);
+  }
+
+  return result;
+}
+
+void **mmzk_list_to_array_parallel(mmzk_list_t *list, mmzk_funs_t *funs, size_t *len, size_t threads) {
+  threads = _thread_count(list->length, threads);
+  if (threads == 1) {
+    return mmzk_list_to_array(list, funs, len);
+  }
+
+  void **result = malloc(list->length * sizeof(void *));
+  struct array_task *tasks = _array_tasks(list->funs, list->length, result, threads);
+
+  // Finding where each segment starts is a plain walk, which is cheap next to copying the elements.
+  struct node *node = list->node;
+  for (size_t i = 0; i < threads; i++) {
+    tasks[i].head = node;
+    for (size_t j = 0; j < tasks[i].len; j++) {
+      node = NEXT(node);
+    }
+  }
+  _run_parallel(_to_array_worker, tasks, sizeof(struct array_task), threads);
+  free(tasks);
+
+  if (funs != NULL) {
+    *funs = list->funs;
+  }
+
+  if (len != NULL) {
+    *len = list->length;
+  }
+
+  if (!list->is_persistent) {
+    mmzk_list_free(list);
+  }
+
+  return result;
+}
+
+void mmzk_list_free(mmzk_list_t *list) {
+  assert(!list->is_snapshot);
+  if (list->region != NULL) {
+    return;
+  }
+
+  _free_nodes(list->funs, list->node);
+  _free_header(list);
+}
+
+mmzk_list_t *mmzk_list_copy(mmzk_list_t *list) {
+  assert(!list->is_snapshot);
+  mmzk_list_t *result = _new_header(list->region);
+  INIT_LIST(list->funs, list->is_persistent, result);
+  result->length = list->length;
+  result->reach = list->reach;
+  result->node = list->node;
+
+  if (list->node != NULL) {
+    _share_node(list->node, list->region);
+  }
+
+  return result;
+}
+
+mmzk_list_t *mmzk_list_trim(mmzk_list_t *list) {
+  if (_reach(list) == list->length || list->region != NULL) {
+    return list->is_persistent ? mmzk_list_copy(list) : list;
+  }
+
+  mmzk_list_t *result = _new_header(list->region);
+  INIT_LIST(list->funs, list->is_persistent, result);
+  result->length = list->length;
+  result->node = _own_nodes(list);
+
+  return result;
+}
+
+mmzk_list_t *mmzk_list_compact(mmzk_list_t *list) {
+  mmzk_list_t *result = _new_header(list->region);
+  INIT_LIST(list->funs, list->is_persistent, result);
+  result->length = list->length;
+  struct elem_cursor cursor;
+  struct mmzk_list_builder builder;
+  _cursor_init(&cursor, list);
+  _builder_init(&builder, list->funs, list->region, list->length);
+  builder.max_batch = COMPACT_BATCH;
+
+  for (size_t i = 0; i < list->length; i++) {
+    _builder_push(&builder, _cursor_take(&cursor));
+  }
+  result->node = _builder_finish(&builder, NULL);
+
+  _cursor_close(&cursor);
+  if (!list->is_persistent) {
+    _free_header(list);
+  }
+
+  return result;
+}
+
+void mmzk_list_set_persistence(mmzk_list_t *list, bool persistence) {
+  assert(!list->is_snapshot);
+  list->is_persistent = persistence || list->region != NULL;
+}
+
+void mmzk_list_set_trim_ratio(size_t ratio) {
+  trim_ratio = ratio;
+}
+
+
+/* Building */
+
+mmzk_list_builder_t *mmzk_list_builder_new(mmzk_funs_t funs) {
+  return mmzk_list_builder_new_in(NULL, funs);
+}
+
+mmzk_list_builder_t *mmzk_list_builder_new_in(mmzk_region_t *region, mmzk_funs_t funs) {
+  mmzk_list_builder_t *builder = malloc(sizeof(mmzk_list_builder_t));
+  _builder_init(builder, funs, region, 0);
+
+  return builder;
+}
+
+void mmzk_list_builder_append(mmzk_list_builder_t *builder, const void *elem) {
+  _builder_push(builder, (builder->funs.copy_fun)(elem));
+}
+
+void mmzk_list_builder_append_many(mmzk_list_builder_t *builder, size_t len, void *elems[]) {
+  builder->hint = len > builder->spare_count ? len - builder->spare_count : 0;
+  for (size_t i = 0; i < len; i++) {
+    _builder_push(builder, (builder->funs.copy_fun)(elems[i]));
+  }
+}
+
+void mmzk_list_builder_append_move(mmzk_list_builder_t *builder, void *elem) {
+  _builder_push(builder, elem);
+}
+
+void mmzk_list_builder_append_many_move(mmzk_list_builder_t *builder, size_t len, void *elems[]) {
+  builder->hint = len > builder->spare_count ? len - builder->spare_count : 0;
+  for (size_t i = 0; i < len; i++) {
+    _builder_push(builder, elems[i]);
+  }
+}
+
+void mmzk_list_builder_prepend_list(mmzk_list_builder_t *builder, mmzk_list_t *list) {
+  size_t len = list->length;
+  struct node *head = _own_nodes(list);
+
+  if (head == NULL) {
+    return;
+  }
+
+  struct node *last = head;
+  while (NEXT(last) != NULL) {
+    last = NEXT(last);
+  }
+  SET_NEXT(last, builder->head);
+  builder->head = head;
+  if (builder->last == NULL) {
+    builder->last = last;
+  }
+  builder->length += len;
+}
+
+size_t mmzk_list_builder_length(mmzk_list_builder_t *builder) {
+  return builder->length;
+}
+
+mmzk_list_t *mmzk_list_builder_freeze(mmzk_list_builder_t *builder) {
+  mmzk_list_t *list = _new_header(builder->region);
+  INIT_LIST(builder->funs, true, list);
+  list->length = builder->length;
+  list->node = _builder_finish(builder, NULL);
+  free(builder);
+
+  return list;
+}
+
+
+/* Regions */
+
+mmzk_region_t *mmzk_region_new(void) {
+  mmzk_region_t *region = malloc(sizeof(mmzk_region_t));
+  region->chunks = NULL;
+  region->arenas = NULL;
+  region->indexed = NULL;
+  region->indexed_count = 0;
+  region->indexed_capacity = 0;
+
+  return region;
+}
+
+void mmzk_region_destroy(mmzk_region_t *region) {
+  for (size_t i = 0; i < region->indexed_count; i++) {
+    if (region->indexed[i]->index != NULL) {
+      _release_index(region->indexed[i]->index);
+    }
+    if (region->indexed[i]->skip != NULL) {
+      _release_skip(region->indexed[i]->skip);
+    }
+  }
+  free(region->indexed);
+
+  // The elements are freed before any node or header, as they may be lists in the region themselves.
+  for (struct region_arena *arena = region->arenas; arena != NULL; arena = arena->next) {
+    if (arena->free_fun != NULL) {
+      _arena_free_elems(arena);
+    }
+  }
+
+  for (struct region_arena *arena = region->arenas; arena != NULL; arena = arena->next) {
+#ifdef MMZK_COMPACT_NODES
+    pthread_mutex_lock(&pool_lock);
+    for (struct pool_block *block = arena->block; block != NULL; ) {
+      uint32_t next = block->next;
+      _free_pool_block(block, &pool_free);
+      block = next == 0 ? NULL : pool_blocks[next];
+    }
+    pthread_mutex_unlock(&pool_lock);
+#else
+    _free_chunks(arena->chunks);
+#endif /* MMZK_COMPACT_NODES */
+  }
+  _free_chunks(region->chunks);
+  free(region);
+}
+
+
+/* Query */
+
+size_t mmzk_list_length(mmzk_list_t *list) {
+  return list->length;
+}
+
+void *mmzk_list_get(mmzk_list_t *list, size_t index) {
+  if (index >= list->length) {
+    return NULL;
+  }
+
+  return (list->funs.copy_fun)(_seek(list, index)->elem);
+}
+
+void mmzk_list_gather(mmzk_list_t *list, size_t k, const size_t indices[], void *out[], bool copy) {
+  struct gather_request *requests = malloc(k * sizeof(struct gather_request));
+  bool is_sorted = true;
+
+  for (size_t j = 0; j < k; j++) {
+    requests[j].index = indices[j];
+    requests[j].pos = j;
+    is_sorted = is_sorted && (j == 0 || indices[j - 1] <= indices[j]);
+  }
+  if (!is_sorted) {
+    qsort(requests, k, sizeof(struct gather_request), _gather_cmp);
+  }
+
+  struct node *node = list->node;
+  size_t i = 0;
+  for (size_t j = 0; j < k; j++) {
+    if (requests[j].index >= list->length) {
+      out[requests[j].pos] = NULL;
+      continue;
+    }
+    for (; i < requests[j].index; i++) {
+      node = NEXT(node);
+    }
+    out[requests[j].pos] = copy ? (list->funs.copy_fun)(node->elem) : (void *)node->elem;
+  }
+
+  free(requests);
+}
+
+void *mmzk_list_get_end(mmzk_list_t *list, size_t index) {
+  if (index >= list->length) {
+    return NULL;
+  }
+
+  return (list->funs.copy_fun)(_seek(list, list->length - index - 1)->elem);
+}
+
+bool mmzk_list_is_elem(const void *element, mmzk_list_t *list) {
+  return mmzk_list_elem_index(element, list) != SIZE_MAX;
+}
+
+size_t mmzk_list_elem_index(const void *element, mmzk_list_t *list) {
+  struct list_index *index = _get_index(list);
+  struct node *node = list->node;
+
+  if (index != NULL) {
+    size_t pos = _index_find(index, list->funs, element);
+    return pos < list->length ? pos : SIZE_MAX;
+  }
+
+  for (size_t i = 0; i < list->length; (node = NEXT(node), i++)) {
+    if ((list->funs.eq_fun)(element, node->elem)) {
+      return i;
+    }
+  }
+
+  return SIZE_MAX;
+}
+
+bool mmzk_list_equal(mmzk_list_t *list1, mmzk_list_t *list2) {
+  if (list1->length != list2->length) {
+    return false;
+  }
+
+  struct node *node1 = list1->node;
+  struct node *node2 = list2->node;
+
+  for (size_t i = 0; i < list1->length; i++) {
+    if (!(list1->funs.eq_fun)(node1->elem, node2->elem)) {
+      return false;
+    }
+
+    node1 = NEXT(node1);
+    node2 = NEXT(node2);
+  }
+
+  return true;
+}
+
+mmzk_list_memory_report_t mmzk_list_memory_report_many(size_t count, mmzk_list_t *lists[]) {
+  struct node_table table;
+  _table_init(&table);
+
+  // Visit every reachable node once, counting the references to it from within, and mark the nodes inside a window.
+  for (size_t l = 0; l < count; l++) {
+    struct node *node = lists[l]->node;
+    if (node == NULL) {
+      continue;
+    }
+    _table_get(&table, node)->refs++;
+
+    for (size_t pos = 0; node != NULL; (node = NEXT(node), pos++)) {
+      struct node_info *info = _table_get(&table, node);
+      if (pos < lists[l]->length) {
+        info->is_in_window = true;
+      }
+      if (info->is_visited) {
+        // The rest has been walked from here by an earlier list; only its window may reach further.
+        if (pos >= lists[l]->length) {
+          break;
+        }
+        continue;
+      }
+      info->is_visited = true;
+      if (NEXT(node) != NULL) {
+        _table_get(&table, NEXT(node))->refs++;
+      }
+    }
+  }
+
+  // A node is kept alive by something else if it has more references than those found, or if such a node leads to it.
+  for (size_t i = 0; i < table.capacity; i++) {
+    struct node_info *info = &table.entries[i];
+    if (info->node == NULL || info->is_external || info->node->prev_count + 1 <= info->refs) {
+      continue;
+    }
+    for (struct node *node = info->node; node != NULL; node = NEXT(node)) {
+      struct node_info *next = _table_get(&table, node);
+      if (next->is_external) {
+        break;
+      }
+      next->is_external = true;
+    }
+  }
+
+  mmzk_list_memory_report_t report = { 0 };
+  for (size_t i = 0; i < table.capacity; i++) {
+    struct node_info *info = &table.entries[i];
+    if (info->node == NULL) {
+      continue;
+    }
+    report.reachable++;
+    report.shared += info->is_external;
+    report.beyond_length += !info->is_in_window;
+  }
+  report.unique = report.reachable - report.shared;
+  report.node_bytes = report.reachable * sizeof(struct node);
+  report.bytes_beyond_length = report.beyond_length * sizeof(struct node);
+  free(table.entries);
+
+  return report;
+}
+
+
+/* Composition */
+
+mmzk_list_t *mmzk_list_cons(const void *elem, mmzk_list_t *list) {
+  return mmzk_list_cons_move((list->funs.copy_fun)(elem), list);
+}
+
+mmzk_list_t *mmzk_list_cons_move(void *elem, mmzk_list_t *list) {
+  assert(!list->is_snapshot);
+  mmzk_list_t *result = _new_header(list->region);
+  INIT_LIST(list->funs, list->is_persistent, result);
+  result->length = list->length + 1;
+  result->reach = _reach(list) + 1;
+  struct node *node = _new_node_in(list->region, list->funs);
+  node->elem = elem;
+  SET_NEXT(node, list->node);
+  result->node = node;
+
+  if (!list->is_persistent) {
+    _free_header(list);
+  } else if (list->node != NULL) {
+    _share_node(list->node, list->region);
+  }
+
+  return result;
+}
+
+mmzk_list_t *mmzk_list_concat(mmzk_list_t *list1, mmzk_list_t *list2) {
+  assert(!list2->is_snapshot);
+  struct node *node1 = list1->node;
+  struct node *node2 = list2->node;
+
+  mmzk_list_t *result = _new_header(list1->region);
+  INIT_LIST(list1->funs, list1->is_persistent || list2->is_persistent, result);
+  result->length = list1->length + list2->length;
+  result->reach = list1->length + _reach(list2);
+
+  if (!list2->is_persistent) {
+    _free_header(list2);
+  } else if (list2->node != NULL) {
+    _share_node(list2->node, list2->region);
+  }
+
+  struct mmzk_list_builder builder;
+  _builder_init(&builder, list1->funs, list1->region, list1->length);
+  for (size_t i = 0; i < list1->length; i++) {
+    _builder_push(&builder, (list1->funs.copy_fun)(node1->elem));
+    node1 = NEXT(node1);
+  }
+  result->node = _builder_finish(&builder, node2);
+
+  if (!list1->is_persistent) {
+    mmzk_list_free(list1);
+  }
+
+  return result;
+}
+
+mmzk_list_t *mmzk_list_merge(comparator_t *comparator, mmzk_list_t *list1, mmzk_list_t *list2) {
+  return _merge_sorted(comparator, list1, list2, MERGE_ALL);
+}
+
+mmzk_list_t *mmzk_list_union_sorted(comparator_t *comparator, mmzk_list_t *list1, mmzk_list_t *list2) {
+  return _merge_sorted(comparator, list1, list2, MERGE_UNION);
+}
+
+mmzk_list_t *mmzk_list_intersect_sorted(comparator_t *comparator, mmzk_list_t *list1, mmzk_list_t *list2) {
+  return _merge_sorted(comparator, list1, list2, MERGE_INTERSECT);
+}
+
+mmzk_list_t *mmzk_list_diff_sorted(comparator_t *comparator, mmzk_list_t *list1, mmzk_list_t *list2) {
+  return _merge_sorted(comparator, list1, list2, MERGE_DIFF);
+}
+
+
+/* Decomposition */
+
+void *mmzk_list_tail(mmzk_list_t *list) {
+  assert(!list->is_snapshot);
+  if (list->length == 0) {
+    if (!list->is_persistent) {
+      mmzk_list_free(list);
+    }
+    return NULL;
+  }
+
+  struct node *node = list->node;
+
+  mmzk_list_t *result = _new_header(list->region);
+  INIT_LIST(list->funs, list->is_persistent, result);
+  result->length = list->length - 1;
+  result->reach = _reach(list) - 1;
+  result->node = NEXT(node);
+  if (result->node != NULL) {
+    _share_node(result->node, list->region);
+  }
+
+  if (!list->is_persistent) {
+    mmzk_list_free(list);
+  }
+
+  return result;
+}
+
+void *mmzk_list_init(mmzk_list_t *list) {
+  assert(!list->is_snapshot);
+  if (list->length == 0) {
+    if (!list->is_persistent) {
+      mmzk_list_free(list);
+    }
+    return NULL;
+  }
+
+  mmzk_list_t *result = _new_header(list->region);
+  struct node *node = list->node;
+  INIT_LIST(list->funs, list->is_persistent, result);
+  result->length = list->length - 1;
+  result->reach = _reach(list);
+  if (list->is_persistent) {
+    _share_node(node, list->region);
+  } else {
+    _free_header(list);
+  }
+  result->node = node;
+
+  return _trim_by_policy(result);
+}
+
+void *mmzk_list_take(size_t i, mmzk_list_t *list) {
+  assert(!list->is_snapshot);
+  mmzk_list_t *result = _new_header(list->region);
+  struct node *node = list->node;
+  INIT_LIST(list->funs, list->is_persistent, result);
+  result->length = list->length > i ? i : list->length;
+  result->reach = _reach(list);
+  result->node = node;
+
+  if (!list->is_persistent) {
+    _free_header(list);
+  } else if (list->node != NULL) {
+    _share_node(list->node, list->region);
+  }
+
+  return _trim_by_policy(result);
+}
+
+void *mmzk_list_drop(size_t i, mmzk_list_t *list) {
+  assert(!list->is_snapshot);
+  mmzk_list_t *result = _new_header(list->region);
+  INIT_LIST(list->funs, list->is_persistent, result);
+
+  if (i >= list->length) {
+    if (!list->is_persistent) {
+      mmzk_list_free(list);
+    }
+    return result;
+  }
+
+  struct node *node = _seek(list, i);
+  result->length = list->length - i;
+  result->reach = _reach(list) - i;
+  _share_node(node, list->region);
+  result->node = node;
+  if (!list->is_persistent) {
+    mmzk_list_free(list);
+  }
+
+  return result;
+}
+
+mmzk_list_tuple_t mmzk_list_split_at(size_t i, mmzk_list_t *list) {
+  assert(!list->is_snapshot);
+  mmzk_list_t *result1 = _new_header(list->region);
+  mmzk_list_t *result2 = _new_header(list->region);
+  INIT_LIST(list->funs, list->is_persistent, result1);
+  INIT_LIST(list->funs, list->is_persistent, result2);
+  struct node *node = list->node;
+
+  result1->node = node;
+  result1->reach = _reach(list);
+  if (node != NULL && list->is_persistent) {
+    _share_node(node, list->region);
+  }
 
   if (i >= list->length) {
     result1->length = list->length;
     if (!list->is_persistent) {
-      free(list);
+      _free_header(list);
     }
     return (mmzk_list_tuple_t) { .fst = result1, .snd = result2 };
   }
 
   result1->length = i;
   result2->length = list->length - i;
-  while (i != 0) {
-    node = node->next;
-    i--;
-  }
-  node->prev_count++;
+  result2->reach = _reach(list) - i;
+  node = _seek(list, i);
+  _share_node(node, list->region);
   result2->node = node;
 
   if (!list->is_persistent) {
-    free(list);
+    _free_header(list);
   }
 
   return (mmzk_list_tuple_t) { .fst = result1, .snd = result2 };
 }
 
+void mmzk_list_split_many(size_t k, const size_t indices[], mmzk_list_t *list, mmzk_list_t *slices[]) {
+  assert(!list->is_snapshot);
+  struct node *node = list->node;
+  size_t i = 0;
+
+  for (size_t j = 0; j <= k; j++) {
+    size_t end = j == k || indices[j] > list->length ? list->length : indices[j];
+    assert(j == 0 || j == k || indices[j - 1] <= indices[j]);
+    mmzk_list_t *slice = _new_header(list->region);
+    INIT_LIST(list->funs, list->is_persistent, slice);
+    slice->length = end - i;
+
+    // The first slice takes over the reference of a non-persistent list, as in mmzk_list_split_at().
+    if (j == 0) {
+      slice->node = node;
+      slice->reach = _reach(list);
+      if (node != NULL && list->is_persistent) {
+        _share_node(node, list->region);
+      }
+    } else if (slice->length > 0) {
+      slice->node = node;
+      slice->reach = _reach(list) - i;
+      _share_node(node, list->region);
+    }
+
+    for (; i < end; i++) {
+      node = NEXT(node);
+    }
+    slices[j] = slice;
+  }
+
+  if (!list->is_persistent) {
+    _free_header(list);
+  }
+}
+
 mmzk_list_tuple_t mmzk_list_span(predicate_t *predicate, mmzk_list_t *list) {
-  mmzk_list_t *result1 = malloc(sizeof(mmzk_list_t));
-  mmzk_list_t *result2 = malloc(sizeof(mmzk_list_t));
+  assert(!list->is_snapshot);
+  mmzk_list_t *result1 = _new_header(list->region);
+  mmzk_list_t *result2 = _new_header(list->region);
+  INIT_LIST(list->funs, list->is_persistent, result1);
   INIT_LIST(list->funs, list->is_persistent, result2);
-  result1->is_persistent = list->is_persistent;
   struct node *node = list->node;
   size_t i = 0;
 
-  result1->funs = list->funs;
-  result1->node = node;
-  if (node != NULL && list->is_persistent) {
-    node->prev_count++;
+  result1->node = node;
+  result1->reach = _reach(list);
+  if (node != NULL && list->is_persistent) {
+    _share_node(node, list->region);
+  }
+
+  while (i < list->length) {
+    if(predicate(node->elem)) {
+      i++;
+      node = NEXT(node);
+    } else {
+      break;
+    }
+  }
+
+  result1->length = i;
+  result2->length = list->length - i;
+  result2->reach = _reach(list) - i;
+  result2->node = node;
+  if (node != NULL) {
+    _share_node(node, list->region);
+  }
+
+  if (!list->is_persistent) {
+    _free_header(list);
+  }
+
+  return (mmzk_list_tuple_t) { .fst = result1, .snd = result2 };
+}
+
+
+/* Update */
+
+mmzk_list_t *mmzk_list_set(size_t index, const void *elem, mmzk_list_t *list) {
+  return mmzk_list_set_many(1, &index, (void *[]) { (void *)elem }, list);
+}
+
+mmzk_list_t *mmzk_list_set_many(size_t k, const size_t indices[], void *elems[], mmzk_list_t *list) {
+  assert(!list->is_snapshot);
+  for (size_t j = 1; j < k; j++) {
+    assert(indices[j - 1] <= indices[j]);
+  }
+
+  if (k == 0) {
+    return list->is_persistent ? mmzk_list_copy(list) : list;
   }
 
-  while (node != NULL) {
-    if(predicate(node->elem)) {
-      i++;
-      node = node->next;
-    } else {
-      break;
+  if (indices[k - 1] >= list->length) {
+    if (!list->is_persistent) {
+      mmzk_list_free(list);
     }
+    return NULL;
   }
 
-  result1->length = i;
-  result2->length = list->length - i;
-  result2->node = node;
-
-  if (!list->is_persistent) {
-    free(list);
-  }
+  mmzk_list_t *result = _new_header(list->region);
+  INIT_LIST(list->funs, list->is_persistent, result);
+  result->length = list->length;
+  result->reach = list->reach;
+  result->node = _update_nodes(list, k, indices, elems);
 
-  return (mmzk_list_tuple_t) { .fst = result1, .snd = result2 };
+  return result;
 }
 
 
@@ -450,23 +2340,18 @@ mmzk_list_t *mmzk_list_map(mmzk_funs_t funs, void *(*worker)(const void *, void
     void *arg) {
   mmzk_list_t *result;
 
-  result = malloc(sizeof(mmzk_list_t));
+  result = _new_header(list->region);
   INIT_LIST(funs, list->is_persistent, result);
   result->length = list->length;
-  struct node *dummy = malloc(sizeof(struct node));
-  struct node *node1 = list->node;
-  struct node *node = dummy;
+  struct node *node = list->node;
+  struct mmzk_list_builder builder;
+  _builder_init(&builder, funs, list->region, list->length);
 
-  while (node1 != NULL) {
-    node->next = malloc(sizeof(struct node));
-    node->next->prev_count = 0;
-    node->next->elem = worker(node1->elem, arg);
-    node = node->next;
-    node1 = node1->next;
+  for (size_t i = 0; i < list->length; i++) {
+    _builder_push(&builder, worker(node->elem, arg));
+    node = NEXT(node);
   }
-  node->next = NULL;
-  result->node = dummy->next;
-  free(dummy);
+  result->node = _builder_finish(&builder, NULL);
 
   if (!list->is_persistent) {
     mmzk_list_free(list);
@@ -476,26 +2361,25 @@ mmzk_list_t *mmzk_list_map(mmzk_funs_t funs, void *(*worker)(const void *, void
 }
 
 mmzk_list_t *mmzk_list_filter(predicate_t *predicate, mmzk_list_t *list) {
-  mmzk_list_t *result = malloc(sizeof(mmzk_list_t));
-  struct node *dummy = malloc(sizeof(struct node));
-  struct node *node1 = list->node;
-  struct node *node = dummy;
+  mmzk_list_t *result = _new_header(list->region);
+  struct node *node = list->node;
+  struct mmzk_list_builder builder;
+  const void *block[GATHER_BLOCK];
   INIT_LIST(list->funs, list->is_persistent, result);
-
-  while (node1 != NULL) {
-    if (predicate(node1->elem)) {
-      result->length++;
-      node->next = malloc(sizeof(struct node));
-      const void *copy = list->funs.copy_fun(node1->elem);
-      node->next->elem = copy;
-      node->next->prev_count = 0;
-      node = node->next;
+  _builder_init(&builder, list->funs, list->region, 0);
+
+  for (size_t len = list->length; len > 0;) {
+    size_t count = len < GATHER_BLOCK ? len : GATHER_BLOCK;
+    _gather(&node, count, block);
+    for (size_t i = 0; i < count; i++) {
+      if (predicate(block[i])) {
+        _builder_push(&builder, (list->funs.copy_fun)(block[i]));
+      }
     }
-    node1 = node1->next;
+    len -= count;
   }
-  node->next = NULL;
-  result->node = dummy->next;
-  free(dummy);
+  result->length = builder.length;
+  result->node = _builder_finish(&builder, NULL);
 
   if (!list->is_persistent) {
     mmzk_list_free(list);
@@ -508,11 +2392,15 @@ void *mmzk_list_fold_left(void *(*worker)(void *, const void *), void *init, mmz
   void *result = init;
   size_t len = list->length;
   struct node *node = list->node;
+  const void *block[GATHER_BLOCK];
 
   while (len > 0) {
-    result = worker(result, node->elem);
-    node = node->next;
-    len--;
+    size_t count = len < GATHER_BLOCK ? len : GATHER_BLOCK;
+    _gather(&node, count, block);
+    for (size_t i = 0; i < count; i++) {
+      result = worker(result, block[i]);
+    }
+    len -= count;
   }
 
   if (!list->is_persistent) {
@@ -523,7 +2411,317 @@ void *mmzk_list_fold_left(void *(*worker)(void *, const void *), void *init, mmz
 }
 
 void *mmzk_list_fold_right(void *(*worker)(const void *, void *), void *init, mmzk_list_t *list) {
-  void *result = _fold(list->length, worker, init, list->node);
+  void *result = init;
+  struct node *node = list->node;
+  const void **elems = malloc(list->length * sizeof(void *));
+  _gather(&node, list->length, elems);
+
+  for (size_t i = list->length; i > 0; i--) {
+    result = worker(elems[i - 1], result);
+  }
+  free(elems);
+
+  if (!list->is_persistent) {
+    mmzk_list_free(list);
+  }
+
+  return result;
+}
+
+mmzk_list_t *mmzk_list_scan_left(mmzk_funs_t funs, void *(*worker)(const void *, const void *, void *),
+    const void *init, mmzk_list_t *list, void *arg) {
+  mmzk_list_t *result = _new_header(list->region);
+  struct node *node = list->node;
+  struct mmzk_list_builder builder;
+  const void *accum = (funs.copy_fun)(init);
+  INIT_LIST(funs, list->is_persistent, result);
+  result->length = list->length + 1;
+  _builder_init(&builder, funs, list->region, result->length);
+
+  _builder_push(&builder, accum);
+  for (size_t i = 0; i < list->length; (node = NEXT(node), i++)) {
+    accum = worker(accum, node->elem, arg);
+    _builder_push(&builder, accum);
+  }
+  result->node = _builder_finish(&builder, NULL);
+
+  if (!list->is_persistent) {
+    mmzk_list_free(list);
+  }
+
+  return result;
+}
+
+mmzk_list_t *mmzk_list_scan_left_parallel(mmzk_funs_t funs, void *(*worker)(const void *, const void *, void *),
+    const void *init, mmzk_list_t *list, void *arg, size_t threads) {
+  threads = _thread_count(list->length, threads);
+  if (threads == 1 || list->region != NULL) {
+    return mmzk_list_scan_left(funs, worker, init, list, arg);
+  }
+
+  mmzk_list_t *result = _new_header(NULL);
+  INIT_LIST(funs, list->is_persistent, result);
+  result->length = list->length + 1;
+
+  struct scan_task *tasks = malloc(threads * sizeof(struct scan_task));
+  struct node *node = list->node;
+  for (size_t i = 0; i < threads; i++) {
+    size_t seg_len = list->length / threads + (i < list->length % threads);
+    tasks[i] = (struct scan_task) { .funs = funs, .worker = worker, .arg = arg, .node = node, .len = seg_len };
+    for (size_t j = 0; j < seg_len; j++) {
+      node = NEXT(node);
+    }
+  }
+
+  // Up-sweep: reduce the segments concurrently, then combine their totals into the offset each segment starts from.
+  // The last total is never needed.
+  _run_parallel(_scan_reduce_worker, tasks, sizeof(struct scan_task), threads - 1);
+  struct node *head = _new_node();
+  head->elem = (funs.copy_fun)(init);
+  tasks[0].offset = head->elem;
+  for (size_t i = 1; i < threads; i++) {
+    tasks[i].offset = worker(tasks[i - 1].offset, tasks[i - 1].total, arg);
+    (funs.free_fun)(tasks[i - 1].total);
+  }
+
+  // Down-sweep: scan the segments from their offsets concurrently, and link the chains.
+  _run_parallel(_scan_worker, tasks, sizeof(struct scan_task), threads);
+  SET_NEXT(head, tasks[0].head);
+  for (size_t i = 0; i + 1 < threads; i++) {
+    SET_NEXT(tasks[i].last, tasks[i + 1].head);
+  }
+  for (size_t i = 1; i < threads; i++) {
+    (funs.free_fun)((void *)tasks[i].offset);
+  }
+  result->node = head;
+  free(tasks);
+
+  if (!list->is_persistent) {
+    mmzk_list_free(list);
+  }
+
+  return result;
+}
+
+mmzk_list_t *mmzk_list_scan_right(mmzk_funs_t funs, void *(*worker)(const void *, const void *, void *),
+    const void *init, mmzk_list_t *list, void *arg) {
+  mmzk_list_t *result = _new_header(list->region);
+  struct node *node = list->node;
+  struct mmzk_list_builder builder;
+  const void **accums = malloc((list->length + 1) * sizeof(void *));
+  INIT_LIST(funs, list->is_persistent, result);
+  result->length = list->length + 1;
+
+  // The elements are combined from the right, so they are gathered first; the results are then linked from the left.
+  _gather(&node, list->length, accums);
+  accums[list->length] = (funs.copy_fun)(init);
+  for (size_t i = list->length; i > 0; i--) {
+    accums[i - 1] = worker(accums[i - 1], accums[i], arg);
+  }
+
+  _builder_init(&builder, funs, list->region, result->length);
+  for (size_t i = 0; i < result->length; i++) {
+    _builder_push(&builder, accums[i]);
+  }
+  result->node = _builder_finish(&builder, NULL);
+  free(accums);
+
+  if (!list->is_persistent) {
+    mmzk_list_free(list);
+  }
+
+  return result;
+}
+
+mmzk_list_t *mmzk_list_sort(comparator_t *comparator, mmzk_list_t *list) {
+  return mmzk_list_sort_parallel(comparator, list, 1);
+}
+
+mmzk_list_t *mmzk_list_sort_parallel(comparator_t *comparator, mmzk_list_t *list, size_t threads) {
+  mmzk_list_t *result = _new_header(list->region);
+  INIT_LIST(list->funs, list->is_persistent, result);
+  result->length = list->length;
+  result->node = _sort_nodes_parallel(comparator, _own_nodes(list), result->length, threads);
+
+  return result;
+}
+
+
+/* Zipping */
+
+static bool _pair_eq(const void *p1, const void *p2) {
+  const mmzk_pair_t *pair1 = p1;
+  const mmzk_pair_t *pair2 = p2;
+
+  return (pair1->fst_funs.eq_fun)(pair1->fst, pair2->fst) && (pair1->snd_funs.eq_fun)(pair1->snd, pair2->snd);
+}
+
+static void *_pair_copy(const void *p) {
+  mmzk_pair_t *pair = (mmzk_pair_t *)p;
+  pair->ref_count++;
+
+  return pair;
+}
+
+static void _pair_free(void *p) {
+  mmzk_pair_t *pair = p;
+  if (--pair->ref_count == 0) {
+    (pair->fst_funs.free_fun)((void *)pair->fst);
+    (pair->snd_funs.free_fun)((void *)pair->snd);
+    free(pair);
+  }
+}
+
+const mmzk_funs_t mmzk_pair_funs = { &_pair_eq, &_pair_copy, &_pair_free, NULL };
+
+// Make a pair that takes over FST and SND without copying them.
+static mmzk_pair_t *_make_pair(mmzk_funs_t fst_funs, const void *fst, mmzk_funs_t snd_funs, const void *snd) {
+  mmzk_pair_t *pair = malloc(sizeof(mmzk_pair_t));
+  pair->ref_count = 1;
+  pair->fst = fst;
+  pair->snd = snd;
+  pair->fst_funs = fst_funs;
+  pair->snd_funs = snd_funs;
+
+  return pair;
+}
+
+mmzk_pair_t *mmzk_pair_new(mmzk_funs_t fst_funs, const void *fst, mmzk_funs_t snd_funs, const void *snd) {
+  return _make_pair(fst_funs, (fst_funs.copy_fun)(fst), snd_funs, (snd_funs.copy_fun)(snd));
+}
+
+const void *mmzk_pair_fst(const mmzk_pair_t *pair) {
+  return pair->fst;
+}
+
+const void *mmzk_pair_snd(const mmzk_pair_t *pair) {
+  return pair->snd;
+}
+
+mmzk_list_t *mmzk_list_zip_with(mmzk_funs_t funs, void *(*worker)(const void *, const void *, void *),
+    mmzk_list_t *list1, mmzk_list_t *list2, void *arg) {
+  mmzk_list_t *result = _new_header(list1->region);
+  INIT_LIST(funs, list1->is_persistent || list2->is_persistent, result);
+  result->length = list1->length < list2->length ? list1->length : list2->length;
+  struct node *node1 = list1->node;
+  struct node *node2 = list2->node;
+  struct mmzk_list_builder builder;
+  _builder_init(&builder, funs, list1->region, result->length);
+
+  for (size_t i = 0; i < result->length; i++) {
+    _builder_push(&builder, worker(node1->elem, node2->elem, arg));
+    node1 = NEXT(node1);
+    node2 = NEXT(node2);
+  }
+  result->node = _builder_finish(&builder, NULL);
+
+  if (!list1->is_persistent) {
+    mmzk_list_free(list1);
+  }
+  if (!list2->is_persistent) {
+    mmzk_list_free(list2);
+  }
+
+  return result;
+}
+
+mmzk_list_t *mmzk_list_zip(mmzk_list_t *list1, mmzk_list_t *list2) {
+  mmzk_list_t *result = _new_header(list1->region);
+  INIT_LIST(mmzk_pair_funs, list1->is_persistent || list2->is_persistent, result);
+  result->length = list1->length < list2->length ? list1->length : list2->length;
+  struct elem_cursor cursor1;
+  struct elem_cursor cursor2;
+  struct mmzk_list_builder builder;
+  _cursor_init(&cursor1, list1);
+  _cursor_init(&cursor2, list2);
+  _builder_init(&builder, mmzk_pair_funs, list1->region, result->length);
+
+  for (size_t i = 0; i < result->length; i++) {
+    const void *fst = _cursor_take(&cursor1);
+    const void *snd = _cursor_take(&cursor2);
+    _builder_push(&builder, _make_pair(list1->funs, fst, list2->funs, snd));
+  }
+  result->node = _builder_finish(&builder, NULL);
+
+  _cursor_close(&cursor1);
+  _cursor_close(&cursor2);
+  if (!list1->is_persistent) {
+    _free_header(list1);
+  }
+  if (!list2->is_persistent) {
+    _free_header(list2);
+  }
+
+  return result;
+}
+
+mmzk_list_tuple_t mmzk_list_unzip(mmzk_funs_t fst_funs, mmzk_funs_t snd_funs, mmzk_list_t *list) {
+  mmzk_list_t *result1 = _new_header(list->region);
+  mmzk_list_t *result2 = _new_header(list->region);
+  INIT_LIST(fst_funs, list->is_persistent, result1);
+  INIT_LIST(snd_funs, list->is_persistent, result2);
+  result1->length = list->length;
+  result2->length = list->length;
+  struct node *node = list->node;
+  struct mmzk_list_builder builder1;
+  struct mmzk_list_builder builder2;
+  _builder_init(&builder1, fst_funs, list->region, list->length);
+  _builder_init(&builder2, snd_funs, list->region, list->length);
+
+  for (size_t i = 0; i < list->length; i++) {
+    const mmzk_pair_t *pair = node->elem;
+    _builder_push(&builder1, (fst_funs.copy_fun)(pair->fst));
+    _builder_push(&builder2, (snd_funs.copy_fun)(pair->snd));
+    node = NEXT(node);
+  }
+  result1->node = _builder_finish(&builder1, NULL);
+  result2->node = _builder_finish(&builder2, NULL);
+
+  if (!list->is_persistent) {
+    mmzk_list_free(list);
+  }
+
+  return (mmzk_list_tuple_t) { .fst = result1, .snd = result2 };
+}
+
+
+/* Grouping */
+
+static bool _list_eq(const void *list1, const void *list2) {
+  return mmzk_list_equal((mmzk_list_t *)list1, (mmzk_list_t *)list2);
+}
+
+static void *_list_copy(const void *list) {
+  return mmzk_list_copy((mmzk_list_t *)list);
+}
+
+static void _list_free(void *list) {
+  mmzk_list_free(list);
+}
+
+const mmzk_funs_t mmzk_list_funs = { &_list_eq, &_list_copy, &_list_free, NULL };
+
+mmzk_list_t *mmzk_list_nub(mmzk_list_t *list) {
+  mmzk_list_t *result = _new_header(list->region);
+  INIT_LIST(list->funs, list->is_persistent, result);
+  struct node *node = list->node;
+  struct elem_table table;
+  struct mmzk_list_builder builder;
+  _elem_table_init(&table);
+  _builder_init(&builder, list->funs, list->region, 0);
+
+  for (size_t i = 0; i < list->length; i++) {
+    bool is_new;
+    _elem_table_put(&table, list->funs, node->elem, i, &is_new);
+    if (is_new) {
+      _builder_push(&builder, (list->funs.copy_fun)(node->elem));
+    }
+    node = NEXT(node);
+  }
+  result->length = builder.length;
+  result->node = _builder_finish(&builder, NULL);
+  free(table.entries);
+
   if (!list->is_persistent) {
     mmzk_list_free(list);
   }
@@ -531,6 +2729,91 @@ void *mmzk_list_fold_right(void *(*worker)(const void *, void *), void *init, mm
   return result;
 }
 
+mmzk_list_t *mmzk_list_group_by_key(mmzk_funs_t key_funs, void *(*key)(const void *, void *), mmzk_list_t *list,
+    void *arg) {
+  mmzk_list_t *result = _new_header(list->region);
+  INIT_LIST(mmzk_pair_funs, list->is_persistent, result);
+  struct elem_table table;
+  struct elem_cursor cursor;
+  size_t count = 0;
+  size_t capacity = 16;
+  void **keys = malloc(capacity * sizeof(void *));
+  struct mmzk_list_builder *groups = malloc(capacity * sizeof(struct mmzk_list_builder));
+  _elem_table_init(&table);
+  _cursor_init(&cursor, list);
+
+  for (size_t i = 0; i < list->length; i++) {
+    const void *elem = _cursor_take(&cursor);
+    void *elem_key = key(elem, arg);
+    bool is_new;
+    size_t group = _elem_table_put(&table, key_funs, elem_key, count, &is_new)->pos;
+    if (is_new) {
+      if (count == capacity) {
+        capacity *= 2;
+        keys = realloc(keys, capacity * sizeof(void *));
+        groups = realloc(groups, capacity * sizeof(struct mmzk_list_builder));
+      }
+      keys[count] = elem_key;
+      _builder_init(&groups[count], list->funs, list->region, 0);
+      count++;
+    } else {
+      (key_funs.free_fun)(elem_key);
+    }
+    _builder_push(&groups[group], elem);
+  }
+
+  struct mmzk_list_builder builder;
+  _builder_init(&builder, mmzk_pair_funs, list->region, count);
+  for (size_t j = 0; j < count; j++) {
+    mmzk_list_t *group = _new_header(list->region);
+    INIT_LIST(list->funs, true, group);
+    group->length = groups[j].length;
+    group->node = _builder_finish(&groups[j], NULL);
+    _builder_push(&builder, _make_pair(key_funs, keys[j], mmzk_list_funs, group));
+  }
+  result->length = count;
+  result->node = _builder_finish(&builder, NULL);
+
+  free(table.entries);
+  free(keys);
+  free(groups);
+  _cursor_close(&cursor);
+  if (!list->is_persistent) {
+    _free_header(list);
+  }
+
+  return result;
+}
+
+mmzk_list_tuple_t mmzk_list_partition(predicate_t *predicate, mmzk_list_t *list) {
+  mmzk_list_t *result1 = _new_header(list->region);
+  mmzk_list_t *result2 = _new_header(list->region);
+  INIT_LIST(list->funs, list->is_persistent, result1);
+  INIT_LIST(list->funs, list->is_persistent, result2);
+  struct elem_cursor cursor;
+  struct mmzk_list_builder builder1;
+  struct mmzk_list_builder builder2;
+  _cursor_init(&cursor, list);
+  _builder_init(&builder1, list->funs, list->region, 0);
+  _builder_init(&builder2, list->funs, list->region, 0);
+
+  for (size_t i = 0; i < list->length; i++) {
+    const void *elem = _cursor_take(&cursor);
+    _builder_push(predicate(elem) ? &builder1 : &builder2, elem);
+  }
+  result1->length = builder1.length;
+  result2->length = builder2.length;
+  result1->node = _builder_finish(&builder1, NULL);
+  result2->node = _builder_finish(&builder2, NULL);
+
+  _cursor_close(&cursor);
+  if (!list->is_persistent) {
+    _free_header(list);
+  }
+
+  return (mmzk_list_tuple_t) { .fst = result1, .snd = result2 };
+}
+
 
 /* Iteration */
 
@@ -544,6 +2827,211 @@ bool mmzk_list_has_next(mmzk_list_iterator_t iterator) {
 
 void *mmzk_list_yield(mmzk_list_iterator_t *iterator) {
   void *elem = (void *)iterator->node->elem;
-  *iterator = (mmzk_list_iterator_t) { .length = iterator->length - 1, .node = iterator->node->next };
+  *iterator = (mmzk_list_iterator_t) { .length = iterator->length - 1, .node = NEXT(iterator->node) };
   return elem;
 }
+
+size_t mmzk_list_yield_many(mmzk_list_iterator_t *iterator, void *buf[], size_t n) {
+  size_t count = iterator->length < n ? iterator->length : n;
+
+  _gather(&iterator->node, count, (const void **)buf);
+  iterator->length -= count;
+
+  return count;
+}
+
+
+/* Atomic References */
+
+// A list published by a cell. REF_COUNT counts the cell while the version is current, plus each snapshot of it.
+// Once the count drops to 0, the version is put on the retired stack of the cell through NEXT.
+struct ref_version {
+  atomic_size_t ref_count;
+  mmzk_list_t *list;
+  struct ref_version *next;
+};
+
+// A snapshot of a version: a header of its own over the chain of the version, which it does not count.
+struct ref_snapshot {
+  mmzk_list_t list;
+  struct ref_version *version;
+};
+
+// Writers hold LOCK, because the nodes of versions share reference counts that are not atomic. Readers only touch
+// CURRENT and RETIRED, and the counts of versions.
+struct mmzk_list_ref {
+  _Atomic(struct ref_version *) current;
+  _Atomic(struct ref_version *) retired;
+  pthread_mutex_t lock;
+};
+
+// A hazard pointer: a version that a reader is about to count, which must not be freed until the reader is done.
+// Records are never freed; a reader takes an inactive one, or adds a new one if all are in use.
+struct hazard {
+  _Atomic(struct ref_version *) version;
+  atomic_bool is_active;
+  struct hazard *next;
+};
+
+static _Atomic(struct hazard *) hazards;
+
+static struct hazard *_acquire_hazard(void) {
+  for (struct hazard *hazard = atomic_load(&hazards); hazard != NULL; hazard = hazard->next) {
+    bool is_active = false;
+    if (!atomic_load(&hazard->is_active)
+        && atomic_compare_exchange_strong(&hazard->is_active, &is_active, true)) {
+      return hazard;
+    }
+  }
+
+  struct hazard *hazard = malloc(sizeof(struct hazard));
+  atomic_init(&hazard->version, NULL);
+  atomic_init(&hazard->is_active, true);
+  hazard->next = atomic_load(&hazards);
+  while (!atomic_compare_exchange_weak(&hazards, &hazard->next, hazard));
+
+  return hazard;
+}
+
+static void _release_hazard(struct hazard *hazard) {
+  atomic_store(&hazard->version, NULL);
+  atomic_store(&hazard->is_active, false);
+}
+
+static bool _is_hazardous(struct ref_version *version) {
+  for (struct hazard *hazard = atomic_load(&hazards); hazard != NULL; hazard = hazard->next) {
+    if (atomic_load(&hazard->version) == version) {
+      return true;
+    }
+  }
+
+  return false;
+}
+
+static struct ref_version *_new_version(mmzk_list_t *list) {
+  struct ref_version *version = malloc(sizeof(struct ref_version));
+  atomic_init(&version->ref_count, 1);
+  version->list = list;
+  version->next = NULL;
+
+  return version;
+}
+
+// Drop a count of VERSION, retiring it if it was the last. Lock-free, so that readers never wait for writers.
+static void _drop_version(mmzk_list_ref_t *ref, struct ref_version *version) {
+  if (atomic_fetch_sub(&version->ref_count, 1) == 1) {
+    version->next = atomic_load(&ref->retired);
+    while (!atomic_compare_exchange_weak(&ref->retired, &version->next, version));
+  }
+}
+
+// Free the retired versions of REF that no reader is about to count; the others stay retired. Only called by writers.
+static void _reclaim_versions(mmzk_list_ref_t *ref) {
+  struct ref_version *version = atomic_exchange(&ref->retired, NULL);
+
+  while (version != NULL) {
+    struct ref_version *next = version->next;
+    if (_is_hazardous(version)) {
+      version->next = atomic_load(&ref->retired);
+      while (!atomic_compare_exchange_weak(&ref->retired, &version->next, version));
+    } else {
+      mmzk_list_free(version->list);
+      free(version);
+    }
+    version = next;
+  }
+}
+
+// Make LIST the current version of REF. The caller holds the lock.
+static void _publish(mmzk_list_ref_t *ref, mmzk_list_t *list) {
+  list->is_persistent = true;
+  _drop_version(ref, atomic_exchange(&ref->current, _new_version(list)));
+  _reclaim_versions(ref);
+}
+
+mmzk_list_ref_t *mmzk_list_ref_new(mmzk_list_t *list) {
+  assert(list->region == NULL);
+  mmzk_list_ref_t *ref = malloc(sizeof(mmzk_list_ref_t));
+  mmzk_list_t *owned = _new_header(NULL);
+  INIT_LIST(list->funs, true, owned);
+  owned->length = list->length;
+  owned->node = _own_nodes(list);
+  atomic_init(&ref->current, _new_version(owned));
+  atomic_init(&ref->retired, NULL);
+  pthread_mutex_init(&ref->lock, NULL);
+
+  return ref;
+}
+
+void mmzk_list_ref_free(mmzk_list_ref_t *ref) {
+  _drop_version(ref, atomic_load(&ref->current));
+  _reclaim_versions(ref);
+  pthread_mutex_destroy(&ref->lock);
+  free(ref);
+}
+
+mmzk_list_t *mmzk_list_ref_load(mmzk_list_ref_t *ref) {
+  struct hazard *hazard = _acquire_hazard();
+  struct ref_version *version;
+
+  while (true) {
+    version = atomic_load(&ref->current);
+    atomic_store(&hazard->version, version);
+    if (atomic_load(&ref->current) != version) {
+      continue;
+    }
+
+    // The hazard keeps VERSION from being freed, but it may have been retired in the meantime, in which case it must
+    // not be counted again.
+    size_t count = atomic_load(&version->ref_count);
+    while (count != 0 && !atomic_compare_exchange_weak(&version->ref_count, &count, count + 1));
+    if (count != 0) {
+      break;
+    }
+  }
+  _release_hazard(hazard);
+
+  struct ref_snapshot *snapshot = malloc(sizeof(struct ref_snapshot));
+  mmzk_list_t *list = &snapshot->list;
+  INIT_LIST(version->list->funs, true, list);
+  list->region = NULL;
+  list->length = version->list->length;
+  list->reach = version->list->reach;
+  list->node = version->list->node;
+  list->is_snapshot = true;
+  snapshot->version = version;
+
+  return list;
+}
+
+void mmzk_list_ref_release(mmzk_list_ref_t *ref, mmzk_list_t *snapshot) {
+  struct ref_snapshot *container = (struct ref_snapshot *)snapshot;
+  assert(snapshot->is_snapshot);
+
+  _drop_version(ref, container->version);
+  free(container);
+}
+
+void mmzk_list_ref_store(mmzk_list_ref_t *ref, mmzk_list_t *list) {
+  assert(list->region == NULL);
+  mmzk_list_t *owned = _new_header(NULL);
+  INIT_LIST(list->funs, true, owned);
+  owned->length = list->length;
+  owned->node = _own_nodes(list);
+
+  pthread_mutex_lock(&ref->lock);
+  _publish(ref, owned);
+  pthread_mutex_unlock(&ref->lock);
+}
+
+void mmzk_list_ref_update(mmzk_list_ref_t *ref, mmzk_list_t *(*fn)(mmzk_list_t *, void *), void *arg) {
+  pthread_mutex_lock(&ref->lock);
+  mmzk_list_t *list = mmzk_list_copy(atomic_load(&ref->current)->list);
+  mmzk_list_t *result = fn(list, arg);
+  assert(result->region == NULL);
+  if (result != list) {
+    mmzk_list_free(list);
+  }
+  _publish(ref, result);
+  pthread_mutex_unlock(&ref->lock);
+}
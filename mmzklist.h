@@ -19,11 +19,29 @@ mmzk_list_t *mmzk_list_new(mmzk_funs_t funs);
 // O(n).
 mmzk_list_t *mmzk_list_from_array(mmzk_funs_t funs, size_t len, void *elems[]);
 
+// Make list from array, taking over the elements instead of copying them. The elements then belong to the list and must
+// not be used or freed by the caller; the array itself still belongs to the caller.
+// O(n).
+mmzk_list_t *mmzk_list_from_array_move(mmzk_funs_t funs, size_t len, void *elems[]);
+
 // Turn LIST into an array. The functions of LIST will be stored in FUNS (if not NULL) and the length will be stored in
 // LEN (if not NULL).
 // O(n).
 void **mmzk_list_to_array(mmzk_list_t *list, mmzk_funs_t *funs, size_t *len);
 
+// Same as mmzk_list_from_array(), but ELEMS is cut into up to THREADS ranges whose elements are copied into separate
+// chains concurrently, which are then linked together. The result is identical to that of mmzk_list_from_array().
+// COPY_FUN of FUNS must be safe to call from several threads at once. Short arrays are copied on the calling thread
+// alone.
+// O(n).
+mmzk_list_t *mmzk_list_from_array_parallel(mmzk_funs_t funs, size_t len, void *elems[], size_t threads);
+
+// Same as mmzk_list_to_array(), but LIST is cut into up to THREADS segments whose elements are copied concurrently.
+// COPY_FUN of LIST must be safe to call from several threads at once. Short lists are copied on the calling thread
+// alone.
+// O(n).
+void **mmzk_list_to_array_parallel(mmzk_list_t *list, mmzk_funs_t *funs, size_t *len, size_t threads);
+
 // Free the list.
 //
 // Any list returned by the functions in this module must be freed even if the data may be shared.
@@ -35,10 +53,117 @@ void mmzk_list_free(mmzk_list_t *list);
 // This function never deallocates LIST, regardless of its persistence state.
 mmzk_list_t *mmzk_list_copy(mmzk_list_t *list);
 
+// Construct an identical list from LIST whose nodes are laid out contiguously in traversal order, so that traversing it
+// is friendlier to the cache than traversing a list assembled from many operations.
+// If LIST is not persistent, its nodes that are not shared with other lists are moved to the new layout without copying
+// the elements; otherwise, or for the shared nodes, the elements are copied. Other lists are never affected.
+// O(n).
+mmzk_list_t *mmzk_list_compact(mmzk_list_t *list);
+
+// Construct an identical list from LIST that does not keep alive any node beyond its length.
+// Since take and init only shorten the length, their results keep the whole chain of their argument alive, even after
+// the argument is freed. If LIST is such a view, its elements are copied into a chain of its own (for a non-persistent
+// LIST, the nodes that are not shared with other lists are reused instead); otherwise LIST is simply copied. Lists in a
+// region are never trimmed.
+// O(n) if LIST needs trimming, O(1) otherwise.
+mmzk_list_t *mmzk_list_trim(mmzk_list_t *list);
+
 // If PERSISTENCE is TRUE (by default), then passing LIST to another function in this module does not modify itself.
 // Otherwise, LIST will be deallocated when used as an argument to a function (unless specified otherwise).
 void mmzk_list_set_persistence(mmzk_list_t *list, bool persistence);
 
+// If RATIO is not 0, mmzk_list_take() and mmzk_list_init() (and thus mmzk_list_drop_end()) trim their result with
+// mmzk_list_trim() whenever it would keep alive more than RATIO times its length in nodes beyond its length, so that a
+// short prefix of a long list does not pin the rest of it. They take O(n) time on the result when this happens.
+// The ratio is 0 (never trim) by default. It applies to all lists, and must not be changed while other threads use
+// them.
+void mmzk_list_set_trim_ratio(size_t ratio);
+
+
+/* Building */
+
+// Building outline:
+// mmzk_list_builder_t *builder = mmzk_list_builder_new(funs);
+// for (...) {
+//   mmzk_list_builder_append(builder, elem);
+// }
+// mmzk_list_t *list = mmzk_list_builder_freeze(builder);
+
+// New builder with no elements.
+// Nodes are allocated in batches, and the elements are linked in place, so that freezing the builder copies nothing.
+// O(1).
+mmzk_list_builder_t *mmzk_list_builder_new(mmzk_funs_t funs);
+
+// Append ELEM to the end of BUILDER.
+// O(1).
+void mmzk_list_builder_append(mmzk_list_builder_t *builder, const void *elem);
+
+// Append the LEN elements of ELEMS to the end of BUILDER.
+// O(n).
+void mmzk_list_builder_append_many(mmzk_list_builder_t *builder, size_t len, void *elems[]);
+
+// Append ELEM to the end of BUILDER, taking it over instead of copying it, as mmzk_list_from_array_move().
+// O(1).
+void mmzk_list_builder_append_move(mmzk_list_builder_t *builder, void *elem);
+
+// Append the LEN elements of ELEMS to the end of BUILDER, taking them over instead of copying them, as
+// mmzk_list_from_array_move().
+// O(n).
+void mmzk_list_builder_append_many_move(mmzk_list_builder_t *builder, size_t len, void *elems[]);
+
+// Put the elements of LIST in front of those in BUILDER.
+// If LIST is not persistent, its nodes that are not shared with other lists are moved instead of copied.
+// O(n), where n is the length of LIST.
+void mmzk_list_builder_prepend_list(mmzk_list_builder_t *builder, mmzk_list_t *list);
+
+// The number of elements in BUILDER.
+// O(1).
+size_t mmzk_list_builder_length(mmzk_list_builder_t *builder);
+
+// Turn BUILDER into a (persistent) list. BUILDER is deallocated and must not be used afterwards.
+// O(1).
+mmzk_list_t *mmzk_list_builder_freeze(mmzk_list_builder_t *builder);
+
+
+/* Regions */
+
+// Region outline:
+// mmzk_region_t *region = mmzk_region_new();
+// mmzk_list_t *list = mmzk_list_from_array_in(region, funs, len, elems);
+// mmzk_list_t *rest = mmzk_list_drop(1, list);
+// ...
+// mmzk_region_destroy(region);
+//
+// The headers and nodes of the lists in a region are bump-allocated, and the lists produced from them are put in the
+// same region. Nodes in a region are not reference counted, and mmzk_list_free() does nothing on a list in a region
+// (it can still be called), so that sharing and dropping lists costs nothing; instead, destroying the region frees
+// every list in it at once. Lists in a region are always persistent.
+//
+// A list in a region must not be combined with a list outside it or in another region, and it must not be used after
+// the region is destroyed. A region must not be used by several threads at once.
+
+// New empty region.
+// O(1).
+mmzk_region_t *mmzk_region_new(void);
+
+// Free REGION with all lists in it. The elements of the lists are freed with their free_fun, unless it is NULL, in
+// which case they are left as they are.
+// O(n), where n is the number of nodes allocated in REGION whose elements need freeing; O(1) per block of nodes
+// otherwise.
+void mmzk_region_destroy(mmzk_region_t *region);
+
+// New empty list in REGION, i.e. [].
+// O(1).
+mmzk_list_t *mmzk_list_new_in(mmzk_region_t *region, mmzk_funs_t funs);
+
+// Make list in REGION from array.
+// O(n).
+mmzk_list_t *mmzk_list_from_array_in(mmzk_region_t *region, mmzk_funs_t funs, size_t len, void *elems[]);
+
+// New builder with no elements, which produces a list in REGION.
+// O(1).
+mmzk_list_builder_t *mmzk_list_builder_new_in(mmzk_region_t *region, mmzk_funs_t funs);
+
 
 /* Query */
 
@@ -53,12 +178,24 @@ inline bool mmzk_list_is_empty(mmzk_list_t *list) {
 }
 
 // Get the INDEX-th element of LIST, NULL if out of bound, i.e. LIST !! INDEX.
-// O(n).
+// After a few positional accesses on a long persistent list, a skip index is built that records every 16th node. It is
+// shared by the lists starting from the same node that are no longer than LIST, and is freed with the last of them that
+// has used it. The same index is used by mmzk_list_get_end(), mmzk_list_drop() and mmzk_list_split_at(). A persistent
+// LIST may be accessed from several threads at once; until the index is built, each access counts itself with an
+// atomic increment on LIST.
+// O(n); O(1) once the skip index is built.
 void *mmzk_list_get(mmzk_list_t *list, size_t index);
 
+// Get the elements of LIST at the K INDICES into OUT, with NULL for those out of bound, i.e. map (LIST !!) INDICES.
+// The indices may be in any order and may repeat. If COPY is true, the elements are copied and belong to the caller;
+// otherwise they are borrowed from LIST and only valid as long as it is.
+// This function never deallocates LIST, regardless of its persistence state.
+// O(n + k log k); only one iteration through the list.
+void mmzk_list_gather(mmzk_list_t *list, size_t k, const size_t indices[], void *out[], bool copy);
+
 // Get the INDEX-th element of LIST counted from the last element, NULL if out of bound,
 // i.e. LIST !! (length LIST - INDEX - 1).
-// O(n); only one iteration through the list.
+// O(n); O(1) once the skip index is built.
 void *mmzk_list_get_end(mmzk_list_t *list, size_t index);
 
 // Get the first element of LIST, NULL if empty, i.e. head LIST.
@@ -73,16 +210,39 @@ static inline void *mmzk_list_last(mmzk_list_t *list) {
     return mmzk_list_get_end(list, 0);
 }
 
-// Whether ELEMENT is an element of LIST.
+// Whether ELEMENT is an element of LIST, i.e. elem ELEMENT LIST.
 // This function never deallocates LIST, regardless of its persistence state.
-// O(n).
+// If the functions of LIST include a HASH_FUN, a hash index is built after a few queries on a long list. The index is
+// shared by the lists starting from the same node that are no longer than LIST, and is freed with the last of them that
+// has used it. A persistent LIST may be queried from several threads at once, and HASH_FUN and EQ_FUN may query other
+// lists, as the index is built without holding any lock.
+// O(n); O(1) on average once the index is built.
 bool mmzk_list_is_elem(const void *element, mmzk_list_t *list);
 
+// The index of the first occurrence of ELEMENT in LIST, SIZE_MAX if not found, i.e. elemIndex ELEMENT LIST.
+// This function never deallocates LIST, regardless of its persistence state.
+// It uses the same hash index as mmzk_list_is_elem().
+// O(n); O(1) on average once the index is built.
+size_t mmzk_list_elem_index(const void *element, mmzk_list_t *list);
+
 // Whether LIST1 and LIST2 are structurally equal.
 // This function never deallocates LIST, regardless of its persistence state.
 // O(n).
 bool mmzk_list_equal(mmzk_list_t *list1, mmzk_list_t *list2);
 
+// Account for the nodes kept alive by the COUNT lists in LISTS, counting each node once.
+// Since lists share suffixes, and take and init only shorten the length, a list may keep alive more nodes than its
+// length, some of which are also kept alive by others. The report tells them apart, which helps to find retention.
+// This function never deallocates the lists, regardless of their persistence states.
+// O(n), where n is the number of reachable nodes.
+mmzk_list_memory_report_t mmzk_list_memory_report_many(size_t count, mmzk_list_t *lists[]);
+
+// Account for the nodes kept alive by LIST, as mmzk_list_memory_report_many().
+// O(n), where n is the number of reachable nodes.
+static inline mmzk_list_memory_report_t mmzk_list_memory_report(mmzk_list_t *list) {
+    return mmzk_list_memory_report_many(1, &list);
+}
+
 
 /* Composition */
 
@@ -90,11 +250,40 @@ bool mmzk_list_equal(mmzk_list_t *list1, mmzk_list_t *list2);
 // O(1).
 mmzk_list_t *mmzk_list_cons(const void *elem, mmzk_list_t *list);
 
+// Construct a list by prepending ELEM to the given LIST, taking ELEM over instead of copying it, as
+// mmzk_list_from_array_move().
+// O(1).
+mmzk_list_t *mmzk_list_cons_move(void *elem, mmzk_list_t *list);
+
 // Construct a list by concatenating LIST1 with LIST2, i.e. LIST1 ++ LIST2.
 // LIST2 is shared in the new list while LIST1 is copied.
 // O(n).
 mmzk_list_t *mmzk_list_concat(mmzk_list_t *list1, mmzk_list_t *list2);
 
+// The following functions combine LIST1 and LIST2, which must be sorted by COMPARATOR and have the same functions, into
+// a sorted list in one pass. Equal elements are treated as in multisets, and on ties the elements of LIST1 come first.
+// Once either list runs out, what is left of the other one is shared by the result (as LIST2 in mmzk_list_concat())
+// instead of being copied, if it belongs to the result.
+
+// Merge LIST1 and LIST2, keeping all elements of both, i.e. mergeBy COMPARATOR LIST1 LIST2.
+// O(n + m).
+mmzk_list_t *mmzk_list_merge(comparator_t *comparator, mmzk_list_t *list1, mmzk_list_t *list2);
+
+// The union of LIST1 and LIST2, where an element occurring in both is taken from LIST1 as many times as it occurs in
+// either, i.e. unionBy COMPARATOR LIST1 LIST2.
+// O(n + m).
+mmzk_list_t *mmzk_list_union_sorted(comparator_t *comparator, mmzk_list_t *list1, mmzk_list_t *list2);
+
+// The elements of LIST1 that are also in LIST2, as many times as they occur in both,
+// i.e. isectBy COMPARATOR LIST1 LIST2.
+// O(n + m).
+mmzk_list_t *mmzk_list_intersect_sorted(comparator_t *comparator, mmzk_list_t *list1, mmzk_list_t *list2);
+
+// The elements of LIST1 that are not in LIST2, where each element of LIST2 removes one equal element of LIST1,
+// i.e. minusBy COMPARATOR LIST1 LIST2.
+// O(n + m).
+mmzk_list_t *mmzk_list_diff_sorted(comparator_t *comparator, mmzk_list_t *list1, mmzk_list_t *list2);
+
 
 /* Decomposition */
 
@@ -103,15 +292,15 @@ mmzk_list_t *mmzk_list_concat(mmzk_list_t *list1, mmzk_list_t *list2);
 void *mmzk_list_tail(mmzk_list_t *list);
 
 // Get the list without the last element in LIST, NULL if empty, i.e. init LIST.
-// O(1).
+// O(1), unless the result is trimmed (see mmzk_list_set_trim_ratio()).
 void *mmzk_list_init(mmzk_list_t *list);
 
 // Take the first I elements in LIST, i.e. take I LIST.
-// O(1).
+// O(1), unless the result is trimmed (see mmzk_list_set_trim_ratio()).
 void *mmzk_list_take(size_t i, mmzk_list_t *list);
 
 // Drop the first I elements in LIST, i.e. drop I LIST.
-// O(n).
+// O(n); O(1) once the skip index is built (see mmzk_list_get()).
 void *mmzk_list_drop(size_t i, mmzk_list_t *list);
 
 // Take the last I elements in LIST, i.e. drop (length LIST - I) LIST.
@@ -122,14 +311,14 @@ static inline void *mmzk_list_take_end(size_t i, mmzk_list_t *list) {
 }
 
 // Drop the last I elements in LIST, i.e. take (length LIST - I) LIST.
-// O(1).
+// O(1), unless the result is trimmed (see mmzk_list_set_trim_ratio()).
 static inline void *mmzk_list_drop_end(size_t i, mmzk_list_t *list) {
     size_t len = mmzk_list_length(list);
     return mmzk_list_take(len > i ? len - i : 0, list);
 }
 
 // Split LIST at index I, i.e. splitAt I LIST.
-// O(n).
+// O(n); O(1) once the skip index is built (see mmzk_list_get()).
 mmzk_list_tuple_t mmzk_list_split_at(size_t i, mmzk_list_t *list);
 
 // Split LIST at index I counting from the right, i.e. splitAt (length LIST - I) LIST.
@@ -139,15 +328,38 @@ static inline mmzk_list_tuple_t mmzk_list_split_at_end(size_t i, mmzk_list_t *li
     return mmzk_list_split_at(len > i ? len - i : 0, list);
 }
 
+// Split LIST at each of the K INDICES into the K + 1 slices in SLICES, i.e. the generalisation of splitAt to many
+// indices. INDICES must be sorted in ascending order; indices beyond the length of LIST give empty slices.
+// The slices share the nodes of LIST, as mmzk_list_split_at().
+// O(n); only one iteration through the list.
+void mmzk_list_split_many(size_t k, const size_t indices[], mmzk_list_t *list, mmzk_list_t *slices[]);
+
 // Split LIST into the longest prefix where PREDICATE holds and the rest of the list, i.e. span PREDICATE LIST.
 // O(n).
 mmzk_list_tuple_t mmzk_list_span(predicate_t *predicate, mmzk_list_t *list);
 
 
+/* Update */
+
+// Replace the INDEX-th element of LIST with ELEM, NULL if out of bound, i.e. take INDEX LIST ++ ELEM : drop (INDEX + 1)
+// LIST.
+// Only the nodes up to INDEX are copied, and the rest is shared. If LIST is not persistent, its leading nodes that are
+// not shared with other lists are updated in place.
+// O(INDEX).
+mmzk_list_t *mmzk_list_set(size_t index, const void *elem, mmzk_list_t *list);
+
+// Replace the element at each of the K INDICES of LIST with the corresponding element in ELEMS, NULL if any index is
+// out of bound. INDICES must be sorted in ascending order; if an index appears more than once, the last update wins.
+// The prefix up to the last index is copied once, and the rest is shared, as mmzk_list_set().
+// O(k + the last index).
+mmzk_list_t *mmzk_list_set_many(size_t k, const size_t indices[], void *elems[], mmzk_list_t *list);
+
+
 /* Transformation */
 
 // Transform LIST by applying WORKER on each element, i.e. map WORKER LIST.
-// Inputs to WORKER are not copied, thus it is WORKER's responsibility to return a new instance.
+// Inputs to WORKER are not copied, thus it is WORKER's responsibility to return a new instance. The results are taken
+// over by the new list without being copied.
 // O(n) not considering the time complexity of WORKER.
 mmzk_list_t *mmzk_list_map(mmzk_funs_t funs, void *(*worker)(const void *, void *), mmzk_list_t *list, void *);
 
@@ -169,6 +381,109 @@ void *mmzk_list_fold_left(void *(*worker)(void *, const void *), void *init, mmz
 // O(n) not considering the time complexity of WORKER.
 void *mmzk_list_fold_right(void *(*worker)(const void *, void *), void *init, mmzk_list_t *list);
 
+// Running results of folding LIST from the left, i.e. scanl WORKER INIT LIST. The result starts with a copy of INIT
+// and is one longer than LIST; its elements are managed by FUNS.
+// WORKER takes the previous result, an element of LIST and ARG. Inputs to WORKER are not copied, thus it is WORKER's
+// responsibility to return a new instance.
+// The result is built from front to back in one pass, without an intermediate list.
+// O(n) not considering the time complexity of WORKER.
+mmzk_list_t *mmzk_list_scan_left(mmzk_funs_t funs, void *(*worker)(const void *, const void *, void *),
+    const void *init, mmzk_list_t *list, void *arg);
+
+// Same as mmzk_list_scan_left(), but LIST is cut into up to THREADS segments that are scanned concurrently in two
+// passes: the segments are first reduced to the value each of them starts from, and then scanned from those values.
+// WORKER must be associative, the elements of LIST must be managed by FUNS as well, and WORKER must be safe to call
+// from several threads at once. It is called about twice as often as by mmzk_list_scan_left(). Short lists and lists
+// in a region are scanned on the calling thread alone.
+// O(n) not considering the time complexity of WORKER.
+mmzk_list_t *mmzk_list_scan_left_parallel(mmzk_funs_t funs, void *(*worker)(const void *, const void *, void *),
+    const void *init, mmzk_list_t *list, void *arg, size_t threads);
+
+// Running results of folding LIST from the right, i.e. scanr WORKER INIT LIST. The result ends with a copy of INIT and
+// is one longer than LIST; its elements are managed by FUNS.
+// WORKER takes an element of LIST, the result to its right and ARG. Inputs to WORKER are not copied, thus it is
+// WORKER's responsibility to return a new instance.
+// O(n) not considering the time complexity of WORKER.
+mmzk_list_t *mmzk_list_scan_right(mmzk_funs_t funs, void *(*worker)(const void *, const void *, void *),
+    const void *init, mmzk_list_t *list, void *arg);
+
+// Sort LIST stably by COMPARATOR, i.e. sortBy COMPARATOR LIST.
+// If LIST is not persistent, its nodes that are not shared with other lists are relinked instead of copied.
+// O(n log n) not considering the time complexity of COMPARATOR; O(n) if LIST is already sorted or reversely sorted.
+mmzk_list_t *mmzk_list_sort(comparator_t *comparator, mmzk_list_t *list);
+
+// Same as mmzk_list_sort(), but LIST is cut into up to THREADS segments that are sorted concurrently before being
+// merged. Short lists are sorted on the calling thread alone.
+mmzk_list_t *mmzk_list_sort_parallel(comparator_t *comparator, mmzk_list_t *list, size_t threads);
+
+
+/* Zipping */
+
+// Functions for lists of pairs, such as the results of mmzk_list_zip().
+// Copying a pair only increments its counter; the elements in the pair are freed with the last copy.
+extern const mmzk_funs_t mmzk_pair_funs;
+
+// New pair of FST and SND, i.e. (FST, SND), which are copied by FST_FUNS and SND_FUNS respectively.
+// The pair must be deallocated via the FREE_FUN of mmzk_pair_funs.
+// O(1).
+mmzk_pair_t *mmzk_pair_new(mmzk_funs_t fst_funs, const void *fst, mmzk_funs_t snd_funs, const void *snd);
+
+// The first element of PAIR, i.e. fst PAIR. The result belongs to PAIR and should not be deallocated.
+// O(1).
+const void *mmzk_pair_fst(const mmzk_pair_t *pair);
+
+// The second element of PAIR, i.e. snd PAIR. The result belongs to PAIR and should not be deallocated.
+// O(1).
+const void *mmzk_pair_snd(const mmzk_pair_t *pair);
+
+// Combine LIST1 and LIST2 element-wise by WORKER, i.e. zipWith WORKER LIST1 LIST2.
+// The result is as long as the shorter list, and is persistent if either list is.
+// Inputs to WORKER are not copied, thus it is WORKER's responsibility to return a new instance.
+// O(n) not considering the time complexity of WORKER.
+mmzk_list_t *mmzk_list_zip_with(mmzk_funs_t funs, void *(*worker)(const void *, const void *, void *),
+    mmzk_list_t *list1, mmzk_list_t *list2, void *);
+
+// Pair up the elements of LIST1 and LIST2, i.e. zip LIST1 LIST2.
+// The result has mmzk_pair_funs as its functions, and is as long as the shorter list. It is persistent if either list
+// is.
+// Elements of a non-persistent list are moved into the pairs instead of copied unless they are shared with other lists.
+// O(n).
+mmzk_list_t *mmzk_list_zip(mmzk_list_t *list1, mmzk_list_t *list2);
+
+// Split LIST of pairs into the list of first elements and the list of second elements, i.e. unzip LIST.
+// FST_FUNS and SND_FUNS are the functions of the resulting lists, and must agree with those stored in the pairs.
+// O(n).
+mmzk_list_tuple_t mmzk_list_unzip(mmzk_funs_t fst_funs, mmzk_funs_t snd_funs, mmzk_list_t *list);
+
+
+/* Grouping */
+
+// Functions for lists of lists, such as the groups of mmzk_list_group_by_key().
+// Copying and freeing a list follow mmzk_list_copy() and mmzk_list_free(); there is no hash function.
+extern const mmzk_funs_t mmzk_list_funs;
+
+// Remove the later occurrences of duplicated elements in LIST, i.e. nub LIST.
+// Elements are looked up in a hash table by the HASH_FUN of LIST, or compared with every distinct element so far if it
+// is NULL.
+// O(n) expected with a hash function, O(n^2) otherwise.
+mmzk_list_t *mmzk_list_nub(mmzk_list_t *list);
+
+// Group the elements of LIST by the keys KEY computes for them, i.e. Map.toList (Map.fromListWith (flip (++)) [(KEY X,
+// [X]) | X <- LIST]) but ordered by the first occurrence of each key.
+// The result is a list of pairs (see mmzk_list_zip()), each of a key managed by KEY_FUNS and a list of the elements
+// with that key managed by mmzk_list_funs, in the same order as in LIST. KEY must return a new instance, and keys are
+// looked up in a hash table by KEY_FUNS as in mmzk_list_nub().
+// Elements of a non-persistent list are moved into the groups instead of copied unless they are shared with other
+// lists.
+// O(n) expected not considering the time complexity of KEY.
+mmzk_list_t *mmzk_list_group_by_key(mmzk_funs_t key_funs, void *(*key)(const void *, void *), mmzk_list_t *list,
+    void *arg);
+
+// Split LIST into the elements that satisfy PREDICATE and those that do not in one pass, i.e. partition PREDICATE LIST.
+// Elements of a non-persistent list are moved instead of copied unless they are shared with other lists.
+// O(n) not considering the time complexity of PREDICATE.
+mmzk_list_tuple_t mmzk_list_partition(predicate_t *predicate, mmzk_list_t *list);
+
 
 /* Iteration */
 
@@ -192,4 +507,64 @@ bool mmzk_list_has_next(mmzk_list_iterator_t iterator);
 // O(1).
 void *mmzk_list_yield(mmzk_list_iterator_t *iterator);
 
+// Store up to N elements of the iterator in BUF and move past them, returning how many are stored (0 at the end).
+// As with mmzk_list_yield(), the elements belong to the list and should not be deallocated. The elements are
+// prefetched as they are stored, so consuming a block after it is filled is cheaper than yielding one by one.
+// O(N).
+size_t mmzk_list_yield_many(mmzk_list_iterator_t *iterator, void *buf[], size_t n);
+
+
+/* Atomic References */
+
+// Atomic reference outline:
+// mmzk_list_ref_t *ref = mmzk_list_ref_new(list);
+// ... in reader threads:
+// mmzk_list_t *snapshot = mmzk_list_ref_load(ref);
+// ... read snapshot ...
+// mmzk_list_ref_release(ref, snapshot);
+// ... in writer threads:
+// mmzk_list_ref_store(ref, new_list);
+// mmzk_list_ref_update(ref, &fn, arg);
+//
+// Readers never wait: loading a snapshot only counts the current version, which is protected by a hazard pointer
+// while it is being counted, and releasing it only drops the count. A version that is no longer current is freed by
+// the next writer once its last snapshot is released, and no reader is about to count it. Writers are serialised by a
+// lock, because the nodes shared between versions are reference counted by plain integers; for the same reason, the
+// lists in a cell never share nodes with lists outside it.
+//
+// A snapshot is a list of its own, so it can be queried and iterated like any other list, but its nodes belong to the
+// cell: it must not be freed with mmzk_list_free(), consumed (set non-persistent), or passed to any function that
+// shares nodes with its result, such as mmzk_list_copy(), mmzk_list_cons() or mmzk_list_drop(), which assert that
+// they are not given a snapshot. Elements that are needed after the snapshot is released should be copied out, e.g.
+// with mmzk_list_to_array(). Queries on a snapshot never build a hash or skip index, so that they take no lock; they
+// are linear in the length of the snapshot.
+
+// New cell holding the elements of LIST, which is copied (or taken over if it is not persistent). LIST must not be in
+// a region.
+// O(n).
+mmzk_list_ref_t *mmzk_list_ref_new(mmzk_list_t *list);
+
+// Free REF with the lists in it. All snapshots must have been released, and no other thread may use REF.
+void mmzk_list_ref_free(mmzk_list_ref_t *ref);
+
+// A snapshot of the current list of REF, which must be released with mmzk_list_ref_release(). Lock-free.
+// O(1) expected.
+mmzk_list_t *mmzk_list_ref_load(mmzk_list_ref_t *ref);
+
+// Release SNAPSHOT, which was loaded from REF and must not be used afterwards. Lock-free.
+// O(1).
+void mmzk_list_ref_release(mmzk_list_ref_t *ref, mmzk_list_t *snapshot);
+
+// Replace the list of REF with the elements of LIST, which is copied (or taken over if it is not persistent) before
+// the lock is taken. LIST must not be in a region.
+// O(n).
+void mmzk_list_ref_store(mmzk_list_ref_t *ref, mmzk_list_t *list);
+
+// Replace the list of REF with FN (CURRENT, ARG), where CURRENT is the current list, atomically with respect to other
+// writers. FN must not free or keep CURRENT, and must return the new list (not in a region, possibly CURRENT itself),
+// which REF takes over. It may combine CURRENT with other lists only if no other thread uses them, since the result
+// shares nodes with them.
+// O(1) not considering the time complexity of FN.
+void mmzk_list_ref_update(mmzk_list_ref_t *ref, mmzk_list_t *(*fn)(mmzk_list_t *, void *), void *arg);
+
 #endif /* MMZK_LIST_H */
@@ -23,13 +23,20 @@ typedef void *mmzk_copy_fun(const void *);
 typedef void mmzk_free_fun(void *);
 #endif /* MMZKTYPEDEF_FREE_FUN */
 
+#ifndef MMZKTYPEDEF_HASH_FUN
+#define MMZKTYPEDEF_HASH_FUN
+typedef size_t mmzk_hash_fun(const void *);
+#endif /* MMZKTYPEDEF_HASH_FUN */
+
 #define UNREACHABLE(X) (assert(false), X);
 
 // Necessary functions for a list.
 //
 // EQ_FUN determines structural equality for the elements;
 // COPY_FUN is called to create copies of elements;
-// FREE_FUN is called to free elements when the node they live in is freed.
+// FREE_FUN is called to free elements when the node they live in is freed;
+// HASH_FUN is optional (NULL if not given); if given, equal elements must have the same hash, and it enables hash-based
+// lookups such as the hash index of mmzk_list_is_elem().
 //
 // If COPY_FUN always creates a new instance, then FREE_FUN must always free this instance. In this case, we can modify
 // the original element arbitrarily without affecting the element in the list.
@@ -44,21 +51,56 @@ typedef struct mmzk_funs {
   mmzk_eq_fun *eq_fun;
   mmzk_copy_fun *copy_fun;
   mmzk_free_fun *free_fun;
+  mmzk_hash_fun *hash_fun;
 } mmzk_funs_t;
 
 // A predicate type.
 typedef bool predicate_t(const void *);
 
+// A comparator type. As with qsort, the result is negative, zero or positive if the first argument is respectively less
+// than, equal to or greater than the second.
+typedef int comparator_t(const void *, const void *);
+
 // A persistent and functional list structure similar to Haskell's [], but it is strict.
 // The elements are of type const void * and they should not be modified.
+//
+// If mmzklist.c is compiled with MMZK_COMPACT_NODES defined, the nodes are 16 bytes and live in 64 KiB pooled blocks,
+// linked by 32-bit indices instead of pointers. This saves memory and cache at the cost of an extra lookup per step,
+// and limits the number of live nodes to about 2^32. Pooled blocks are kept for reuse rather than returned to the
+// system.
 typedef struct mmzk_list mmzk_list_t;
 
+// A mutable builder that produces a strict list from front to back.
+typedef struct mmzk_list_builder mmzk_list_builder_t;
+
+// A region that strict lists can be created in, which owns all of their memory until it is destroyed.
+typedef struct mmzk_region mmzk_region_t;
+
+// A cell holding a strict list that several threads can read and replace at once; see mmzk_list_ref_load().
+typedef struct mmzk_list_ref mmzk_list_ref_t;
+
+// A pair of elements, managed by the functions of their respective lists.
+typedef struct mmzk_pair mmzk_pair_t;
+
 // Tuple of strict lists.
 typedef struct mmzk_list_tuple {
   mmzk_list_t *fst;
   mmzk_list_t *snd;
 } mmzk_list_tuple_t;
 
+// Memory held by the nodes of one or more strict lists; see mmzk_list_memory_report().
+// REACHABLE counts the nodes that are kept alive by the lists, of which UNIQUE are kept alive by them alone and SHARED
+// are also referred to by other lists. BEYOND_LENGTH counts the reachable nodes that lie past the length of every list.
+// The byte counts only cover the nodes, not the elements.
+typedef struct mmzk_list_memory_report {
+  size_t reachable;
+  size_t unique;
+  size_t shared;
+  size_t beyond_length;
+  size_t node_bytes;
+  size_t bytes_beyond_length;
+} mmzk_list_memory_report_t;
+
 // Iterator for the strict list type.
 typedef struct mmzk_list_iterator {
   size_t length;
@@ -75,13 +117,29 @@ typedef struct mmzk_llist_tuple {
   mmzk_llist_t *snd;
 } mmzk_llist_tuple_t;
 
+// One step of a lazy list. RESULT is the element produced, which the list copies, and GENERATOR produces the next step
+// from ARG. A NULL GENERATOR marks the end of the list.
+// If not NULL, RELEASE frees ARG when the list is freed before GENERATOR is called on it.
 typedef struct mmzk_lframe {
   const void *result;
   const void *arg;
   struct mmzk_lframe (*generator)(const void *);
+  void (*release)(const void *);
 } mmzk_lframe_t;
 
 typedef struct mmzk_lframe mmzk_lframe_gen_t(const void *);
+typedef void mmzk_lframe_release_t(const void *);
+
+// Ephemeral iterator for the lazy list type. See mmzk_llist_iterator().
+typedef struct mmzk_llist_iterator {
+  mmzk_funs_t funs;
+  struct node *node;
+  struct node *last;
+  mmzk_lframe_t frame;
+  const void *current;
+  bool is_ready;
+  size_t memoized;
+} mmzk_llist_iterator_t;
 typedef const void *mmzk_pure_gen_t(const void *);
 
 #endif /* MMZK_LIST_BASE_H */
@@ -1,9 +1,16 @@
+#include <errno.h>
+#include <fcntl.h>
 #include <iso646.h>
 #include <math.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
 #include <stdbool.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <time.h>
+#include <unistd.h>
 #include "mmzkllist.h"
 
 
@@ -14,15 +21,65 @@ struct array_len {
   const void **elems;
 };
 
+// CUR is the latest element generated, which is freed by FREE_FUN once the next one is generated. The seed is owned by
+// the caller, hence OWNS_CUR.
 struct pure_gen {
   const void *cur;
+  bool owns_cur;
   mmzk_pure_gen_t *generator;
+  mmzk_free_fun *free_fun;
 };
 
-mmzk_lframe_t array_gen(const void *ptr) {
+// The initial size of the buffer of a stream. It only grows if a record does not fit.
+#define STREAM_BUFFER_SIZE 65536
+
+// The state of a list read from a file descriptor. The bytes in [START, END) of BUFFER have been read but not consumed.
+// RECORD refers to the latest record in BUFFER, and is only valid until the next read. Its terminator overwrites the
+// byte at HELD_AT, which is kept in HELD until the next record is read.
+struct stream {
+  int fd;
+  bool owns_fd;
+  mmzk_record_kind_t kind;
+  bool is_eof;
+  char *buffer;
+  size_t capacity;
+  size_t start;
+  size_t end;
+  mmzk_record_t record;
+  bool is_holding;
+  size_t held_at;
+  char held;
+};
+
+// The state of a generator running on a background thread.
+// The worker evaluates FRAME and pushes copies of the results to the single-producer single-consumer ring SLOTS, whose
+// positions HEAD (written by the worker) and TAIL (written by the consumer) only increase. At most LIMIT elements are
+// buffered. CURRENT is the element last handed to the list, which is freed on the next step.
+// The worker is detached, and the state is freed by whichever of the worker and the list lets go of it last, as
+// counted by REF_COUNT.
+struct readahead {
+  mmzk_funs_t funs;
+  mmzk_lframe_t frame;
+  pthread_t worker;
+  size_t limit;
+  size_t mask;
+  const void **slots;
+  _Alignas(64) atomic_size_t head;
+  _Alignas(64) atomic_size_t tail;
+  atomic_bool is_done;
+  atomic_bool is_stopped;
+  atomic_int ref_count;
+  const void *current;
+};
+
+static void free_arg(const void *ptr) {
+  free((void *)ptr);
+}
+
+static mmzk_lframe_t array_gen(const void *ptr) {
   struct array_len *array_len = (struct array_len *)ptr;
   if (array_len->len == 0) {
-    free(ptr);
+    free_arg(ptr);
     return (mmzk_lframe_t){ .generator = NULL };
   }
 
@@ -30,30 +87,302 @@ mmzk_lframe_t array_gen(const void *ptr) {
   array_len->elems = array_len->elems + 1;
   array_len->len--;
 
-  return (mmzk_lframe_t){ .arg = array_len, .result = elem, .generator = array_gen };
+  return (mmzk_lframe_t){ .arg = array_len, .result = elem, .generator = array_gen, .release = free_arg };
+}
+
+static void pure_gen_release(const void *ptr) {
+  struct pure_gen *pure_gen = (struct pure_gen *)ptr;
+  if (pure_gen->owns_cur) {
+    (pure_gen->free_fun)((void *)pure_gen->cur);
+  }
+  free(pure_gen);
 }
 
-mmzk_lframe_t generator_gen(const void *ptr) {
+static mmzk_lframe_t generator_gen(const void *ptr) {
   struct pure_gen *pure_gen = (struct pure_gen *)ptr;
   const void *elem = (pure_gen->generator)(pure_gen->cur);
   if (elem == NULL) {
-    free(ptr);
+    pure_gen_release(pure_gen);
     return (mmzk_lframe_t){ .generator = NULL };
   }
 
+  // The list has copied the previous element by now, or is done with it if it is not memoized.
+  if (pure_gen->owns_cur) {
+    (pure_gen->free_fun)((void *)pure_gen->cur);
+  }
   pure_gen->cur = elem;
+  pure_gen->owns_cur = true;
+
+  return (mmzk_lframe_t){ .arg = pure_gen, .result = elem, .generator = generator_gen, .release = pure_gen_release };
+}
+
+static void stream_release(const void *ptr) {
+  struct stream *stream = (struct stream *)ptr;
+  if (stream->owns_fd) {
+    close(stream->fd);
+  }
+  free(stream->buffer);
+  free(stream);
+}
+
+// Move the unconsumed bytes to the front of the buffer, growing it if it is full, then read more bytes.
+// Returns false if nothing more can be read.
+static bool stream_fill(struct stream *stream) {
+  if (stream->is_eof) {
+    return false;
+  }
+
+  if (stream->start > 0) {
+    memmove(stream->buffer, stream->buffer + stream->start, stream->end - stream->start);
+    stream->end -= stream->start;
+    stream->start = 0;
+  }
+
+  if (stream->end == stream->capacity) {
+    stream->capacity *= 2;
+    stream->buffer = realloc(stream->buffer, stream->capacity);
+  }
+
+  ssize_t count;
+  do {
+    count = read(stream->fd, stream->buffer + stream->end, stream->capacity - stream->end);
+  } while (count < 0 && errno == EINTR);
+
+  if (count <= 0) {
+    stream->is_eof = true;
+    return false;
+  }
+
+  stream->end += (size_t)count;
+  return true;
+}
+
+// Point the record of STREAM at the SIZE bytes from OFFSET in the buffer, and consume them up to NEXT.
+// The record is terminated in place, so the buffer grows if the record reaches its end.
+static void stream_emit(struct stream *stream, size_t offset, size_t size, size_t next) {
+  if (offset + size == stream->capacity) {
+    stream->capacity *= 2;
+    stream->buffer = realloc(stream->buffer, stream->capacity);
+  }
+
+  stream->is_holding = true;
+  stream->held_at = offset + size;
+  stream->held = stream->buffer[stream->held_at];
+  stream->buffer[stream->held_at] = '\0';
+  stream->record.data = stream->buffer + offset;
+  stream->record.size = size;
+  stream->start = next;
+}
+
+static bool stream_next_line(struct stream *stream) {
+  size_t scanned = 0;
+
+  while (true) {
+    char *newline = memchr(stream->buffer + stream->start + scanned, '\n', stream->end - stream->start - scanned);
+    if (newline != NULL) {
+      size_t size = (size_t)(newline - stream->buffer) - stream->start;
+      stream_emit(stream, stream->start, size, stream->start + size + 1);
+      return true;
+    }
+
+    scanned = stream->end - stream->start;
+    if (!stream_fill(stream)) {
+      break;
+    }
+  }
+
+  if (stream->end == stream->start) {
+    return false;
+  }
+
+  stream_emit(stream, stream->start, stream->end - stream->start, stream->end);
+  return true;
+}
+
+static bool stream_next_frame(struct stream *stream) {
+  while (stream->end - stream->start < 4) {
+    if (!stream_fill(stream)) {
+      return false;
+    }
+  }
+
+  const unsigned char *header = (const unsigned char *)stream->buffer + stream->start;
+  size_t size = (size_t)header[0] << 24 | (size_t)header[1] << 16 | (size_t)header[2] << 8 | (size_t)header[3];
+
+  while (stream->end - stream->start < 4 + size) {
+    if (!stream_fill(stream)) {
+      return false;
+    }
+  }
+
+  stream_emit(stream, stream->start + 4, size, stream->start + 4 + size);
+  return true;
+}
+
+static mmzk_lframe_t stream_gen(const void *ptr) {
+  struct stream *stream = (struct stream *)ptr;
+  if (stream->is_holding) {
+    stream->buffer[stream->held_at] = stream->held;
+    stream->is_holding = false;
+  }
+
+  bool has_next = stream->kind == MMZK_RECORD_LINE ? stream_next_line(stream) : stream_next_frame(stream);
+  if (!has_next) {
+    stream_release(stream);
+    return (mmzk_lframe_t){ .generator = NULL };
+  }
+
+  return (mmzk_lframe_t){
+    .arg = stream, .result = &stream->record, .generator = stream_gen, .release = stream_release
+  };
+}
+
+// Wait for the other side of a ring: spin briefly, then yield, then sleep.
+static void backoff(unsigned int *spins) {
+  if (*spins >= 1024) {
+    nanosleep(&(struct timespec){ .tv_sec = 0, .tv_nsec = 50000 }, NULL);
+  } else if (*spins >= 64) {
+    sched_yield();
+  }
+  (*spins)++;
+}
+
+// Let go of READAHEAD from either side, freeing the buffered elements and whatever is left of the original generator
+// if the other side has let go already.
+static void readahead_drop(struct readahead *readahead) {
+  if (atomic_fetch_sub_explicit(&readahead->ref_count, 1, memory_order_acq_rel) > 1) {
+    return;
+  }
+
+  size_t head = atomic_load_explicit(&readahead->head, memory_order_relaxed);
+  for (size_t i = atomic_load_explicit(&readahead->tail, memory_order_relaxed); i != head; i++) {
+    (readahead->funs.free_fun)((void *)readahead->slots[i & readahead->mask]);
+  }
+  if (readahead->frame.generator != NULL && readahead->frame.release != NULL) {
+    (readahead->frame.release)(readahead->frame.arg);
+  }
+
+  free(readahead->slots);
+  free(readahead);
+}
+
+static void *readahead_worker(void *ptr) {
+  struct readahead *readahead = ptr;
+  size_t head = atomic_load_explicit(&readahead->head, memory_order_relaxed);
+
+  while (!atomic_load_explicit(&readahead->is_stopped, memory_order_relaxed)) {
+    mmzk_lframe_t frame = (readahead->frame.generator)(readahead->frame.arg);
+    if (frame.generator == NULL) {
+      readahead->frame.generator = NULL;
+      break;
+    }
+    readahead->frame = frame;
+    if (atomic_load_explicit(&readahead->is_stopped, memory_order_relaxed)) {
+      break;
+    }
+    const void *elem = (readahead->funs.copy_fun)(frame.result);
+
+    unsigned int spins = 0;
+    while (head - atomic_load_explicit(&readahead->tail, memory_order_acquire) == readahead->limit) {
+      if (atomic_load_explicit(&readahead->is_stopped, memory_order_relaxed)) {
+        (readahead->funs.free_fun)((void *)elem);
+        goto stopped;
+      }
+      backoff(&spins);
+    }
+
+    readahead->slots[head & readahead->mask] = elem;
+    atomic_store_explicit(&readahead->head, ++head, memory_order_release);
+  }
+
+stopped:
+  atomic_store_explicit(&readahead->is_done, true, memory_order_release);
+  readahead_drop(readahead);
+  return NULL;
+}
+
+// Stop the worker without waiting for it, since it may be blocked in the generator (e.g. reading a pipe). The rest is
+// freed when the worker exits, unless it has already.
+static void readahead_release(const void *ptr) {
+  struct readahead *readahead = (struct readahead *)ptr;
+  atomic_store_explicit(&readahead->is_stopped, true, memory_order_relaxed);
+  if (readahead->current != NULL) {
+    (readahead->funs.free_fun)((void *)readahead->current);
+    readahead->current = NULL;
+  }
+
+  readahead_drop(readahead);
+}
+
+static mmzk_lframe_t readahead_gen(const void *ptr) {
+  struct readahead *readahead = (struct readahead *)ptr;
+  size_t tail = atomic_load_explicit(&readahead->tail, memory_order_relaxed);
+
+  if (readahead->current != NULL) {
+    (readahead->funs.free_fun)((void *)readahead->current);
+    readahead->current = NULL;
+  }
+
+  unsigned int spins = 0;
+  while (atomic_load_explicit(&readahead->head, memory_order_acquire) == tail) {
+    // The worker pushes its last element before it is done, so the ring must be checked again.
+    if (atomic_load_explicit(&readahead->is_done, memory_order_acquire)
+        && atomic_load_explicit(&readahead->head, memory_order_acquire) == tail) {
+      readahead_release(readahead);
+      return (mmzk_lframe_t){ .generator = NULL };
+    }
+    backoff(&spins);
+  }
+
+  readahead->current = readahead->slots[tail & readahead->mask];
+  atomic_store_explicit(&readahead->tail, tail + 1, memory_order_release);
 
-  return (mmzk_lframe_t){ .arg = pure_gen, .result = elem, .generator = generator_gen };
+  return (mmzk_lframe_t){
+    .arg = readahead, .result = readahead->current, .generator = readahead_gen, .release = readahead_release
+  };
 }
 
+// Take over the element that readahead_gen() last returned, which is then no longer freed on the next step.
+static const void *readahead_adopt(struct readahead *readahead) {
+  const void *elem = readahead->current;
+  readahead->current = NULL;
+  return elem;
+}
+
+static bool record_eq(const void *r1, const void *r2) {
+  const mmzk_record_t *record1 = r1;
+  const mmzk_record_t *record2 = r2;
+  return record1->size == record2->size && memcmp(record1->data, record2->data, record1->size) == 0;
+}
+
+// The record and its data are allocated together.
+static void *record_copy(const void *r) {
+  const mmzk_record_t *record = r;
+  mmzk_record_t *result = malloc(sizeof(mmzk_record_t) + record->size + 1);
+  char *data = (char *)(result + 1);
+  memcpy(data, record->data, record->size);
+  data[record->size] = '\0';
+  result->data = data;
+  result->size = record->size;
+  return result;
+}
+
+static void record_free(void *r) {
+  free(r);
+}
+
+const mmzk_funs_t mmzk_record_funs = { record_eq, record_copy, record_free, NULL };
+
 
 /* Definitions */
 
+// A node is either unevaluated (GENERATOR is not NULL), a cons cell (NEXT is not NULL), or the end of the list.
 typedef struct node {
   unsigned int prev_count;
   const void *elem;
   struct node *next;
   mmzk_lframe_gen_t *generator;
+  mmzk_lframe_release_t *release;
   const void *arg;
 } node_t;
 
@@ -62,6 +391,59 @@ struct mmzk_llist {
   node_t *node;
 };
 
+// New unevaluated node that continues from FRAME.
+static node_t *_new_node(mmzk_lframe_t frame) {
+  node_t *node = malloc(sizeof(node_t));
+  node->prev_count = 0;
+  node->next = NULL;
+  node->generator = frame.generator;
+  node->release = frame.release;
+  node->arg = frame.arg;
+
+  return node;
+}
+
+// Evaluate NODE if it has not been, copying the element produced by its generator.
+// The elements of a readahead are copies made by its thread already, so they are taken over instead.
+static void _force(mmzk_funs_t funs, node_t *node) {
+  if (node->generator == NULL) {
+    return;
+  }
+
+  bool is_ahead = node->generator == readahead_gen;
+  const void *arg = node->arg;
+  mmzk_lframe_t frame = (node->generator)(arg);
+  node->generator = NULL;
+  node->release = NULL;
+  node->arg = NULL;
+
+  if (frame.generator != NULL) {
+    node->elem = is_ahead ? readahead_adopt((struct readahead *)arg) : (funs.copy_fun)(frame.result);
+    node->next = _new_node(frame);
+  }
+}
+
+// Release the reference to the chain starting at NODE, freeing the nodes that are not referred to by anything else.
+static void _free_nodes(mmzk_funs_t funs, node_t *node) {
+  while (node != NULL) {
+    if (node->prev_count > 0) {
+      node->prev_count--;
+      break;
+    }
+
+    node_t *next = node->next;
+    if (node->generator != NULL) {
+      if (node->release != NULL) {
+        (node->release)(node->arg);
+      }
+    } else if (next != NULL) {
+      (funs.free_fun)((void *)node->elem);
+    }
+    free(node);
+    node = next;
+  }
+}
+
 
 /* Construction & Destruction */
 
@@ -81,11 +463,13 @@ mmzk_llist_t *mmzk_llist_from_array(mmzk_funs_t funs, size_t len, const void *el
   list->funs = funs;
   list->node = malloc(sizeof(node_t));
   list->node->prev_count = 0;
+  list->node->next = NULL;
   struct array_len *array_len = malloc(sizeof(struct array_len));
   array_len->len = len;
   array_len->elems = elems;
   list->node->arg = array_len;
   list->node->generator = array_gen;
+  list->node->release = free_arg;
 
   return list;
 }
@@ -96,96 +480,250 @@ mmzk_llist_t *mmzk_llist_from_generator(mmzk_funs_t funs, mmzk_pure_gen_t *gener
   list->node = malloc(sizeof(node_t));
   struct pure_gen *pure_gen = malloc(sizeof(struct pure_gen));
   pure_gen->generator = generator;
+  pure_gen->free_fun = funs.free_fun;
   pure_gen->cur = seed;
+  pure_gen->owns_cur = false;
   list->node->prev_count = 0;
+  list->node->next = NULL;
   list->node->arg = pure_gen;
   list->node->generator = generator_gen;
+  list->node->release = pure_gen_release;
 
   return list;
 }
 
+mmzk_llist_t *mmzk_llist_from_fd(int fd, mmzk_record_kind_t kind) {
+  mmzk_llist_t *list = malloc(sizeof(mmzk_llist_t));
+  list->funs = mmzk_record_funs;
+  struct stream *stream = malloc(sizeof(struct stream));
+  stream->fd = fd;
+  stream->owns_fd = false;
+  stream->kind = kind;
+  stream->is_eof = false;
+  stream->capacity = STREAM_BUFFER_SIZE;
+  stream->buffer = malloc(stream->capacity);
+  stream->start = 0;
+  stream->end = 0;
+  stream->is_holding = false;
+  list->node = _new_node((mmzk_lframe_t){ .arg = stream, .generator = stream_gen, .release = stream_release });
 
+  return list;
+}
 
+mmzk_llist_t *mmzk_llist_from_file(const char *path, mmzk_record_kind_t kind) {
+  int fd = open(path, O_RDONLY | O_CLOEXEC);
+  if (fd < 0) {
+    return NULL;
+  }
 
+  mmzk_llist_t *list = mmzk_llist_from_fd(fd, kind);
+  ((struct stream *)list->node->arg)->owns_fd = true;
 
+  return list;
+}
 
-bool int_eq(const void *i1, const void *i2) {
-  return *(int *)i1 == *(int *)i2;
+void mmzk_llist_free(mmzk_llist_t *list) {
+  _free_nodes(list->funs, list->node);
+  free(list);
 }
 
-void *int_copy(const void *i1) {
-  int *result = malloc(sizeof(int));
-  *result = *(int *)i1;
+mmzk_llist_t *mmzk_llist_copy(mmzk_llist_t *list) {
+  mmzk_llist_t *result = malloc(sizeof(mmzk_llist_t));
+  result->funs = list->funs;
+  result->node = list->node;
+  list->node->prev_count++;
+
   return result;
 }
 
-void int_free(const void *i1) {
-  free(i1);
+
+/* Query */
+
+bool mmzk_llist_is_empty(mmzk_llist_t *list) {
+  _force(list->funs, list->node);
+  return list->node->next == NULL;
+}
+
+void *mmzk_llist_head(mmzk_llist_t *list) {
+  if (mmzk_llist_is_empty(list)) {
+    return NULL;
+  }
+
+  return (list->funs.copy_fun)(list->node->elem);
+}
+
+
+/* Decomposition */
+
+mmzk_llist_t *mmzk_llist_tail(mmzk_llist_t *list) {
+  if (mmzk_llist_is_empty(list)) {
+    return NULL;
+  }
+
+  mmzk_llist_t *result = malloc(sizeof(mmzk_llist_t));
+  result->funs = list->funs;
+  result->node = list->node->next;
+  result->node->prev_count++;
+
+  return result;
 }
 
-void dump_int_list(mmzk_llist_t *list) {
+
+/* Evaluation */
+
+bool mmzk_llist_readahead(mmzk_llist_t *list, size_t n) {
   node_t *node = list->node;
-  
-  while (node->generator != NULL || node->next != NULL) {
-    const void *elem;
-    if (node->generator == NULL) {
-      elem = node->elem;
-    } else {
-      mmzk_lframe_t frame = (node->generator)(node->arg);
-      if (frame.generator == NULL) {
-        break;
-      }
-      node->elem = (list->funs.copy_fun)(frame.result);
-      node->generator = NULL;
-      node->arg = NULL;
-      node->next = malloc(sizeof(node_t));
-      node->next->prev_count = 0;
-      node->next->arg = frame.arg;
-      node->next->generator = frame.generator;
+  while (node->generator == NULL) {
+    if (node->next == NULL) {
+      return false;
     }
-    printf("%d --> ", *(int *)(node->elem));
     node = node->next;
   }
-  printf("nil");
+
+  struct readahead *readahead = malloc(sizeof(struct readahead));
+  size_t capacity = 1;
+  while (capacity < n) {
+    capacity *= 2;
+  }
+  readahead->funs = list->funs;
+  readahead->frame = (mmzk_lframe_t){ .arg = node->arg, .generator = node->generator, .release = node->release };
+  readahead->limit = n == 0 ? 1 : n;
+  readahead->mask = capacity - 1;
+  readahead->slots = malloc(capacity * sizeof(const void *));
+  atomic_init(&readahead->head, 0);
+  atomic_init(&readahead->tail, 0);
+  atomic_init(&readahead->is_done, false);
+  atomic_init(&readahead->is_stopped, false);
+  atomic_init(&readahead->ref_count, 2);
+  readahead->current = NULL;
+
+  if (pthread_create(&readahead->worker, NULL, readahead_worker, readahead) != 0) {
+    free(readahead->slots);
+    free(readahead);
+    return false;
+  }
+  pthread_detach(readahead->worker);
+
+  // The node is yet to be evaluated, so swapping its generator is invisible to every list that shares it.
+  node->generator = readahead_gen;
+  node->release = readahead_release;
+  node->arg = readahead;
+
+  return true;
 }
 
-int from_array_test() {
-  int *i1 = malloc(sizeof(int));
-  int *i2 = malloc(sizeof(int));
-  int *i3 = malloc(sizeof(int));
-  *i1 = 1;
-  *i2 = 2;
-  *i3 = 3;
 
-  mmzk_llist_t *l123 = mmzk_llist_from_array((mmzk_funs_t){&int_eq, &int_copy, &int_free}, 3, (const void *[3]){i1, i2, i3});
+/* Consumption */
+
+static mmzk_llist_retention_hook_t *retention_hook = NULL;
+
+mmzk_llist_iterator_t mmzk_llist_iterator(mmzk_llist_t *list) {
+  mmzk_llist_iterator_t iterator = {
+    .funs = list->funs, .node = list->node, .last = NULL, .frame = { .generator = NULL }, .is_ready = false,
+    .memoized = 0
+  };
+  free(list);
 
-  printf("l123 content: ");
-  dump_int_list(l123);
-  puts("");
+  return iterator;
+}
 
-  int_free(i1);
-  int_free(i2);
-  int_free(i3);
+bool mmzk_llist_has_next(mmzk_llist_iterator_t *iterator) {
+  if (iterator->is_ready) {
+    return true;
+  }
 
-  // mmzk_llist_free(l123);
+  // Moving past the last element frees its node unless it is shared.
+  if (iterator->last != NULL) {
+    _free_nodes(iterator->funs, iterator->last);
+    iterator->last = NULL;
+  }
+
+  node_t *node = iterator->node;
+  if (node != NULL) {
+    if (node->generator != NULL && node->prev_count == 0) {
+      // Nothing else can reach the rest, so it need not be memoized.
+      iterator->frame = (mmzk_lframe_t){ .arg = node->arg, .generator = node->generator, .release = node->release };
+      iterator->node = NULL;
+      free(node);
+    } else {
+      if (node->generator != NULL) {
+        _force(iterator->funs, node);
+        iterator->memoized += node->next != NULL;
+      }
+
+      if (node->next == NULL) {
+        mmzk_llist_iterator_close(iterator);
+        return false;
+      }
 
-  return EXIT_SUCCESS;
+      // Hold the next node before releasing this one.
+      iterator->current = node->elem;
+      iterator->last = node;
+      iterator->node = node->next;
+      node->next->prev_count++;
+      iterator->is_ready = true;
+      return true;
+    }
+  }
+
+  if (iterator->frame.generator == NULL) {
+    mmzk_llist_iterator_close(iterator);
+    return false;
+  }
+
+  mmzk_lframe_t frame = (iterator->frame.generator)(iterator->frame.arg);
+  iterator->frame = frame;
+  if (frame.generator == NULL) {
+    mmzk_llist_iterator_close(iterator);
+    return false;
+  }
+
+  iterator->current = frame.result;
+  iterator->is_ready = true;
+  return true;
+}
+
+const void *mmzk_llist_yield(mmzk_llist_iterator_t *iterator) {
+  iterator->is_ready = false;
+  return iterator->current;
 }
 
-const void *succ(const void *i1) {
-  int *result = malloc(sizeof(int *));
-  if (i1 != NULL) {
-    *result = 1 + *(int *)i1;
-  } else {
-    *result = 0;
+void mmzk_llist_iterator_close(mmzk_llist_iterator_t *iterator) {
+  if (iterator->last != NULL) {
+    _free_nodes(iterator->funs, iterator->last);
+    iterator->last = NULL;
   }
-  return result;
+
+  if (iterator->node != NULL) {
+    _free_nodes(iterator->funs, iterator->node);
+    iterator->node = NULL;
+  }
+
+  if (iterator->frame.generator != NULL) {
+    if (iterator->frame.release != NULL) {
+      (iterator->frame.release)(iterator->frame.arg);
+    }
+    iterator->frame.generator = NULL;
+  }
+
+  if (iterator->memoized > 0 && retention_hook != NULL) {
+    retention_hook(iterator->memoized);
+  }
+  iterator->memoized = 0;
+  iterator->is_ready = false;
 }
 
-int main(int argc, char **argv) {
-  // from_array_test();
-  mmzk_llist_t *nats = mmzk_llist_from_generator((mmzk_funs_t){&int_eq, &int_copy, &int_free}, succ, NULL);
-  dump_int_list(nats);
+void *mmzk_llist_fold_left(void *(*worker)(void *, const void *), void *init, mmzk_llist_t *list) {
+  mmzk_llist_iterator_t iterator = mmzk_llist_iterator(list);
+  void *result = init;
+
+  while (mmzk_llist_has_next(&iterator)) {
+    result = worker(result, mmzk_llist_yield(&iterator));
+  }
+
+  return result;
+}
 
-  return EXIT_SUCCESS;
+void mmzk_llist_set_retention_hook(mmzk_llist_retention_hook_t *hook) {
+  retention_hook = hook;
 }
@@ -5,9 +5,29 @@
 #ifndef MMZK_LLIST_H
 #define MMZK_LLIST_H
 
+#include <stdbool.h>
+#include <stddef.h>
 #include <stdint.h>
 #include "mmzklist_base.h"
 
+// A record read from a stream: SIZE bytes at DATA, which are followed by a NUL terminator not counted in SIZE.
+typedef struct mmzk_record {
+  size_t size;
+  const char *data;
+} mmzk_record_t;
+
+// How a stream is split into records.
+// MMZK_RECORD_LINE: lines terminated by '\n', which is not part of the record. The last line may lack the terminator.
+// MMZK_RECORD_FRAME: frames, each prefixed by its size as a 4-byte big-endian unsigned integer. A truncated last frame
+// is ignored.
+typedef enum mmzk_record_kind {
+  MMZK_RECORD_LINE,
+  MMZK_RECORD_FRAME
+} mmzk_record_kind_t;
+
+// Functions for lists of records, such as the results of mmzk_llist_from_fd().
+extern const mmzk_funs_t mmzk_record_funs;
+
 
 /* Construction & Destruction */
 
@@ -23,10 +43,23 @@ mmzk_llist_t *mmzk_llist_from_array(mmzk_funs_t funs, size_t len, const void *el
 // Construct list from the generating function GENERATOR, which produces the next element from the current one, starting
 // from SEED.
 // Note that SEED itself is not an element of the list, it's simply provided to GENERATOR to generate the first element.
-// GENERATOR must not free its input and must allocate a new instance for the result.
+// GENERATOR must not free its input and must allocate a new instance for the result, which is freed by the FREE_FUN of
+// FUNS once the next element has been generated from it.
 // O(1).
 mmzk_llist_t *mmzk_llist_from_generator(mmzk_funs_t funs, mmzk_pure_gen_t *generator, const void *seed);
 
+// Make list of the records read from the file descriptor FD, split according to KIND.
+// The stream is read on demand through a reusable buffer, so only the records that are still referred to are kept in
+// memory. FD is not closed by the list, and must not be read by others before the list is exhausted or freed.
+// The elements are of type mmzk_record_t, managed by mmzk_record_funs. A read error ends the list.
+// O(1).
+mmzk_llist_t *mmzk_llist_from_fd(int fd, mmzk_record_kind_t kind);
+
+// Make list of the records in the file at PATH, split according to KIND, as mmzk_llist_from_fd().
+// The file is closed when the list is exhausted or freed. Returns NULL if the file cannot be opened.
+// O(1).
+mmzk_llist_t *mmzk_llist_from_file(const char *path, mmzk_record_kind_t kind);
+
 // Free the list.
 //
 // Any list returned by the functions in this module must be freed even if the data may be shared.
@@ -35,6 +68,90 @@ mmzk_llist_t *mmzk_llist_from_generator(mmzk_funs_t funs, mmzk_pure_gen_t *gener
 void mmzk_llist_free(mmzk_llist_t *list);
 
 // Construct an identical list from LIST.
+// O(1).
 mmzk_llist_t *mmzk_llist_copy(mmzk_llist_t *list);
 
+
+/* Query */
+
+// If the LIST is empty, i.e. null LIST.
+// Forces the first element.
+bool mmzk_llist_is_empty(mmzk_llist_t *list);
+
+// Get a copy of the first element of LIST, NULL if empty, i.e. head LIST.
+// Forces the first element.
+void *mmzk_llist_head(mmzk_llist_t *list);
+
+
+/* Decomposition */
+
+// Get the list without the first element in LIST, NULL if empty, i.e. tail LIST.
+// Forces the first element. Freeing LIST afterwards releases the first element unless it is shared, which allows a
+// stream to be consumed in constant memory.
+// O(1).
+mmzk_llist_t *mmzk_llist_tail(mmzk_llist_t *list);
+
+
+
+/* Evaluation */
+
+// Evaluate the rest of LIST on a background thread, keeping up to N elements ready ahead of the consumer in a lock-free
+// ring buffer. Forcing an element then takes it from the buffer, waiting only if the thread has fallen behind.
+// The elements already evaluated are not affected, and the change is visible to all lists sharing the rest of LIST.
+// From then on, the generator and the COPY_FUN of LIST run on the background thread, as may the FREE_FUN for elements
+// left in the buffer, and the list must not be forced from several threads at once.
+// Freeing the last list that refers to the rest stops the thread without waiting for it. A call to the generator that
+// is in progress, such as a read from a pipe, still finishes on the thread, which then frees what is left; whatever
+// the generator reads must outlive that call. In particular, the file of mmzk_llist_from_file() is closed only then.
+// Returns false if LIST is fully evaluated or the thread cannot be started.
+// O(N).
+bool mmzk_llist_readahead(mmzk_llist_t *list, size_t n);
+
+
+/* Consumption */
+
+// Ephemeral iterator for LIST, which is consumed by this function.
+// Nodes that are referred to by no other list are freed as soon as the iterator moves past them, and from the first
+// unevaluated node that is not shared, the generator is run directly without building nodes at all. Therefore iterating
+// through a list in its entirety uses constant memory, unless some other list retains a node, in which case every
+// element after it must be memoized for that list.
+// Example:
+//
+// mmzk_llist_iterator_t iter = mmzk_llist_iterator(list);
+// while (mmzk_llist_has_next(&iter)) {
+//   const void *elem = mmzk_llist_yield(&iter);
+//   // Process elem...
+// }
+//
+// If the iteration stops early, mmzk_llist_iterator_close() must be called to release the rest of the list.
+// O(1).
+mmzk_llist_iterator_t mmzk_llist_iterator(mmzk_llist_t *list);
+
+// If the iterator still yields elements. Forces the next element.
+// Once it returns false, the iterator is closed.
+bool mmzk_llist_has_next(mmzk_llist_iterator_t *iterator);
+
+// Get the current element of the iterator and move to the next. Undefined behaviour if it does not have elements.
+// The element belongs to the iterator, and is only valid until the next call to mmzk_llist_has_next().
+const void *mmzk_llist_yield(mmzk_llist_iterator_t *iterator);
+
+// Release the rest of the list of the iterator. It is safe to close an iterator more than once.
+void mmzk_llist_iterator_close(mmzk_llist_iterator_t *iterator);
+
+// Reduce the elements in LIST by WORKER from left to right, i.e. foldl WORKER INIT LIST.
+// LIST is consumed by an ephemeral iterator, see mmzk_llist_iterator().
+// WORKER must take care of the lifespan of the accumulator argument (first), but should not modify or deallocate the
+// list element argument (second).
+// INIT should not be accessed after being passed to this function.
+// O(n) not considering the time complexity of WORKER; O(1) memory if no other list retains the rest of LIST.
+void *mmzk_llist_fold_left(void *(*worker)(void *, const void *), void *init, mmzk_llist_t *list);
+
+// Called with the number of elements memoized when an ephemeral iterator is closed after another list has kept it from
+// discarding them, which is usually caused by an unintentionally retained head.
+typedef void mmzk_llist_retention_hook_t(size_t memoized);
+
+// Set the diagnostic HOOK for retained elements, or disable it if NULL (by default).
+// The hook is global, and should be set before lists are consumed.
+void mmzk_llist_set_retention_hook(mmzk_llist_retention_hook_t *hook);
+
 #endif /* MMZK_LLIST_H */
@@ -0,0 +1,449 @@
+#include <assert.h>
+#include <iso646.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "mmzkmap.h"
+
+
+/* Definitions */
+
+// A tree is balanced if neither side weighs more than DELTA times the other, where the weight of a tree is its size
+// plus one. When rebalancing, a single rotation is enough if the inner grandchild weighs less than RATIO times the
+// outer one. These are the parameters proven correct by Hirai and Yamamoto.
+#define DELTA 3
+#define RATIO 2
+
+// The number of trees above which a node is referred to is PREV_COUNT + 1, as with the nodes of lists.
+struct tree {
+  unsigned int prev_count;
+  size_t size;
+  const void *key;
+  const void *value;
+  struct tree *left;
+  struct tree *right;
+};
+
+struct mmzk_map {
+  bool is_persistent;
+  mmzk_funs_t key_funs;
+  mmzk_funs_t value_funs;
+  comparator_t *cmp;
+  struct tree *root;
+};
+
+// The fields of a node that has been taken apart, each owned by the caller.
+struct parts {
+  const void *key;
+  const void *value;
+  struct tree *left;
+  struct tree *right;
+};
+
+
+/* Helpers */
+
+#define INIT_MAP(KEY_FUNS, VALUE_FUNS, CMP, PERSISTENCE, MAP) do {\
+  MAP->key_funs = KEY_FUNS;\
+  MAP->value_funs = VALUE_FUNS;\
+  MAP->cmp = CMP;\
+  MAP->is_persistent = PERSISTENCE;\
+  MAP->root = NULL;\
+} while (false)
+
+static bool _unit_eq(const void *unit1, const void *unit2) {
+  return true;
+}
+
+static void *_unit_copy(const void *unit) {
+  return NULL;
+}
+
+static void _unit_free(void *unit) {
+}
+
+// The values of sets.
+static const mmzk_funs_t unit_funs = { &_unit_eq, &_unit_copy, &_unit_free, NULL };
+
+static inline size_t _size(const struct tree *tree) {
+  return tree == NULL ? 0 : tree->size;
+}
+
+static inline void _share_tree(struct tree *tree) {
+  if (tree != NULL) {
+    tree->prev_count++;
+  }
+}
+
+// Release a reference to TREE, freeing the nodes that are not referred to by anything else.
+static void _free_tree(mmzk_map_t *map, struct tree *tree) {
+  while (tree != NULL) {
+    if (tree->prev_count > 0) {
+      tree->prev_count--;
+      return;
+    }
+
+    struct tree *right = tree->right;
+    (map->key_funs.free_fun)((void *)tree->key);
+    (map->value_funs.free_fun)((void *)tree->value);
+    _free_tree(map, tree->left);
+    free(tree);
+    tree = right;
+  }
+}
+
+// New node of KEY and VALUE between LEFT and RIGHT, taking over all of them.
+static struct tree *_node(const void *key, const void *value, struct tree *left, struct tree *right) {
+  struct tree *tree = malloc(sizeof(struct tree));
+  tree->prev_count = 0;
+  tree->size = _size(left) + _size(right) + 1;
+  tree->key = key;
+  tree->value = value;
+  tree->left = left;
+  tree->right = right;
+
+  return tree;
+}
+
+// Take apart a node that the caller holds a reference to. A node referred to by nothing else is reused as it is;
+// otherwise its key and value are copied and its children are shared.
+static struct parts _open(mmzk_map_t *map, struct tree *tree) {
+  struct parts result = { tree->key, tree->value, tree->left, tree->right };
+
+  if (tree->prev_count == 0) {
+    free(tree);
+  } else {
+    tree->prev_count--;
+    result.key = (map->key_funs.copy_fun)(tree->key);
+    result.value = (map->value_funs.copy_fun)(tree->value);
+    _share_tree(tree->left);
+    _share_tree(tree->right);
+  }
+
+  return result;
+}
+
+static inline bool _is_balanced(const struct tree *tree1, const struct tree *tree2) {
+  return DELTA * (_size(tree1) + 1) >= _size(tree2) + 1;
+}
+
+static inline bool _is_single(const struct tree *tree1, const struct tree *tree2) {
+  return _size(tree1) + 1 < RATIO * (_size(tree2) + 1);
+}
+
+// Make a node as _node() does, restoring the balance if one side has grown or shrunk by at most one key.
+static struct tree *_balance(mmzk_map_t *map, const void *key, const void *value, struct tree *left,
+    struct tree *right) {
+  if (!_is_balanced(left, right)) {
+    struct parts r = _open(map, right);
+    if (_is_single(r.left, r.right)) {
+      return _node(r.key, r.value, _node(key, value, left, r.left), r.right);
+    }
+    struct parts rl = _open(map, r.left);
+    return _node(rl.key, rl.value, _node(key, value, left, rl.left), _node(r.key, r.value, rl.right, r.right));
+  }
+
+  if (!_is_balanced(right, left)) {
+    struct parts l = _open(map, left);
+    if (_is_single(l.right, l.left)) {
+      return _node(l.key, l.value, l.left, _node(key, value, l.right, right));
+    }
+    struct parts lr = _open(map, l.right);
+    return _node(lr.key, lr.value, _node(l.key, l.value, l.left, lr.left), _node(key, value, lr.right, right));
+  }
+
+  return _node(key, value, left, right);
+}
+
+// Insert KEY and VALUE, which belong to the caller, into TREE, taking over all of them.
+static struct tree *_insert(mmzk_map_t *map, const void *key, const void *value, struct tree *tree) {
+  if (tree == NULL) {
+    return _node(key, value, NULL, NULL);
+  }
+
+  struct parts p = _open(map, tree);
+  int cmp = (map->cmp)(key, p.key);
+  if (cmp < 0) {
+    return _balance(map, p.key, p.value, _insert(map, key, value, p.left), p.right);
+  }
+  if (cmp > 0) {
+    return _balance(map, p.key, p.value, p.left, _insert(map, key, value, p.right));
+  }
+
+  (map->key_funs.free_fun)((void *)p.key);
+  (map->value_funs.free_fun)((void *)p.value);
+  return _node(key, value, p.left, p.right);
+}
+
+// Remove the minimum key of the non-empty TREE, storing it and its value in *KEY and *VALUE.
+static struct tree *_delete_min(mmzk_map_t *map, struct tree *tree, const void **key, const void **value) {
+  struct parts p = _open(map, tree);
+  if (p.left == NULL) {
+    *key = p.key;
+    *value = p.value;
+    return p.right;
+  }
+
+  return _balance(map, p.key, p.value, _delete_min(map, p.left, key, value), p.right);
+}
+
+// Remove the maximum key of the non-empty TREE, storing it and its value in *KEY and *VALUE.
+static struct tree *_delete_max(mmzk_map_t *map, struct tree *tree, const void **key, const void **value) {
+  struct parts p = _open(map, tree);
+  if (p.right == NULL) {
+    *key = p.key;
+    *value = p.value;
+    return p.left;
+  }
+
+  return _balance(map, p.key, p.value, p.left, _delete_max(map, p.right, key, value));
+}
+
+// Remove KEY, which must be in TREE, taking over TREE.
+static struct tree *_delete(mmzk_map_t *map, const void *key, struct tree *tree) {
+  struct parts p = _open(map, tree);
+  int cmp = (map->cmp)(key, p.key);
+  if (cmp < 0) {
+    return _balance(map, p.key, p.value, _delete(map, key, p.left), p.right);
+  }
+  if (cmp > 0) {
+    return _balance(map, p.key, p.value, p.left, _delete(map, key, p.right));
+  }
+
+  (map->key_funs.free_fun)((void *)p.key);
+  (map->value_funs.free_fun)((void *)p.value);
+  if (p.left == NULL) {
+    return p.right;
+  }
+  if (p.right == NULL) {
+    return p.left;
+  }
+
+  // Replace the key by its neighbour from the larger side, so that the result stays balanced.
+  const void *next_key;
+  const void *next_value;
+  if (_size(p.left) > _size(p.right)) {
+    struct tree *left = _delete_max(map, p.left, &next_key, &next_value);
+    return _balance(map, next_key, next_value, left, p.right);
+  }
+  struct tree *right = _delete_min(map, p.right, &next_key, &next_value);
+  return _balance(map, next_key, next_value, p.left, right);
+}
+
+static const struct tree *_find(mmzk_map_t *map, const void *key) {
+  const struct tree *tree = map->root;
+
+  while (tree != NULL) {
+    int cmp = (map->cmp)(key, tree->key);
+    if (cmp == 0) {
+      return tree;
+    }
+    tree = cmp < 0 ? tree->left : tree->right;
+  }
+
+  return NULL;
+}
+
+// Build a perfectly balanced tree from the LEN keys and values in KEYS and VALUES, taking them over.
+static struct tree *_build(const void **keys, const void **values, size_t len) {
+  if (len == 0) {
+    return NULL;
+  }
+
+  size_t mid = len / 2;
+  struct tree *left = _build(keys, values, mid);
+  struct tree *right = _build(keys + mid + 1, values + mid + 1, len - mid - 1);
+  return _node(keys[mid], values[mid], left, right);
+}
+
+// Append copies of the keys of TREE between LOW and HIGH (inclusive) to BUILDER in order, paired with their values if
+// WITH_VALUES is true. Either bound may be NULL for no bound.
+static void _collect(mmzk_map_t *map, const struct tree *tree, const void *low, const void *high, bool with_values,
+    mmzk_list_builder_t *builder) {
+  while (tree != NULL) {
+    bool above_low = low == NULL || (map->cmp)(tree->key, low) >= 0;
+    bool below_high = high == NULL || (map->cmp)(tree->key, high) <= 0;
+
+    if (above_low) {
+      _collect(map, tree->left, low, high, with_values, builder);
+    }
+    if (above_low && below_high) {
+      if (with_values) {
+        mmzk_list_builder_append_move(builder,
+            mmzk_pair_new(map->key_funs, tree->key, map->value_funs, tree->value));
+      } else {
+        mmzk_list_builder_append(builder, tree->key);
+      }
+    }
+    if (!below_high) {
+      return;
+    }
+    tree = tree->right;
+  }
+}
+
+static mmzk_list_t *_to_list(mmzk_map_t *map, const void *low, const void *high, bool with_values) {
+  mmzk_list_builder_t *builder = mmzk_list_builder_new(with_values ? mmzk_pair_funs : map->key_funs);
+  _collect(map, map->root, low, high, with_values, builder);
+  mmzk_list_t *result = mmzk_list_builder_freeze(builder);
+
+  if (!map->is_persistent) {
+    mmzk_map_free(map);
+  }
+
+  return result;
+}
+
+// New header of the same kind as MAP holding ROOT.
+static mmzk_map_t *_derive(mmzk_map_t *map, struct tree *root) {
+  mmzk_map_t *result = malloc(sizeof(mmzk_map_t));
+  INIT_MAP(map->key_funs, map->value_funs, map->cmp, map->is_persistent, result);
+  result->root = root;
+
+  return result;
+}
+
+static mmzk_map_t *_from_sorted_list(mmzk_funs_t key_funs, mmzk_funs_t value_funs, comparator_t *cmp,
+    mmzk_list_t *list, bool is_set) {
+  mmzk_map_t *result = malloc(sizeof(mmzk_map_t));
+  INIT_MAP(key_funs, value_funs, cmp, true, result);
+  size_t len = 0;
+  const void **keys = malloc(mmzk_list_length(list) * sizeof(void *));
+  const void **values = malloc(mmzk_list_length(list) * sizeof(void *));
+
+  mmzk_list_iterator_t iter = mmzk_list_iterator(list);
+  while (mmzk_list_has_next(iter)) {
+    const void *elem = mmzk_list_yield(&iter);
+    const void *key = is_set ? elem : mmzk_pair_fst(elem);
+    if (len > 0 && cmp(keys[len - 1], key) == 0) {
+      if (is_set) {
+        continue;
+      }
+      len--;
+      (key_funs.free_fun)((void *)keys[len]);
+      (value_funs.free_fun)((void *)values[len]);
+    }
+    assert(len == 0 || cmp(keys[len - 1], key) < 0);
+    keys[len] = (key_funs.copy_fun)(key);
+    values[len] = is_set ? NULL : (value_funs.copy_fun)(mmzk_pair_snd(elem));
+    len++;
+  }
+  result->root = _build(keys, values, len);
+
+  free(keys);
+  free(values);
+
+  return result;
+}
+
+
+/* Construction & Destruction */
+
+mmzk_map_t *mmzk_map_new(mmzk_funs_t key_funs, mmzk_funs_t value_funs, comparator_t *cmp) {
+  mmzk_map_t *map = malloc(sizeof(mmzk_map_t));
+  INIT_MAP(key_funs, value_funs, cmp, true, map);
+
+  return map;
+}
+
+mmzk_map_t *mmzk_set_new(mmzk_funs_t key_funs, comparator_t *cmp) {
+  return mmzk_map_new(key_funs, unit_funs, cmp);
+}
+
+mmzk_map_t *mmzk_map_from_sorted_list(mmzk_funs_t key_funs, mmzk_funs_t value_funs, comparator_t *cmp,
+    mmzk_list_t *list) {
+  return _from_sorted_list(key_funs, value_funs, cmp, list, false);
+}
+
+mmzk_map_t *mmzk_set_from_sorted_list(mmzk_funs_t key_funs, comparator_t *cmp, mmzk_list_t *list) {
+  return _from_sorted_list(key_funs, unit_funs, cmp, list, true);
+}
+
+void mmzk_map_free(mmzk_map_t *map) {
+  _free_tree(map, map->root);
+  free(map);
+}
+
+mmzk_map_t *mmzk_map_copy(mmzk_map_t *map) {
+  _share_tree(map->root);
+  return _derive(map, map->root);
+}
+
+void mmzk_map_set_persistence(mmzk_map_t *map, bool persistence) {
+  map->is_persistent = persistence;
+}
+
+mmzk_list_t *mmzk_map_to_list(mmzk_map_t *map) {
+  return _to_list(map, NULL, NULL, true);
+}
+
+mmzk_list_t *mmzk_map_keys(mmzk_map_t *map) {
+  return _to_list(map, NULL, NULL, false);
+}
+
+
+/* Query */
+
+size_t mmzk_map_size(mmzk_map_t *map) {
+  return _size(map->root);
+}
+
+bool mmzk_map_member(const void *key, mmzk_map_t *map) {
+  return _find(map, key) != NULL;
+}
+
+bool mmzk_map_lookup(const void *key, mmzk_map_t *map, void **result) {
+  const struct tree *tree = _find(map, key);
+
+  if (tree == NULL) {
+    return false;
+  }
+
+  if (result != NULL) {
+    *result = (map->value_funs.copy_fun)(tree->value);
+  }
+
+  return true;
+}
+
+mmzk_list_t *mmzk_map_range(const void *low, const void *high, mmzk_map_t *map) {
+  return _to_list(map, low, high, true);
+}
+
+mmzk_list_t *mmzk_map_keys_range(const void *low, const void *high, mmzk_map_t *map) {
+  return _to_list(map, low, high, false);
+}
+
+
+/* Update */
+
+mmzk_map_t *mmzk_map_insert(const void *key, const void *value, mmzk_map_t *map) {
+  // The tree of a non-persistent map is taken over, so that nodes referred to by nothing else are updated in place.
+  if (map->is_persistent) {
+    _share_tree(map->root);
+  }
+  struct tree *root = _insert(map, (map->key_funs.copy_fun)(key), (map->value_funs.copy_fun)(value), map->root);
+  mmzk_map_t *result = _derive(map, root);
+
+  if (!map->is_persistent) {
+    free(map);
+  }
+
+  return result;
+}
+
+mmzk_map_t *mmzk_map_delete(const void *key, mmzk_map_t *map) {
+  // The tree of a non-persistent map is taken over, so that nodes referred to by nothing else are updated in place.
+  if (map->is_persistent) {
+    _share_tree(map->root);
+  }
+  struct tree *root = _find(map, key) == NULL ? map->root : _delete(map, key, map->root);
+  mmzk_map_t *result = _derive(map, root);
+
+  if (!map->is_persistent) {
+    free(map);
+  }
+
+  return result;
+}
@@ -0,0 +1,110 @@
+#ifndef MMZK1526
+#define MMZK1526
+#endif /* MMZK1526 */
+
+#ifndef MMZK_MAP_H
+#define MMZK_MAP_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "mmzklist.h"
+
+// A persistent ordered map similar to Haskell's Data.Map, implemented as a weight-balanced tree.
+//
+// Keys are ordered by a comparator and managed by KEY_FUNS; values are managed by VALUE_FUNS (see mmzk_funs_t). Keys
+// equal under the comparator must also be equal under the EQ_FUN of KEY_FUNS. Updates copy the O(log n) nodes on the
+// path to the key and share the rest of the tree with the original version, so old versions stay valid and cheap.
+//
+// A set is a map whose values are all NULL, made by mmzk_set_new() or mmzk_set_from_sorted_list(); the values of a set
+// are never copied or freed.
+//
+// The persistence protocol is the same as that of mmzk_list_t.
+typedef struct mmzk_map mmzk_map_t;
+
+
+/* Construction & Destruction */
+
+// New empty map ordered by CMP, i.e. Map.empty.
+// O(1).
+mmzk_map_t *mmzk_map_new(mmzk_funs_t key_funs, mmzk_funs_t value_funs, comparator_t *cmp);
+
+// New empty set ordered by CMP, i.e. Set.empty.
+// O(1).
+mmzk_map_t *mmzk_set_new(mmzk_funs_t key_funs, comparator_t *cmp);
+
+// Make map from LIST, a list of pairs (see mmzk_pair_new()) of keys and values sorted by key,
+// i.e. Map.fromAscList LIST.
+// If a key occurs more than once, the last value is kept. The result is unspecified if LIST is not sorted.
+// This function never deallocates LIST, regardless of its persistence state.
+// O(n).
+mmzk_map_t *mmzk_map_from_sorted_list(mmzk_funs_t key_funs, mmzk_funs_t value_funs, comparator_t *cmp,
+    mmzk_list_t *list);
+
+// Make set from LIST, a list of keys sorted by CMP, i.e. Set.fromAscList LIST. Duplicated keys are dropped.
+// The result is unspecified if LIST is not sorted.
+// This function never deallocates LIST, regardless of its persistence state.
+// O(n).
+mmzk_map_t *mmzk_set_from_sorted_list(mmzk_funs_t key_funs, comparator_t *cmp, mmzk_list_t *list);
+
+// Free the map.
+void mmzk_map_free(mmzk_map_t *map);
+
+// Construct an identical map from MAP.
+// This function never deallocates MAP, regardless of its persistence state.
+// O(1).
+mmzk_map_t *mmzk_map_copy(mmzk_map_t *map);
+
+// If PERSISTENCE is TRUE (by default), then passing MAP to another function in this module does not modify itself.
+// Otherwise, MAP will be deallocated when used as an argument to a function (unless specified otherwise).
+void mmzk_map_set_persistence(mmzk_map_t *map, bool persistence);
+
+// Turn MAP into a list of pairs of keys and values in ascending order of keys, i.e. Map.toAscList MAP.
+// O(n).
+mmzk_list_t *mmzk_map_to_list(mmzk_map_t *map);
+
+// Turn MAP into a list of its keys in ascending order, i.e. Map.keys MAP.
+// O(n).
+mmzk_list_t *mmzk_map_keys(mmzk_map_t *map);
+
+
+/* Query */
+
+// The number of keys in MAP, i.e. Map.size MAP.
+// O(1).
+size_t mmzk_map_size(mmzk_map_t *map);
+
+// Whether KEY is in MAP, i.e. Map.member KEY MAP.
+// This function never deallocates MAP, regardless of its persistence state.
+// O(log n).
+bool mmzk_map_member(const void *key, mmzk_map_t *map);
+
+// Store a copy of the value of KEY in MAP in RESULT (if not NULL), i.e. Map.lookup KEY MAP. Returns false (leaving
+// RESULT untouched) if KEY is not in MAP.
+// This function never deallocates MAP, regardless of its persistence state.
+// O(log n).
+bool mmzk_map_lookup(const void *key, mmzk_map_t *map, void **result);
+
+// List of pairs of the keys between LOW and HIGH (inclusive) and their values, in ascending order of keys,
+// i.e. Map.toAscList (Map.filterWithKey (\K _ -> LOW <= K && K <= HIGH) MAP).
+// O(log n + k), where k is the length of the result.
+mmzk_list_t *mmzk_map_range(const void *low, const void *high, mmzk_map_t *map);
+
+// List of the keys between LOW and HIGH (inclusive) in ascending order, i.e. filter (\K -> LOW <= K && K <= HIGH)
+// (Map.keys MAP).
+// O(log n + k), where k is the length of the result.
+mmzk_list_t *mmzk_map_keys_range(const void *low, const void *high, mmzk_map_t *map);
+
+
+/* Update */
+
+// Construct a map by associating KEY with VALUE in MAP, i.e. Map.insert KEY VALUE MAP. VALUE should be NULL for sets.
+// Both KEY and VALUE are copied; if KEY is already in MAP, its value is replaced.
+// O(log n).
+mmzk_map_t *mmzk_map_insert(const void *key, const void *value, mmzk_map_t *map);
+
+// Construct a map by removing KEY from MAP, i.e. Map.delete KEY MAP. The result is equal to MAP if KEY is not in it.
+// O(log n).
+mmzk_map_t *mmzk_map_delete(const void *key, mmzk_map_t *map);
+
+#endif /* MMZK_MAP_H */
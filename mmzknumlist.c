@@ -0,0 +1,988 @@
+#include <assert.h>
+#include <iso646.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "mmzknumlist.h"
+
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+#define MMZK_X86_SIMD
+#include <immintrin.h>
+#define AVX2 __attribute__((target("avx2")))
+#define SSE42 __attribute__((target("sse4.2")))
+#endif
+
+
+/* Definitions */
+
+// The number of bytes of values in a chunk.
+#define CHUNK_BYTES 4096
+
+struct chunk {
+  unsigned int prev_count;
+  uint32_t length;
+  struct chunk *next;
+  _Alignas(64) unsigned char data[];
+};
+
+struct mmzk_numlist {
+  mmzk_num_type_t type;
+  bool is_persistent;
+  struct chunk *chunk;
+  size_t length;
+};
+
+// The kernels for one element type. All of them work on LEN contiguous values.
+//
+// FIND returns the index of the first value equal to *VALUE, LEN if there is none;
+// EQUAL returns whether two arrays are element-wise equal;
+// FILTER writes the values that satisfy OP against *OPERAND to OUT (which must have room for LEN values), returning
+// how many there are; the slots after them may be overwritten;
+// SUM, MIN and MAX fold the values into *ACCUM, which must be initialised.
+struct kernels {
+  size_t size;
+  size_t (*find)(const void *data, size_t len, const void *value);
+  bool (*equal)(const void *data1, const void *data2, size_t len);
+  size_t (*filter)(const void *data, size_t len, mmzk_cmp_op_t op, const void *operand, void *out);
+  void (*sum)(const void *data, size_t len, void *accum);
+  void (*min)(const void *data, size_t len, void *accum);
+  void (*max)(const void *data, size_t len, void *accum);
+};
+
+
+/* Scalar Kernels */
+
+#define FILTER_LOOP(T, COND) do {\
+  for (size_t i = 0; i < len; i++) {\
+    T x = xs[i];\
+    ys[count] = x;\
+    count += (COND);\
+  }\
+} while (false)
+
+#define SCALAR_KERNELS(NAME, T, ACC)\
+static size_t _find_##NAME(const void *data, size_t len, const void *value) {\
+  const T *xs = data;\
+  T v = *(const T *)value;\
+  for (size_t i = 0; i < len; i++) {\
+    if (xs[i] == v) {\
+      return i;\
+    }\
+  }\
+  return len;\
+}\
+\
+static bool _equal_##NAME(const void *data1, const void *data2, size_t len) {\
+  const T *xs = data1;\
+  const T *ys = data2;\
+  bool result = true;\
+  for (size_t i = 0; i < len; i++) {\
+    result &= xs[i] == ys[i];\
+  }\
+  return result;\
+}\
+\
+static size_t _filter_##NAME(const void *data, size_t len, mmzk_cmp_op_t op, const void *operand, void *out) {\
+  const T *xs = data;\
+  T *ys = out;\
+  T c = *(const T *)operand;\
+  size_t count = 0;\
+  switch (op) {\
+    case MMZK_LT: FILTER_LOOP(T, x < c); break;\
+    case MMZK_LE: FILTER_LOOP(T, x <= c); break;\
+    case MMZK_GT: FILTER_LOOP(T, x > c); break;\
+    case MMZK_GE: FILTER_LOOP(T, x >= c); break;\
+    case MMZK_EQ: FILTER_LOOP(T, x == c); break;\
+    case MMZK_NE: FILTER_LOOP(T, x != c); break;\
+  }\
+  return count;\
+}\
+\
+static void _sum_##NAME(const void *data, size_t len, void *accum) {\
+  const T *xs = data;\
+  ACC result = *(ACC *)accum;\
+  for (size_t i = 0; i < len; i++) {\
+    result += xs[i];\
+  }\
+  *(ACC *)accum = result;\
+}\
+\
+static void _min_##NAME(const void *data, size_t len, void *accum) {\
+  const T *xs = data;\
+  T result = *(T *)accum;\
+  for (size_t i = 0; i < len; i++) {\
+    result = xs[i] < result ? xs[i] : result;\
+  }\
+  *(T *)accum = result;\
+}\
+\
+static void _max_##NAME(const void *data, size_t len, void *accum) {\
+  const T *xs = data;\
+  T result = *(T *)accum;\
+  for (size_t i = 0; i < len; i++) {\
+    result = xs[i] > result ? xs[i] : result;\
+  }\
+  *(T *)accum = result;\
+}
+
+SCALAR_KERNELS(i32, int32_t, int64_t)
+SCALAR_KERNELS(i64, int64_t, int64_t)
+SCALAR_KERNELS(f64, double, double)
+
+
+/* AVX2 Kernels */
+
+#ifdef MMZK_X86_SIMD
+
+// Permutations that move the 32-bit lanes selected by an 8-bit mask to the front, in order.
+static int32_t pack8_lut[256][8];
+
+// Permutations (in 32-bit lanes) that move the 64-bit lanes selected by a 4-bit mask to the front, in order.
+static int32_t pack4_lut[16][8];
+
+// Byte shuffles that move the 32-bit lanes of a 128-bit vector selected by a 4-bit mask to the front, in order.
+static uint8_t pack4x32_lut[16][16];
+
+static void _init_luts(void) {
+  for (int32_t mask = 0; mask < 256; mask++) {
+    int32_t k = 0;
+    for (int32_t i = 0; i < 8; i++) {
+      if (mask & (1 << i)) {
+        pack8_lut[mask][k++] = i;
+      }
+    }
+    while (k < 8) {
+      pack8_lut[mask][k++] = 0;
+    }
+  }
+
+  for (int32_t mask = 0; mask < 16; mask++) {
+    int32_t k = 0;
+    for (int32_t i = 0; i < 4; i++) {
+      if (mask & (1 << i)) {
+        pack4_lut[mask][k++] = 2 * i;
+        pack4_lut[mask][k++] = 2 * i + 1;
+      }
+    }
+    while (k < 8) {
+      pack4_lut[mask][k++] = 0;
+    }
+  }
+
+  for (int32_t mask = 0; mask < 16; mask++) {
+    int32_t k = 0;
+    for (int32_t i = 0; i < 4; i++) {
+      if (mask & (1 << i)) {
+        for (int32_t b = 0; b < 4; b++) {
+          pack4x32_lut[mask][k++] = (uint8_t)(4 * i + b);
+        }
+      }
+    }
+    while (k < 16) {
+      pack4x32_lut[mask][k++] = 0;
+    }
+  }
+}
+
+AVX2 static size_t _find_i32_avx2(const void *data, size_t len, const void *value) {
+  const int32_t *xs = data;
+  __m256i v = _mm256_set1_epi32(*(const int32_t *)value);
+  size_t i = 0;
+
+  for (; i + 8 <= len; i += 8) {
+    __m256i x = _mm256_loadu_si256((const __m256i *)(xs + i));
+    int mask = _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(x, v)));
+    if (mask != 0) {
+      return i + (size_t)__builtin_ctz((unsigned int)mask);
+    }
+  }
+
+  return i + _find_i32(xs + i, len - i, value);
+}
+
+AVX2 static size_t _find_i64_avx2(const void *data, size_t len, const void *value) {
+  const int64_t *xs = data;
+  __m256i v = _mm256_set1_epi64x(*(const int64_t *)value);
+  size_t i = 0;
+
+  for (; i + 4 <= len; i += 4) {
+    __m256i x = _mm256_loadu_si256((const __m256i *)(xs + i));
+    int mask = _mm256_movemask_pd(_mm256_castsi256_pd(_mm256_cmpeq_epi64(x, v)));
+    if (mask != 0) {
+      return i + (size_t)__builtin_ctz((unsigned int)mask);
+    }
+  }
+
+  return i + _find_i64(xs + i, len - i, value);
+}
+
+AVX2 static size_t _find_f64_avx2(const void *data, size_t len, const void *value) {
+  const double *xs = data;
+  __m256d v = _mm256_set1_pd(*(const double *)value);
+  size_t i = 0;
+
+  for (; i + 4 <= len; i += 4) {
+    __m256d x = _mm256_loadu_pd(xs + i);
+    int mask = _mm256_movemask_pd(_mm256_cmp_pd(x, v, _CMP_EQ_OQ));
+    if (mask != 0) {
+      return i + (size_t)__builtin_ctz((unsigned int)mask);
+    }
+  }
+
+  return i + _find_f64(xs + i, len - i, value);
+}
+
+// Equality of integers of either width is equality of their bytes.
+AVX2 static bool _equal_bytes_avx2(const void *data1, const void *data2, size_t len) {
+  const unsigned char *xs = data1;
+  const unsigned char *ys = data2;
+  __m256i diff = _mm256_setzero_si256();
+  size_t i = 0;
+
+  for (; i + 32 <= len; i += 32) {
+    __m256i x = _mm256_loadu_si256((const __m256i *)(xs + i));
+    __m256i y = _mm256_loadu_si256((const __m256i *)(ys + i));
+    diff = _mm256_or_si256(diff, _mm256_xor_si256(x, y));
+  }
+
+  return _mm256_testz_si256(diff, diff) && memcmp(xs + i, ys + i, len - i) == 0;
+}
+
+AVX2 static bool _equal_i32_avx2(const void *data1, const void *data2, size_t len) {
+  return _equal_bytes_avx2(data1, data2, len * sizeof(int32_t));
+}
+
+AVX2 static bool _equal_i64_avx2(const void *data1, const void *data2, size_t len) {
+  return _equal_bytes_avx2(data1, data2, len * sizeof(int64_t));
+}
+
+AVX2 static bool _equal_f64_avx2(const void *data1, const void *data2, size_t len) {
+  const double *xs = data1;
+  const double *ys = data2;
+  __m256d same = _mm256_castsi256_pd(_mm256_set1_epi64x(-1));
+  size_t i = 0;
+
+  for (; i + 4 <= len; i += 4) {
+    same = _mm256_and_pd(same, _mm256_cmp_pd(_mm256_loadu_pd(xs + i), _mm256_loadu_pd(ys + i), _CMP_EQ_OQ));
+  }
+
+  return _mm256_movemask_pd(same) == 0xF && _equal_f64(xs + i, ys + i, len - i);
+}
+
+// Integer comparisons are derived from EQ and GT, flipping the mask for the negated operators.
+#define INT_CMP_MASK(CMPEQ, CMPGT, X, C) (\
+  op == MMZK_EQ || op == MMZK_NE ? CMPEQ(X, C) : op == MMZK_GT || op == MMZK_LE ? CMPGT(X, C) : CMPGT(C, X)\
+)
+
+AVX2 static size_t _filter_i32_avx2(const void *data, size_t len, mmzk_cmp_op_t op, const void *operand, void *out) {
+  const int32_t *xs = data;
+  int32_t *ys = out;
+  __m256i c = _mm256_set1_epi32(*(const int32_t *)operand);
+  unsigned int flip = op == MMZK_NE || op == MMZK_LE || op == MMZK_GE ? 0xFF : 0;
+  size_t count = 0;
+  size_t i = 0;
+
+  for (; i + 8 <= len; i += 8) {
+    __m256i x = _mm256_loadu_si256((const __m256i *)(xs + i));
+    __m256i m = INT_CMP_MASK(_mm256_cmpeq_epi32, _mm256_cmpgt_epi32, x, c);
+    unsigned int mask = (unsigned int)_mm256_movemask_ps(_mm256_castsi256_ps(m)) ^ flip;
+    __m256i perm = _mm256_loadu_si256((const __m256i *)pack8_lut[mask]);
+    _mm256_storeu_si256((__m256i *)(ys + count), _mm256_permutevar8x32_epi32(x, perm));
+    count += (size_t)__builtin_popcount(mask);
+  }
+
+  return count + _filter_i32(xs + i, len - i, op, operand, ys + count);
+}
+
+AVX2 static size_t _filter_i64_avx2(const void *data, size_t len, mmzk_cmp_op_t op, const void *operand, void *out) {
+  const int64_t *xs = data;
+  int64_t *ys = out;
+  __m256i c = _mm256_set1_epi64x(*(const int64_t *)operand);
+  unsigned int flip = op == MMZK_NE || op == MMZK_LE || op == MMZK_GE ? 0xF : 0;
+  size_t count = 0;
+  size_t i = 0;
+
+  for (; i + 4 <= len; i += 4) {
+    __m256i x = _mm256_loadu_si256((const __m256i *)(xs + i));
+    __m256i m = INT_CMP_MASK(_mm256_cmpeq_epi64, _mm256_cmpgt_epi64, x, c);
+    unsigned int mask = (unsigned int)_mm256_movemask_pd(_mm256_castsi256_pd(m)) ^ flip;
+    __m256i perm = _mm256_loadu_si256((const __m256i *)pack4_lut[mask]);
+    _mm256_storeu_si256((__m256i *)(ys + count), _mm256_permutevar8x32_epi32(x, perm));
+    count += (size_t)__builtin_popcount(mask);
+  }
+
+  return count + _filter_i64(xs + i, len - i, op, operand, ys + count);
+}
+
+// The predicate of _mm256_cmp_pd must be a constant, hence one loop per operator.
+#define FILTER_F64_LOOP(PRED) do {\
+  for (; i + 4 <= len; i += 4) {\
+    __m256d x = _mm256_loadu_pd(xs + i);\
+    unsigned int mask = (unsigned int)_mm256_movemask_pd(_mm256_cmp_pd(x, c, PRED));\
+    __m256i perm = _mm256_loadu_si256((const __m256i *)pack4_lut[mask]);\
+    __m256 packed = _mm256_permutevar8x32_ps(_mm256_castpd_ps(x), perm);\
+    _mm256_storeu_pd(ys + count, _mm256_castps_pd(packed));\
+    count += (size_t)__builtin_popcount(mask);\
+  }\
+} while (false)
+
+AVX2 static size_t _filter_f64_avx2(const void *data, size_t len, mmzk_cmp_op_t op, const void *operand, void *out) {
+  const double *xs = data;
+  double *ys = out;
+  __m256d c = _mm256_set1_pd(*(const double *)operand);
+  size_t count = 0;
+  size_t i = 0;
+
+  switch (op) {
+    case MMZK_LT: FILTER_F64_LOOP(_CMP_LT_OQ); break;
+    case MMZK_LE: FILTER_F64_LOOP(_CMP_LE_OQ); break;
+    case MMZK_GT: FILTER_F64_LOOP(_CMP_GT_OQ); break;
+    case MMZK_GE: FILTER_F64_LOOP(_CMP_GE_OQ); break;
+    case MMZK_EQ: FILTER_F64_LOOP(_CMP_EQ_OQ); break;
+    case MMZK_NE: FILTER_F64_LOOP(_CMP_NEQ_UQ); break;
+  }
+
+  return count + _filter_f64(xs + i, len - i, op, operand, ys + count);
+}
+
+AVX2 static void _sum_i32_avx2(const void *data, size_t len, void *accum) {
+  const int32_t *xs = data;
+  __m256i lo = _mm256_setzero_si256();
+  __m256i hi = _mm256_setzero_si256();
+  size_t i = 0;
+
+  for (; i + 8 <= len; i += 8) {
+    __m256i x = _mm256_loadu_si256((const __m256i *)(xs + i));
+    lo = _mm256_add_epi64(lo, _mm256_cvtepi32_epi64(_mm256_castsi256_si128(x)));
+    hi = _mm256_add_epi64(hi, _mm256_cvtepi32_epi64(_mm256_extracti128_si256(x, 1)));
+  }
+
+  int64_t lanes[4];
+  _mm256_storeu_si256((__m256i *)lanes, _mm256_add_epi64(lo, hi));
+  *(int64_t *)accum += lanes[0] + lanes[1] + lanes[2] + lanes[3];
+  _sum_i32(xs + i, len - i, accum);
+}
+
+AVX2 static void _sum_i64_avx2(const void *data, size_t len, void *accum) {
+  const int64_t *xs = data;
+  __m256i sum = _mm256_setzero_si256();
+  size_t i = 0;
+
+  for (; i + 4 <= len; i += 4) {
+    sum = _mm256_add_epi64(sum, _mm256_loadu_si256((const __m256i *)(xs + i)));
+  }
+
+  int64_t lanes[4];
+  _mm256_storeu_si256((__m256i *)lanes, sum);
+  *(int64_t *)accum += lanes[0] + lanes[1] + lanes[2] + lanes[3];
+  _sum_i64(xs + i, len - i, accum);
+}
+
+AVX2 static void _sum_f64_avx2(const void *data, size_t len, void *accum) {
+  const double *xs = data;
+  __m256d sum1 = _mm256_setzero_pd();
+  __m256d sum2 = _mm256_setzero_pd();
+  size_t i = 0;
+
+  for (; i + 8 <= len; i += 8) {
+    sum1 = _mm256_add_pd(sum1, _mm256_loadu_pd(xs + i));
+    sum2 = _mm256_add_pd(sum2, _mm256_loadu_pd(xs + i + 4));
+  }
+
+  double lanes[4];
+  _mm256_storeu_pd(lanes, _mm256_add_pd(sum1, sum2));
+  *(double *)accum += (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+  _sum_f64(xs + i, len - i, accum);
+}
+
+#define MINMAX_I32_AVX2(NAME, OP)\
+AVX2 static void _##NAME##_i32_avx2(const void *data, size_t len, void *accum) {\
+  const int32_t *xs = data;\
+  __m256i result = _mm256_set1_epi32(*(int32_t *)accum);\
+  size_t i = 0;\
+  for (; i + 8 <= len; i += 8) {\
+    result = OP(result, _mm256_loadu_si256((const __m256i *)(xs + i)));\
+  }\
+  int32_t lanes[8];\
+  _mm256_storeu_si256((__m256i *)lanes, result);\
+  _##NAME##_i32(lanes, 8, accum);\
+  _##NAME##_i32(xs + i, len - i, accum);\
+}
+
+MINMAX_I32_AVX2(min, _mm256_min_epi32)
+MINMAX_I32_AVX2(max, _mm256_max_epi32)
+
+// AVX2 has no 64-bit integer min or max, so they are blended from a comparison.
+AVX2 static void _min_i64_avx2(const void *data, size_t len, void *accum) {
+  const int64_t *xs = data;
+  __m256i result = _mm256_set1_epi64x(*(int64_t *)accum);
+  size_t i = 0;
+
+  for (; i + 4 <= len; i += 4) {
+    __m256i x = _mm256_loadu_si256((const __m256i *)(xs + i));
+    result = _mm256_blendv_epi8(result, x, _mm256_cmpgt_epi64(result, x));
+  }
+
+  int64_t lanes[4];
+  _mm256_storeu_si256((__m256i *)lanes, result);
+  _min_i64(lanes, 4, accum);
+  _min_i64(xs + i, len - i, accum);
+}
+
+AVX2 static void _max_i64_avx2(const void *data, size_t len, void *accum) {
+  const int64_t *xs = data;
+  __m256i result = _mm256_set1_epi64x(*(int64_t *)accum);
+  size_t i = 0;
+
+  for (; i + 4 <= len; i += 4) {
+    __m256i x = _mm256_loadu_si256((const __m256i *)(xs + i));
+    result = _mm256_blendv_epi8(result, x, _mm256_cmpgt_epi64(x, result));
+  }
+
+  int64_t lanes[4];
+  _mm256_storeu_si256((__m256i *)lanes, result);
+  _max_i64(lanes, 4, accum);
+  _max_i64(xs + i, len - i, accum);
+}
+
+#define MINMAX_F64_AVX2(NAME, OP)\
+AVX2 static void _##NAME##_f64_avx2(const void *data, size_t len, void *accum) {\
+  const double *xs = data;\
+  __m256d result = _mm256_set1_pd(*(double *)accum);\
+  size_t i = 0;\
+  for (; i + 4 <= len; i += 4) {\
+    result = OP(result, _mm256_loadu_pd(xs + i));\
+  }\
+  double lanes[4];\
+  _mm256_storeu_pd(lanes, result);\
+  _##NAME##_f64(lanes, 4, accum);\
+  _##NAME##_f64(xs + i, len - i, accum);\
+}
+
+MINMAX_F64_AVX2(min, _mm256_min_pd)
+MINMAX_F64_AVX2(max, _mm256_max_pd)
+
+#endif /* MMZK_X86_SIMD */
+
+
+/* SSE4.2 Kernels */
+
+// Only searching and filtering, whose early exits and left-packing compilers do not vectorise, have SSE kernels; the
+// other operations use the scalar loops, which are vectorised with the baseline instruction set anyway.
+// SSE4.2 is the first level with 64-bit integer comparisons.
+
+#ifdef MMZK_X86_SIMD
+
+SSE42 static size_t _find_i32_sse(const void *data, size_t len, const void *value) {
+  const int32_t *xs = data;
+  __m128i v = _mm_set1_epi32(*(const int32_t *)value);
+  size_t i = 0;
+
+  for (; i + 4 <= len; i += 4) {
+    __m128i x = _mm_loadu_si128((const __m128i *)(xs + i));
+    int mask = _mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(x, v)));
+    if (mask != 0) {
+      return i + (size_t)__builtin_ctz((unsigned int)mask);
+    }
+  }
+
+  return i + _find_i32(xs + i, len - i, value);
+}
+
+SSE42 static size_t _find_i64_sse(const void *data, size_t len, const void *value) {
+  const int64_t *xs = data;
+  __m128i v = _mm_set1_epi64x(*(const int64_t *)value);
+  size_t i = 0;
+
+  for (; i + 2 <= len; i += 2) {
+    __m128i x = _mm_loadu_si128((const __m128i *)(xs + i));
+    int mask = _mm_movemask_pd(_mm_castsi128_pd(_mm_cmpeq_epi64(x, v)));
+    if (mask != 0) {
+      return i + (size_t)__builtin_ctz((unsigned int)mask);
+    }
+  }
+
+  return i + _find_i64(xs + i, len - i, value);
+}
+
+SSE42 static size_t _find_f64_sse(const void *data, size_t len, const void *value) {
+  const double *xs = data;
+  __m128d v = _mm_set1_pd(*(const double *)value);
+  size_t i = 0;
+
+  for (; i + 2 <= len; i += 2) {
+    int mask = _mm_movemask_pd(_mm_cmpeq_pd(_mm_loadu_pd(xs + i), v));
+    if (mask != 0) {
+      return i + (size_t)__builtin_ctz((unsigned int)mask);
+    }
+  }
+
+  return i + _find_f64(xs + i, len - i, value);
+}
+
+SSE42 static size_t _filter_i32_sse(const void *data, size_t len, mmzk_cmp_op_t op, const void *operand, void *out) {
+  const int32_t *xs = data;
+  int32_t *ys = out;
+  __m128i c = _mm_set1_epi32(*(const int32_t *)operand);
+  unsigned int flip = op == MMZK_NE || op == MMZK_LE || op == MMZK_GE ? 0xF : 0;
+  size_t count = 0;
+  size_t i = 0;
+
+  for (; i + 4 <= len; i += 4) {
+    __m128i x = _mm_loadu_si128((const __m128i *)(xs + i));
+    __m128i m = INT_CMP_MASK(_mm_cmpeq_epi32, _mm_cmpgt_epi32, x, c);
+    unsigned int mask = (unsigned int)_mm_movemask_ps(_mm_castsi128_ps(m)) ^ flip;
+    __m128i shuffle = _mm_loadu_si128((const __m128i *)pack4x32_lut[mask]);
+    _mm_storeu_si128((__m128i *)(ys + count), _mm_shuffle_epi8(x, shuffle));
+    count += (size_t)__builtin_popcount(mask);
+  }
+
+  return count + _filter_i32(xs + i, len - i, op, operand, ys + count);
+}
+
+// A selected 64-bit lane is a pair of selected 32-bit lanes.
+#define PAIR_MASK(MASK) (((MASK) & 1) * 0x3 | ((MASK) & 2) * 0x6)
+
+SSE42 static size_t _filter_i64_sse(const void *data, size_t len, mmzk_cmp_op_t op, const void *operand, void *out) {
+  const int64_t *xs = data;
+  int64_t *ys = out;
+  __m128i c = _mm_set1_epi64x(*(const int64_t *)operand);
+  unsigned int flip = op == MMZK_NE || op == MMZK_LE || op == MMZK_GE ? 0x3 : 0;
+  size_t count = 0;
+  size_t i = 0;
+
+  for (; i + 2 <= len; i += 2) {
+    __m128i x = _mm_loadu_si128((const __m128i *)(xs + i));
+    __m128i m = INT_CMP_MASK(_mm_cmpeq_epi64, _mm_cmpgt_epi64, x, c);
+    unsigned int mask = (unsigned int)_mm_movemask_pd(_mm_castsi128_pd(m)) ^ flip;
+    __m128i shuffle = _mm_loadu_si128((const __m128i *)pack4x32_lut[PAIR_MASK(mask)]);
+    _mm_storeu_si128((__m128i *)(ys + count), _mm_shuffle_epi8(x, shuffle));
+    count += (size_t)__builtin_popcount(mask);
+  }
+
+  return count + _filter_i64(xs + i, len - i, op, operand, ys + count);
+}
+
+#define FILTER_F64_SSE_LOOP(CMP) do {\
+  for (; i + 2 <= len; i += 2) {\
+    __m128d x = _mm_loadu_pd(xs + i);\
+    unsigned int mask = (unsigned int)_mm_movemask_pd(CMP(x, c));\
+    __m128i shuffle = _mm_loadu_si128((const __m128i *)pack4x32_lut[PAIR_MASK(mask)]);\
+    _mm_storeu_si128((__m128i *)(ys + count), _mm_shuffle_epi8(_mm_castpd_si128(x), shuffle));\
+    count += (size_t)__builtin_popcount(mask);\
+  }\
+} while (false)
+
+SSE42 static size_t _filter_f64_sse(const void *data, size_t len, mmzk_cmp_op_t op, const void *operand, void *out) {
+  const double *xs = data;
+  double *ys = out;
+  __m128d c = _mm_set1_pd(*(const double *)operand);
+  size_t count = 0;
+  size_t i = 0;
+
+  switch (op) {
+    case MMZK_LT: FILTER_F64_SSE_LOOP(_mm_cmplt_pd); break;
+    case MMZK_LE: FILTER_F64_SSE_LOOP(_mm_cmple_pd); break;
+    case MMZK_GT: FILTER_F64_SSE_LOOP(_mm_cmpgt_pd); break;
+    case MMZK_GE: FILTER_F64_SSE_LOOP(_mm_cmpge_pd); break;
+    case MMZK_EQ: FILTER_F64_SSE_LOOP(_mm_cmpeq_pd); break;
+    case MMZK_NE: FILTER_F64_SSE_LOOP(_mm_cmpneq_pd); break;
+  }
+
+  return count + _filter_f64(xs + i, len - i, op, operand, ys + count);
+}
+
+#endif /* MMZK_X86_SIMD */
+
+
+/* Helpers */
+
+static struct kernels kernels[3] = {
+  [MMZK_INT32] = { sizeof(int32_t), _find_i32, _equal_i32, _filter_i32, _sum_i32, _min_i32, _max_i32 },
+  [MMZK_INT64] = { sizeof(int64_t), _find_i64, _equal_i64, _filter_i64, _sum_i64, _min_i64, _max_i64 },
+  [MMZK_DOUBLE] = { sizeof(double), _find_f64, _equal_f64, _filter_f64, _sum_f64, _min_f64, _max_f64 },
+};
+
+static pthread_once_t kernels_once = PTHREAD_ONCE_INIT;
+
+// Switch to the fastest kernels that the CPU supports.
+static void _init_kernels(void) {
+#ifdef MMZK_X86_SIMD
+  __builtin_cpu_init();
+  if (getenv("MMZK_NO_SIMD") != NULL) {
+    return;
+  }
+
+  _init_luts();
+  if (__builtin_cpu_supports("avx2") && getenv("MMZK_NO_AVX2") == NULL) {
+    kernels[MMZK_INT32] = (struct kernels) {
+      sizeof(int32_t), _find_i32_avx2, _equal_i32_avx2, _filter_i32_avx2, _sum_i32_avx2, _min_i32_avx2, _max_i32_avx2
+    };
+    kernels[MMZK_INT64] = (struct kernels) {
+      sizeof(int64_t), _find_i64_avx2, _equal_i64_avx2, _filter_i64_avx2, _sum_i64_avx2, _min_i64_avx2, _max_i64_avx2
+    };
+    kernels[MMZK_DOUBLE] = (struct kernels) {
+      sizeof(double), _find_f64_avx2, _equal_f64_avx2, _filter_f64_avx2, _sum_f64_avx2, _min_f64_avx2, _max_f64_avx2
+    };
+  } else if (__builtin_cpu_supports("sse4.2")) {
+    kernels[MMZK_INT32].find = _find_i32_sse;
+    kernels[MMZK_INT32].filter = _filter_i32_sse;
+    kernels[MMZK_INT64].find = _find_i64_sse;
+    kernels[MMZK_INT64].filter = _filter_i64_sse;
+    kernels[MMZK_DOUBLE].find = _find_f64_sse;
+    kernels[MMZK_DOUBLE].filter = _filter_f64_sse;
+  }
+#endif /* MMZK_X86_SIMD */
+}
+
+static const struct kernels *_kernels(mmzk_num_type_t type) {
+  pthread_once(&kernels_once, _init_kernels);
+  return &kernels[type];
+}
+
+#define INIT_NUMLIST(TYPE, PERSISTENCE, LIST) do {\
+  LIST->type = TYPE;\
+  LIST->chunk = NULL;\
+  LIST->is_persistent = PERSISTENCE;\
+  LIST->length = 0;\
+} while (false)
+
+// Release the reference to the chain starting at CHUNK, freeing the chunks that are not referred to by anything else.
+static void _free_chunks(struct chunk *chunk) {
+  while (chunk != NULL) {
+    if (chunk->prev_count > 0) {
+      chunk->prev_count--;
+      break;
+    }
+    struct chunk *temp = chunk;
+    chunk = chunk->next;
+    free(temp);
+  }
+}
+
+// Appends values to a list being built, packing them into full chunks.
+struct chunk_builder {
+  size_t size;
+  struct chunk *head;
+  struct chunk *last;
+  size_t length;
+};
+
+static void _builder_init(struct chunk_builder *builder, mmzk_num_type_t type) {
+  builder->size = kernels[type].size;
+  builder->head = NULL;
+  builder->last = NULL;
+  builder->length = 0;
+}
+
+// Append LEN values from VALUES.
+static void _builder_append(struct chunk_builder *builder, const void *values, size_t len) {
+  size_t capacity = CHUNK_BYTES / builder->size;
+  builder->length += len;
+
+  while (len > 0) {
+    if (builder->last == NULL || builder->last->length == capacity) {
+      struct chunk *chunk = aligned_alloc(64, sizeof(struct chunk) + CHUNK_BYTES);
+      chunk->prev_count = 0;
+      chunk->length = 0;
+      chunk->next = NULL;
+      if (builder->last == NULL) {
+        builder->head = chunk;
+      } else {
+        builder->last->next = chunk;
+      }
+      builder->last = chunk;
+    }
+
+    size_t count = capacity - builder->last->length;
+    count = count < len ? count : len;
+    memcpy(builder->last->data + builder->last->length * builder->size, values, count * builder->size);
+    builder->last->length += (uint32_t)count;
+    values = (const char *)values + count * builder->size;
+    len -= count;
+  }
+}
+
+// Finish the chain by linking TAIL after it, returning its first chunk.
+static struct chunk *_builder_finish(struct chunk_builder *builder, struct chunk *tail) {
+  if (builder->last == NULL) {
+    return tail;
+  }
+
+  builder->last->next = tail;
+  return builder->head;
+}
+
+
+/* Construction & Destruction */
+
+mmzk_numlist_t *mmzk_numlist_new(mmzk_num_type_t type) {
+  mmzk_numlist_t *list = malloc(sizeof(mmzk_numlist_t));
+  INIT_NUMLIST(type, true, list);
+
+  return list;
+}
+
+mmzk_numlist_t *mmzk_numlist_from_array(mmzk_num_type_t type, size_t len, const void *elems) {
+  mmzk_numlist_t *list = malloc(sizeof(mmzk_numlist_t));
+  INIT_NUMLIST(type, true, list);
+  struct chunk_builder builder;
+  _kernels(type);
+  _builder_init(&builder, type);
+
+  _builder_append(&builder, elems, len);
+  list->length = len;
+  list->chunk = _builder_finish(&builder, NULL);
+
+  return list;
+}
+
+mmzk_numlist_t *mmzk_numlist_from_list(mmzk_num_type_t type, mmzk_list_t *list) {
+  mmzk_numlist_t *result = malloc(sizeof(mmzk_numlist_t));
+  INIT_NUMLIST(type, true, result);
+  struct chunk_builder builder;
+  _kernels(type);
+  _builder_init(&builder, type);
+
+  mmzk_list_iterator_t iter = mmzk_list_iterator(list);
+  while (mmzk_list_has_next(iter)) {
+    _builder_append(&builder, mmzk_list_yield(&iter), 1);
+  }
+  result->length = builder.length;
+  result->chunk = _builder_finish(&builder, NULL);
+
+  return result;
+}
+
+void *mmzk_numlist_to_array(mmzk_numlist_t *list, size_t *len) {
+  size_t size = _kernels(list->type)->size;
+  char *result = malloc(list->length * size);
+  char *cur = result;
+
+  for (struct chunk *chunk = list->chunk; chunk != NULL; chunk = chunk->next) {
+    memcpy(cur, chunk->data, chunk->length * size);
+    cur += chunk->length * size;
+  }
+
+  if (len != NULL) {
+    *len = list->length;
+  }
+
+  if (!list->is_persistent) {
+    mmzk_numlist_free(list);
+  }
+
+  return result;
+}
+
+void mmzk_numlist_free(mmzk_numlist_t *list) {
+  _free_chunks(list->chunk);
+  free(list);
+}
+
+mmzk_numlist_t *mmzk_numlist_copy(mmzk_numlist_t *list) {
+  mmzk_numlist_t *result = malloc(sizeof(mmzk_numlist_t));
+  INIT_NUMLIST(list->type, list->is_persistent, result);
+  result->length = list->length;
+  result->chunk = list->chunk;
+
+  if (list->chunk != NULL) {
+    list->chunk->prev_count++;
+  }
+
+  return result;
+}
+
+void mmzk_numlist_set_persistence(mmzk_numlist_t *list, bool persistence) {
+  list->is_persistent = persistence;
+}
+
+
+/* Query */
+
+mmzk_num_type_t mmzk_numlist_type(mmzk_numlist_t *list) {
+  return list->type;
+}
+
+size_t mmzk_numlist_length(mmzk_numlist_t *list) {
+  return list->length;
+}
+
+bool mmzk_numlist_get(mmzk_numlist_t *list, size_t index, void *result) {
+  size_t size = _kernels(list->type)->size;
+  struct chunk *chunk = list->chunk;
+
+  if (index >= list->length) {
+    return false;
+  }
+
+  while (index >= chunk->length) {
+    index -= chunk->length;
+    chunk = chunk->next;
+  }
+  memcpy(result, chunk->data + index * size, size);
+
+  return true;
+}
+
+bool mmzk_numlist_is_elem(const void *element, mmzk_numlist_t *list) {
+  return mmzk_numlist_elem_index(element, list) != SIZE_MAX;
+}
+
+size_t mmzk_numlist_elem_index(const void *element, mmzk_numlist_t *list) {
+  const struct kernels *k = _kernels(list->type);
+  size_t offset = 0;
+
+  for (struct chunk *chunk = list->chunk; chunk != NULL; chunk = chunk->next) {
+    size_t i = (k->find)(chunk->data, chunk->length, element);
+    if (i < chunk->length) {
+      return offset + i;
+    }
+    offset += chunk->length;
+  }
+
+  return SIZE_MAX;
+}
+
+bool mmzk_numlist_equal(mmzk_numlist_t *list1, mmzk_numlist_t *list2) {
+  if (list1->type != list2->type || list1->length != list2->length) {
+    return false;
+  }
+
+  const struct kernels *k = _kernels(list1->type);
+  struct chunk *chunk1 = list1->chunk;
+  struct chunk *chunk2 = list2->chunk;
+  size_t i1 = 0;
+  size_t i2 = 0;
+
+  // The chunks of the two lists need not line up, so compare the overlapping parts.
+  while (chunk1 != NULL && chunk2 != NULL) {
+    if (chunk1 == chunk2 && i1 == i2) {
+      return true;
+    }
+
+    size_t len = chunk1->length - i1 < chunk2->length - i2 ? chunk1->length - i1 : chunk2->length - i2;
+    if (!(k->equal)(chunk1->data + i1 * k->size, chunk2->data + i2 * k->size, len)) {
+      return false;
+    }
+
+    i1 += len;
+    i2 += len;
+    if (i1 == chunk1->length) {
+      chunk1 = chunk1->next;
+      i1 = 0;
+    }
+    if (i2 == chunk2->length) {
+      chunk2 = chunk2->next;
+      i2 = 0;
+    }
+  }
+
+  return true;
+}
+
+
+/* Composition */
+
+mmzk_numlist_t *mmzk_numlist_concat(mmzk_numlist_t *list1, mmzk_numlist_t *list2) {
+  assert(list1->type == list2->type);
+  mmzk_numlist_t *result = malloc(sizeof(mmzk_numlist_t));
+  INIT_NUMLIST(list1->type, list1->is_persistent || list2->is_persistent, result);
+  result->length = list1->length + list2->length;
+  struct chunk_builder builder;
+  _kernels(list1->type);
+  _builder_init(&builder, list1->type);
+
+  for (struct chunk *chunk = list1->chunk; chunk != NULL; chunk = chunk->next) {
+    _builder_append(&builder, chunk->data, chunk->length);
+  }
+  result->chunk = _builder_finish(&builder, list2->chunk);
+
+  if (!list2->is_persistent) {
+    free(list2);
+  } else if (list2->chunk != NULL) {
+    list2->chunk->prev_count++;
+  }
+
+  if (!list1->is_persistent) {
+    mmzk_numlist_free(list1);
+  }
+
+  return result;
+}
+
+
+/* Transformation */
+
+mmzk_numlist_t *mmzk_numlist_filter(mmzk_cmp_op_t op, const void *operand, mmzk_numlist_t *list) {
+  const struct kernels *k = _kernels(list->type);
+  mmzk_numlist_t *result = malloc(sizeof(mmzk_numlist_t));
+  INIT_NUMLIST(list->type, list->is_persistent, result);
+  struct chunk_builder builder;
+  _builder_init(&builder, list->type);
+  void *buffer = aligned_alloc(64, CHUNK_BYTES);
+
+  for (struct chunk *chunk = list->chunk; chunk != NULL; chunk = chunk->next) {
+    size_t count = (k->filter)(chunk->data, chunk->length, op, operand, buffer);
+    _builder_append(&builder, buffer, count);
+  }
+  result->length = builder.length;
+  result->chunk = _builder_finish(&builder, NULL);
+  free(buffer);
+
+  if (!list->is_persistent) {
+    mmzk_numlist_free(list);
+  }
+
+  return result;
+}
+
+
+/* Reduction */
+
+void mmzk_numlist_sum(mmzk_numlist_t *list, void *result) {
+  const struct kernels *k = _kernels(list->type);
+
+  if (list->type == MMZK_DOUBLE) {
+    *(double *)result = 0;
+  } else {
+    *(int64_t *)result = 0;
+  }
+
+  for (struct chunk *chunk = list->chunk; chunk != NULL; chunk = chunk->next) {
+    (k->sum)(chunk->data, chunk->length, result);
+  }
+
+  if (!list->is_persistent) {
+    mmzk_numlist_free(list);
+  }
+}
+
+// Fold LIST by the min or max kernel FOLD into RESULT; false if LIST is empty.
+static bool _fold_extremum(mmzk_numlist_t *list, void (*fold)(const void *, size_t, void *), void *result) {
+  bool is_empty = list->length == 0;
+
+  if (!is_empty) {
+    memcpy(result, list->chunk->data, _kernels(list->type)->size);
+    for (struct chunk *chunk = list->chunk; chunk != NULL; chunk = chunk->next) {
+      fold(chunk->data, chunk->length, result);
+    }
+  }
+
+  if (!list->is_persistent) {
+    mmzk_numlist_free(list);
+  }
+
+  return !is_empty;
+}
+
+bool mmzk_numlist_min(mmzk_numlist_t *list, void *result) {
+  return _fold_extremum(list, _kernels(list->type)->min, result);
+}
+
+bool mmzk_numlist_max(mmzk_numlist_t *list, void *result) {
+  return _fold_extremum(list, _kernels(list->type)->max, result);
+}
@@ -0,0 +1,142 @@
+#ifndef MMZK1526
+#define MMZK1526
+#endif /* MMZK1526 */
+
+#ifndef MMZK_NUMLIST_H
+#define MMZK_NUMLIST_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "mmzklist.h"
+
+// The element type of a numeric list.
+typedef enum mmzk_num_type {
+  MMZK_INT32,
+  MMZK_INT64,
+  MMZK_DOUBLE
+} mmzk_num_type_t;
+
+// Comparison against a fixed operand, used by mmzk_numlist_filter().
+typedef enum mmzk_cmp_op {
+  MMZK_LT,
+  MMZK_LE,
+  MMZK_GT,
+  MMZK_GE,
+  MMZK_EQ,
+  MMZK_NE
+} mmzk_cmp_op_t;
+
+// A persistent list specialised for int32_t, int64_t or double elements.
+//
+// Unlike mmzk_list_t, the elements are stored unboxed in contiguous chunks, and searching, comparison, filtering and
+// reductions run over whole chunks with SIMD kernels. On x86, AVX2 kernels are chosen at runtime if the CPU supports
+// them. Otherwise, searching and filtering use SSE4.2 kernels if it is supported, and everything else uses plain loops,
+// which compilers vectorise with the baseline instruction set. The environment variable MMZK_NO_AVX2 skips the AVX2
+// kernels, and MMZK_NO_SIMD skips both.
+//
+// Elements are compared with the C operators; in particular, NaN is not equal to anything, including itself.
+// The persistence protocol is the same as that of mmzk_list_t.
+typedef struct mmzk_numlist mmzk_numlist_t;
+
+
+/* Construction & Destruction */
+
+// New empty list of TYPE, i.e. [].
+// O(1).
+mmzk_numlist_t *mmzk_numlist_new(mmzk_num_type_t type);
+
+// Make list of TYPE from the LEN values in ELEMS, which must be an array of the corresponding C type.
+// O(n).
+mmzk_numlist_t *mmzk_numlist_from_array(mmzk_num_type_t type, size_t len, const void *elems);
+
+// Make list of TYPE from LIST, whose elements must point to values of the corresponding C type.
+// This function never deallocates LIST, regardless of its persistence state.
+// O(n).
+mmzk_numlist_t *mmzk_numlist_from_list(mmzk_num_type_t type, mmzk_list_t *list);
+
+// Turn LIST into an array of the corresponding C type. The length will be stored in LEN (if not NULL).
+// O(n).
+void *mmzk_numlist_to_array(mmzk_numlist_t *list, size_t *len);
+
+// Free the list.
+void mmzk_numlist_free(mmzk_numlist_t *list);
+
+// Construct an identical list from LIST.
+// This function never deallocates LIST, regardless of its persistence state.
+// O(1).
+mmzk_numlist_t *mmzk_numlist_copy(mmzk_numlist_t *list);
+
+// If PERSISTENCE is TRUE (by default), then passing LIST to another function in this module does not modify itself.
+// Otherwise, LIST will be deallocated when used as an argument to a function (unless specified otherwise).
+void mmzk_numlist_set_persistence(mmzk_numlist_t *list, bool persistence);
+
+
+/* Query */
+
+// The element type of LIST.
+// O(1).
+mmzk_num_type_t mmzk_numlist_type(mmzk_numlist_t *list);
+
+// The length of LIST, i.e. length LIST.
+// O(1).
+size_t mmzk_numlist_length(mmzk_numlist_t *list);
+
+// Store the INDEX-th element of LIST in RESULT, i.e. LIST !! INDEX. Returns false (leaving RESULT untouched) if out of
+// bound.
+// O(n), but only one step per chunk.
+bool mmzk_numlist_get(mmzk_numlist_t *list, size_t index, void *result);
+
+// Whether the value pointed by ELEMENT is an element of LIST, i.e. elem ELEMENT LIST.
+// This function never deallocates LIST, regardless of its persistence state.
+// O(n).
+bool mmzk_numlist_is_elem(const void *element, mmzk_numlist_t *list);
+
+// The index of the first occurrence of the value pointed by ELEMENT in LIST, SIZE_MAX if not found,
+// i.e. elemIndex ELEMENT LIST.
+// This function never deallocates LIST, regardless of its persistence state.
+// O(n).
+size_t mmzk_numlist_elem_index(const void *element, mmzk_numlist_t *list);
+
+// Whether LIST1 and LIST2 have the same type and are element-wise equal. A suffix shared by both lists is taken as
+// equal without comparing its elements.
+// This function never deallocates either list, regardless of their persistence states.
+// O(n).
+bool mmzk_numlist_equal(mmzk_numlist_t *list1, mmzk_numlist_t *list2);
+
+
+/* Composition */
+
+// Construct a list by concatenating LIST1 with LIST2, i.e. LIST1 ++ LIST2. Both lists must have the same type.
+// LIST2 is shared in the new list while LIST1 is copied.
+// O(n).
+mmzk_numlist_t *mmzk_numlist_concat(mmzk_numlist_t *list1, mmzk_numlist_t *list2);
+
+
+/* Transformation */
+
+// Returns a list containing all elements X in LIST such that X OP *OPERAND, i.e. filter (`OP` OPERAND) LIST.
+// OPERAND must point to a value of the element type of LIST.
+// O(n).
+mmzk_numlist_t *mmzk_numlist_filter(mmzk_cmp_op_t op, const void *operand, mmzk_numlist_t *list);
+
+
+/* Reduction */
+
+// Store the sum of LIST in RESULT, i.e. sum LIST.
+// RESULT points to an int64_t if LIST has integer elements, or a double otherwise. For doubles, the order in which the
+// elements are added is unspecified, so the result may differ from a left fold in the last bits.
+// O(n).
+void mmzk_numlist_sum(mmzk_numlist_t *list, void *result);
+
+// Store the minimum of LIST in RESULT, i.e. minimum LIST. Returns false (leaving RESULT untouched) if LIST is empty.
+// RESULT points to a value of the element type. The result is unspecified if LIST contains NaN.
+// O(n).
+bool mmzk_numlist_min(mmzk_numlist_t *list, void *result);
+
+// Store the maximum of LIST in RESULT, i.e. maximum LIST. Returns false (leaving RESULT untouched) if LIST is empty.
+// RESULT points to a value of the element type. The result is unspecified if LIST contains NaN.
+// O(n).
+bool mmzk_numlist_max(mmzk_numlist_t *list, void *result);
+
+#endif /* MMZK_NUMLIST_H */
@@ -0,0 +1,189 @@
+#include <iso646.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../mmzkheap.h"
+#include "mmzktestbase.h"
+
+// Large enough for deep trees and many rounds of pairing.
+#define HEAP_SIZE 1000
+
+static bool int_eq(const void *i1, const void *i2) {
+  return *(int32_t *)i1 == *(int32_t *)i2;
+}
+
+static void *int_copy(const void *i1) {
+  int32_t *result = malloc(sizeof(int32_t));
+  *result = *(int32_t *)i1;
+  return result;
+}
+
+static void int_free(void *i1) {
+  free(i1);
+}
+
+static int int_cmp(const void *i1, const void *i2) {
+  int32_t x = *(int32_t *)i1;
+  int32_t y = *(int32_t *)i2;
+  return (x > y) - (x < y);
+}
+
+static mmzk_funs_t int_funs = (mmzk_funs_t){&int_eq, &int_copy, &int_free};
+
+// The elements 0, 1, ..., HEAP_SIZE - 1 in a scrambled order.
+static int32_t scrambled(int32_t i) {
+  return (int32_t)(((int64_t)i * 7919) % HEAP_SIZE);
+}
+
+// Whether LIST is LOW, LOW + STEP, ..., up to HIGH.
+static bool elems_are(mmzk_list_t *list, int32_t low, int32_t high, int32_t step) {
+  mmzk_list_iterator_t iter = mmzk_list_iterator(list);
+  int32_t expected = low;
+
+  while (mmzk_list_has_next(iter)) {
+    if (expected > high || *(int32_t *)mmzk_list_yield(&iter) != expected) {
+      return false;
+    }
+    expected += step;
+  }
+
+  return expected > high;
+}
+
+static int32_t min_of(mmzk_heap_t *heap) {
+  void *elem = NULL;
+  mmzk_heap_find_min(heap, &elem);
+  int32_t result = *(int32_t *)elem;
+  int_free(elem);
+
+  return result;
+}
+
+static void construction_test(void) {
+  mmzk_heap_t *heap = mmzk_heap_new(int_funs, &int_cmp);
+  mmzk_heap_set_persistence(heap, false);
+  for (int32_t i = 0; i < HEAP_SIZE; i++) {
+    int32_t elem = scrambled(i);
+    heap = mmzk_heap_insert(&elem, heap);
+  }
+  mmzk_heap_set_persistence(heap, true);
+
+  {
+    mmzk_assert_pop_caption("Can insert elements and find the minimum:\n");
+    mmzk_assert_equal_int32(HEAP_SIZE, (int32_t)mmzk_heap_size(heap), "\tsize of heap: ");
+    mmzk_assert_equal_int32(0, min_of(heap), "\tminimum of heap: ");
+    mmzk_list_t *sorted = mmzk_heap_to_list(heap);
+    mmzk_assert_equal_int32(true, elems_are(sorted, 0, HEAP_SIZE - 1, 1), "\telements in order: ");
+    mmzk_assert_equal_int32(HEAP_SIZE, (int32_t)mmzk_heap_size(heap), "\theap intact: ");
+    mmzk_list_free(sorted);
+    mmzk_assert_pop_caption("\n");
+  }
+
+  {
+    mmzk_assert_pop_caption("Can build heaps from lists:\n");
+    void *elems[HEAP_SIZE];
+    int32_t ints[HEAP_SIZE];
+    for (int32_t i = 0; i < HEAP_SIZE; i++) {
+      ints[i] = HEAP_SIZE - i;
+      elems[i] = &ints[i];
+    }
+    mmzk_list_t *list = mmzk_list_from_array(int_funs, HEAP_SIZE, elems);
+    mmzk_heap_t *built = mmzk_heap_from_list(int_funs, &int_cmp, list);
+    mmzk_assert_equal_int32(HEAP_SIZE, (int32_t)mmzk_heap_size(built), "\tsize of heap: ");
+    mmzk_assert_equal_int32(1, min_of(built), "\tminimum of heap: ");
+    mmzk_list_t *sorted = mmzk_heap_to_list(built);
+    mmzk_assert_equal_int32(true, elems_are(sorted, 1, HEAP_SIZE, 1), "\telements in order: ");
+
+    mmzk_list_free(list);
+    mmzk_list_free(sorted);
+    mmzk_heap_free(built);
+    mmzk_assert_pop_caption("\n");
+  }
+
+  {
+    mmzk_assert_pop_caption("Empty heaps:\n");
+    mmzk_heap_t *empty = mmzk_heap_new(int_funs, &int_cmp);
+    void *elem = NULL;
+    mmzk_assert_equal_int32(false, mmzk_heap_find_min(empty, &elem), "\tno minimum: ");
+    mmzk_assert_equal_ptr(NULL, elem, "\tresult untouched: ");
+    mmzk_heap_t *still_empty = mmzk_heap_delete_min(empty);
+    mmzk_assert_equal_int32(0, (int32_t)mmzk_heap_size(still_empty), "\tdeleting from empty heap: ");
+    mmzk_heap_free(empty);
+    mmzk_heap_free(still_empty);
+    mmzk_assert_pop_caption("\n");
+  }
+
+  mmzk_heap_free(heap);
+}
+
+static void persistence_test(void) {
+  mmzk_heap_t *evens = mmzk_heap_new(int_funs, &int_cmp);
+  mmzk_heap_t *odds = mmzk_heap_new(int_funs, &int_cmp);
+  mmzk_heap_set_persistence(evens, false);
+  mmzk_heap_set_persistence(odds, false);
+  for (int32_t i = 0; i < HEAP_SIZE; i++) {
+    int32_t elem = scrambled(i);
+    if (elem % 2 == 0) {
+      evens = mmzk_heap_insert(&elem, evens);
+    } else {
+      odds = mmzk_heap_insert(&elem, odds);
+    }
+  }
+  mmzk_heap_set_persistence(evens, true);
+  mmzk_heap_set_persistence(odds, true);
+
+  {
+    mmzk_assert_pop_caption("Can meld heaps:\n");
+    mmzk_heap_t *melded = mmzk_heap_meld(evens, odds);
+    mmzk_assert_equal_int32(HEAP_SIZE, (int32_t)mmzk_heap_size(melded), "\tsize of melded: ");
+    mmzk_list_t *sorted = mmzk_heap_to_list(melded);
+    mmzk_assert_equal_int32(true, elems_are(sorted, 0, HEAP_SIZE - 1, 1), "\telements in order: ");
+    mmzk_list_free(sorted);
+    sorted = mmzk_heap_to_list(odds);
+    mmzk_assert_equal_int32(true, elems_are(sorted, 1, HEAP_SIZE - 1, 2), "\todds intact: ");
+    mmzk_list_free(sorted);
+    mmzk_heap_free(melded);
+    mmzk_assert_pop_caption("\n");
+  }
+
+  {
+    mmzk_assert_pop_caption("Old versions are not affected by updates:\n");
+    mmzk_heap_t *snapshot = mmzk_heap_copy(evens);
+    mmzk_heap_t *popped = mmzk_heap_copy(evens);
+    mmzk_heap_set_persistence(popped, false);
+    for (int32_t i = 0; i < 100; i++) {
+      popped = mmzk_heap_delete_min(popped);
+    }
+    int32_t elem = -1;
+    popped = mmzk_heap_insert(&elem, popped);
+    mmzk_heap_set_persistence(popped, true);
+    mmzk_assert_equal_int32(-1, min_of(popped), "\tminimum of new version: ");
+    mmzk_assert_equal_int32(HEAP_SIZE / 2 - 99, (int32_t)mmzk_heap_size(popped), "\tsize of new version: ");
+    mmzk_assert_equal_int32(0, min_of(snapshot), "\tminimum of old version: ");
+    mmzk_list_t *sorted = mmzk_heap_to_list(snapshot);
+    mmzk_assert_equal_int32(true, elems_are(sorted, 0, HEAP_SIZE - 2, 2), "\told version intact: ");
+    mmzk_list_free(sorted);
+
+    mmzk_heap_t *again = mmzk_heap_delete_min(snapshot);
+    mmzk_assert_equal_int32(2, min_of(again), "\tdeleting from old version again: ");
+
+    mmzk_heap_free(snapshot);
+    mmzk_heap_free(popped);
+    mmzk_heap_free(again);
+    mmzk_assert_pop_caption("\n");
+  }
+
+  mmzk_heap_free(evens);
+  mmzk_heap_free(odds);
+}
+
+static void test_summary(void) {
+  mmzk_test_summary(construction_test, "Test heap construction:\n");
+  mmzk_test_summary(persistence_test, "Test heap melding and persistence:\n");
+}
+
+int32_t main(int32_t argc, char **argv) {
+  return mmzk_test_report(test_summary, argc, argv);
+}
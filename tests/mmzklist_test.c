@@ -1,5 +1,6 @@
 #include <iso646.h>
 #include <math.h>
+#include <pthread.h>
 #include <stdbool.h>
 #include <stdint.h>
 #include <stdio.h>
@@ -47,11 +48,168 @@ static void int_free(void *i1) {
   free(i1);
 }
 
+static void *int_alias(const void *i1) {
+  return (void *)i1;
+}
+
 static bool less_than_five(const void *i1) {
   return *(int32_t *)i1 < 5;
 }
 
+static bool not_less_than_five(const void *i1) {
+  return *(int32_t *)i1 >= 5;
+}
+
+static size_t int_hash(const void *i1) {
+  return (size_t)*(int32_t *)i1;
+}
+
+// The number of calls to counted_eq, which shows whether a query scanned the list.
+static int32_t eq_calls = 0;
+
+static bool counted_eq(const void *i1, const void *i2) {
+  eq_calls++;
+  return int_eq(i1, i2);
+}
+
+// A list that nested_hash queries, so that building a hash index with it queries another indexed list.
+static mmzk_list_t *nested_list = NULL;
+
+static size_t nested_hash(const void *i1) {
+  mmzk_list_is_elem(i1, nested_list);
+  return int_hash(i1);
+}
+
+static int int_cmp(const void *i1, const void *i2) {
+  return (*(int32_t *)i1 > *(int32_t *)i2) - (*(int32_t *)i1 < *(int32_t *)i2);
+}
+
+static int tens_cmp(const void *i1, const void *i2) {
+  return (*(int32_t *)i1 / 10 > *(int32_t *)i2 / 10) - (*(int32_t *)i1 / 10 < *(int32_t *)i2 / 10);
+}
+
+static void *sum_worker(const void *i1, const void *i2, void *arg) {
+  int32_t *result = malloc(sizeof(int32_t));
+  *result = *(int32_t *)i1 + *(int32_t *)i2;
+  return result;
+}
+
+static void *copy_worker(const void *i1, void *arg) {
+  return int_copy(i1);
+}
+
+static void *tens_key(const void *i1, void *arg) {
+  int32_t *result = malloc(sizeof(int32_t));
+  *result = *(int32_t *)i1 / 10;
+  return result;
+}
+
+static void *add_left(void *accum, const void *i1) {
+  *(int32_t *)accum += *(int32_t *)i1;
+  return accum;
+}
+
+// Keep the first element that is smaller than the accumulator, so that the order of a fold can be observed.
+static void *first_below_right(const void *i1, void *accum) {
+  if (*(int32_t *)i1 < *(int32_t *)accum) {
+    *(int32_t *)accum = *(int32_t *)i1;
+  }
+  return accum;
+}
+
+static void *plus(const void *i1, const void *i2, void *arg) {
+  int32_t *result = malloc(sizeof(int32_t));
+  *result = *(int32_t *)i1 + *(int32_t *)i2;
+  return result;
+}
+
+// Associative but not commutative, so that the order of a parallel scan can be observed.
+static void *second(const void *i1, const void *i2, void *arg) {
+  return int_copy(i2);
+}
+
+static void *append_digit_left(const void *accum, const void *i1, void *arg) {
+  int32_t *result = malloc(sizeof(int32_t));
+  *result = *(int32_t *)accum * 10 + *(int32_t *)i1;
+  return result;
+}
+
+static void *append_digit_right(const void *i1, const void *accum, void *arg) {
+  return append_digit_left(accum, i1, arg);
+}
+
+static mmzk_list_t *cons_next(mmzk_list_t *list, void *arg) {
+  int32_t next = (int32_t)mmzk_list_length(list) + 1;
+  return mmzk_list_cons(&next, list);
+}
+
+// Load snapshots of a cell that counts down from its length to 1 until it reaches the length in ARG, checking that
+// each snapshot is whole. Returns a non-NULL pointer if any is not.
+static void *ref_reader(void *arg) {
+  mmzk_list_ref_t *ref = ((void **)arg)[0];
+  int32_t target = *(int32_t *)((void **)arg)[1];
+  size_t len = 0;
+  bool is_whole = true;
+
+  while (len < (size_t)target) {
+    mmzk_list_t *snapshot = mmzk_list_ref_load(ref);
+    len = mmzk_list_length(snapshot);
+    mmzk_list_iterator_t iter = mmzk_list_iterator(snapshot);
+    int32_t expected = (int32_t)len;
+    while (mmzk_list_has_next(iter)) {
+      is_whole &= *(int32_t *)mmzk_list_yield(&iter) == expected--;
+    }
+    mmzk_list_ref_release(ref, snapshot);
+  }
+
+  return is_whole ? NULL : arg;
+}
+
+// Query the list of 0 to 99 in ARG for 0 to 199 a few times. Returns a non-NULL pointer if any answer is wrong.
+static void *query_reader(void *arg) {
+  bool is_right = true;
+
+  for (int32_t round = 0; round < 4; round++) {
+    for (int32_t i = 0; i < 200; i++) {
+      is_right &= mmzk_list_is_elem(&i, arg) == (i < 100);
+      is_right &= mmzk_list_elem_index(&i, arg) == (i < 100 ? (size_t)i : SIZE_MAX);
+    }
+  }
+
+  return is_right ? NULL : arg;
+}
+
+// Get every element of the list of 0 to 999 in ARG a few times. Returns a non-NULL pointer if any is wrong.
+static void *seek_reader(void *arg) {
+  bool is_right = true;
+
+  for (int32_t round = 0; round < 4; round++) {
+    for (int32_t i = 0; i < 1000; i++) {
+      int32_t *elem = mmzk_list_get(arg, (size_t)i);
+      is_right &= *elem == i;
+      int_free(elem);
+    }
+  }
+
+  return is_right ? NULL : arg;
+}
+
+static bool is_sorted(mmzk_list_t *list) {
+  mmzk_list_iterator_t iter = mmzk_list_iterator(list);
+  int32_t prev = INT32_MIN;
+  while (mmzk_list_has_next(iter)) {
+    int32_t cur = *(int32_t *)mmzk_list_yield(&iter);
+    if (cur < prev) {
+      return false;
+    }
+    prev = cur;
+  }
+
+  return true;
+}
+
 static mmzk_funs_t int_funs = (mmzk_funs_t){&int_eq, &int_copy, &int_free};
+static mmzk_funs_t int_hash_funs = (mmzk_funs_t){&int_eq, &int_copy, &int_free, &int_hash};
 
 static void construction_test(void) {
   {
@@ -108,6 +266,33 @@ static void construction_test(void) {
     mmzk_assert_pop_caption("\n");
   }
 
+  {
+    mmzk_assert_pop_caption("Can convert long arrays and lists in parallel:\n");
+    void **_1_12300 = make_range(1, 12300);
+    mmzk_list_t *serial = mmzk_list_from_array(int_funs, 12300, _1_12300);
+    mmzk_list_t *parallel = mmzk_list_from_array_parallel(int_funs, 12300, _1_12300, 4);
+    mmzk_assert_equal_int32(12300, mmzk_list_length(parallel), "\tlength parallel == 12300: ");
+    mmzk_assert_equal_int32(true, mmzk_list_equal(serial, parallel), "\tparallel == serial: ");
+    mmzk_list_t *short_list = mmzk_list_from_array_parallel(int_funs, 10, _1_12300, 4);
+    mmzk_assert_equal_int32(10, mmzk_list_length(short_list), "\tlength short_list == 10: ");
+
+    size_t len = 0;
+    void **arr = mmzk_list_to_array_parallel(parallel, NULL, &len, 3);
+    mmzk_assert_equal_int32(12300, (int32_t)len, "\tlength arr == 12300: ");
+    bool is_matching = true;
+    for (int32_t i = 0; i < 12300; i++) {
+      is_matching &= *(int32_t *)arr[i] == i + 1;
+    }
+    mmzk_assert_equal_int32(true, is_matching, "\tarray elements check: ");
+
+    mmzk_list_free(serial);
+    mmzk_list_free(parallel);
+    mmzk_list_free(short_list);
+    free_arr(arr, 12300);
+    free_arr(_1_12300, 12300);
+    mmzk_assert_pop_caption("\n");
+  }
+
   {
     mmzk_assert_pop_caption("Can construct list from non-empty array and copy it:\n");
     void **_1_10 = make_range(1, 10);
@@ -131,6 +316,222 @@ static void construction_test(void) {
   }
 }
 
+static void builder_test(void) {
+  {
+    mmzk_assert_pop_caption("Can take over elements instead of copying them:\n");
+    void **_1_10 = make_range(1, 10);
+    void **_11_20 = make_range(11, 20);
+    void *first = _1_10[0];
+    mmzk_list_t *tail = mmzk_list_from_array_move(int_funs, 9, _1_10 + 1);
+    mmzk_list_set_persistence(tail, false);
+    mmzk_list_t *moved = mmzk_list_cons_move(first, tail);
+    mmzk_list_set_persistence(moved, true);
+    mmzk_list_builder_t *builder = mmzk_list_builder_new(int_funs);
+    mmzk_list_builder_prepend_list(builder, moved);
+    mmzk_list_builder_append_move(builder, _11_20[0]);
+    mmzk_list_builder_append_many_move(builder, 9, _11_20 + 1);
+    mmzk_list_t *one_to_twenty = mmzk_list_builder_freeze(builder);
+    void *head = mmzk_list_get(moved, 0);
+    mmzk_assert_equal_int32(true, head != first, "\tget copies the moved element: ");
+    int_free(head);
+    mmzk_assert_equal_int32(20, mmzk_list_length(one_to_twenty), "\tlength one_to_twenty == 20: ");
+    for (int32_t i = 0; i < 20; i++) {
+      CHKELM(i + 1, one_to_twenty, i);
+    }
+    mmzk_list_free(moved);
+    mmzk_list_free(one_to_twenty);
+    free(_1_10);
+    free(_11_20);
+    mmzk_assert_pop_caption("\n");
+  }
+
+  {
+    mmzk_assert_pop_caption("Can freeze empty builder:\n");
+    mmzk_list_builder_t *builder = mmzk_list_builder_new(int_funs);
+    mmzk_list_t *empty_list = mmzk_list_builder_freeze(builder);
+    mmzk_assert_equal_int32(0, mmzk_list_length(empty_list), "\tlength empty_list == 0: ");
+    mmzk_list_free(empty_list);
+    mmzk_assert_pop_caption("\n");
+  }
+
+  {
+    mmzk_assert_pop_caption("Can append elements one by one and in bulk:\n");
+    void **_1_1000 = make_range(1, 1000);
+    mmzk_list_builder_t *builder = mmzk_list_builder_new(int_funs);
+    for (int32_t i = 0; i < 300; i++) {
+      mmzk_list_builder_append(builder, _1_1000[i]);
+    }
+    mmzk_list_builder_append_many(builder, 700, _1_1000 + 300);
+    mmzk_assert_equal_int32(1000, mmzk_list_builder_length(builder), "\tlength builder == 1000: ");
+    mmzk_list_t *one_to_thousand = mmzk_list_builder_freeze(builder);
+    mmzk_list_t *expected = mmzk_list_from_array(int_funs, 1000, _1_1000);
+    mmzk_assert_equal_int32(1000, mmzk_list_length(one_to_thousand), "\tlength one_to_thousand == 1000: ");
+    mmzk_assert_equal_int32(true, mmzk_list_equal(expected, one_to_thousand), "\tone_to_thousand == [1..1000]: ");
+
+    mmzk_list_free(one_to_thousand);
+    mmzk_list_free(expected);
+    free_arr(_1_1000, 1000);
+    mmzk_assert_pop_caption("\n");
+  }
+
+  {
+    mmzk_assert_pop_caption("Can prepend persistent and non-persistent lists:\n");
+    void **_1_10 = make_range(1, 10);
+    mmzk_list_t *one_to_three = mmzk_list_from_array(int_funs, 3, _1_10);
+    mmzk_list_t *four_to_six = mmzk_list_from_array(int_funs, 3, _1_10 + 3);
+    mmzk_list_set_persistence(four_to_six, false);
+    mmzk_list_builder_t *builder = mmzk_list_builder_new(int_funs);
+    mmzk_list_builder_append_many(builder, 4, _1_10 + 6);
+    mmzk_list_builder_prepend_list(builder, four_to_six);
+    mmzk_list_builder_prepend_list(builder, one_to_three);
+    mmzk_list_t *one_to_ten = mmzk_list_builder_freeze(builder);
+    mmzk_assert_equal_int32(10, mmzk_list_length(one_to_ten), "\tlength one_to_ten == 10: ");
+    for (int32_t i = 0; i < 10; i++) {
+      CHKELM(i + 1, one_to_ten, i);
+    }
+    for (int32_t i = 0; i < 3; i++) {
+      CHKELM(i + 1, one_to_three, i);
+    }
+
+    mmzk_list_free(one_to_ten);
+    mmzk_list_free(one_to_three);
+    free_arr(_1_10, 10);
+    mmzk_assert_pop_caption("\n");
+  }
+
+  {
+    mmzk_assert_pop_caption("Can filter list:\n");
+    void **_1_10 = make_range(1, 10);
+    mmzk_list_t *one_to_ten = mmzk_list_from_array(int_funs, 10, _1_10);
+    mmzk_list_t *take8 = mmzk_list_take(8, one_to_ten);
+    mmzk_list_t *filtered = mmzk_list_filter(&less_than_five, one_to_ten);
+    mmzk_list_t *filtered_take8 = mmzk_list_filter(&not_less_than_five, take8);
+    mmzk_assert_equal_int32(4, mmzk_list_length(filtered), "\tlength filtered == 4: ");
+    mmzk_assert_equal_int32(4, mmzk_list_length(filtered_take8), "\tlength filtered_take8 == 4: ");
+    for (int32_t i = 0; i < 4; i++) {
+      CHKELM(i + 1, filtered, i);
+      CHKELM(i + 5, filtered_take8, i);
+    }
+
+    mmzk_list_free(one_to_ten);
+    mmzk_list_free(take8);
+    mmzk_list_free(filtered);
+    mmzk_list_free(filtered_take8);
+    free_arr(_1_10, 10);
+    mmzk_assert_pop_caption("\n");
+  }
+}
+
+static void compact_test(void) {
+  void **_1_100 = make_range(1, 100);
+  mmzk_list_t *one_to_hundred = mmzk_list_from_array(int_funs, 100, _1_100);
+  free_arr(_1_100, 100);
+
+  {
+    mmzk_assert_pop_caption("Can compact persistent list:\n");
+    mmzk_list_t *compacted = mmzk_list_compact(one_to_hundred);
+    mmzk_assert_equal_int32(100, mmzk_list_length(compacted), "\tlength compacted == 100: ");
+    mmzk_assert_equal_int32(true, mmzk_list_equal(one_to_hundred, compacted), "\tcompacted == [1..100]: ");
+    mmzk_list_free(compacted);
+    mmzk_assert_pop_caption("\n");
+  }
+
+  {
+    mmzk_assert_pop_caption("Compacting non-persistent list keeps the shared suffix intact:\n");
+    mmzk_list_t *drop50 = mmzk_list_drop(50, one_to_hundred);
+    mmzk_list_t *list = mmzk_list_sort(&int_cmp, one_to_hundred);
+    mmzk_list_set_persistence(list, false);
+    mmzk_list_t *take80 = mmzk_list_take(80, list);
+    mmzk_list_t *shared = mmzk_list_copy(drop50);
+    mmzk_list_set_persistence(shared, false);
+    mmzk_list_t *compacted = mmzk_list_compact(mmzk_list_concat(take80, shared));
+    mmzk_list_set_persistence(compacted, true);
+    mmzk_assert_equal_int32(130, mmzk_list_length(compacted), "\tlength compacted == 130: ");
+    for (int32_t i = 0; i < 130; i++) {
+      CHKELM(i < 80 ? i + 1 : i - 29, compacted, i);
+    }
+    mmzk_assert_equal_int32(50, mmzk_list_length(drop50), "\tlength drop50 == 50: ");
+    for (int32_t i = 0; i < 50; i++) {
+      CHKELM(i + 51, drop50, i);
+    }
+
+    mmzk_list_free(compacted);
+    mmzk_list_free(drop50);
+    mmzk_assert_pop_caption("\n");
+  }
+
+  mmzk_list_free(one_to_hundred);
+}
+
+static void region_test(void) {
+  void **_1_100 = make_range(1, 100);
+
+  {
+    mmzk_assert_pop_caption("Lists derived from a list in a region work as usual:\n");
+    mmzk_region_t *region = mmzk_region_new();
+    mmzk_list_t *one_to_hundred = mmzk_list_from_array_in(region, int_hash_funs, 100, _1_100);
+    mmzk_list_set_persistence(one_to_hundred, false);
+    int32_t zero = 0;
+    mmzk_list_t *consed = mmzk_list_cons(&zero, one_to_hundred);
+    mmzk_list_t *drop50 = mmzk_list_drop(50, one_to_hundred);
+    mmzk_list_t *take10 = mmzk_list_take(10, consed);
+    mmzk_list_t *concat = mmzk_list_concat(take10, drop50);
+    mmzk_list_t *sorted = mmzk_list_sort(&tens_cmp, mmzk_list_filter(&not_less_than_five, concat));
+    mmzk_assert_equal_int32(100, mmzk_list_length(one_to_hundred), "\tlength one_to_hundred == 100: ");
+    mmzk_assert_equal_int32(60, mmzk_list_length(concat), "\tlength concat == 60: ");
+    for (int32_t i = 0; i < 60; i++) {
+      CHKELM(i < 10 ? i : i + 41, concat, i);
+    }
+    mmzk_assert_equal_int32(55, mmzk_list_length(sorted), "\tlength sorted == 55: ");
+    mmzk_assert_equal_int32(true, is_sorted(sorted), "\tsorted is sorted: ");
+    for (int32_t i = 0; i < 8; i++) {
+      mmzk_assert_equal_int32(i < 6, mmzk_list_is_elem(&(int32_t) { i + 95 }, consed), "\tis_elem in consed: ");
+    }
+    for (int32_t i = 0; i < 8; i++) {
+      CHKELM(i * 10 + 1, one_to_hundred, i * 10);
+    }
+    mmzk_list_free(drop50);
+    mmzk_list_free(drop50);
+    CHKELM(51, drop50, 0);
+    mmzk_region_destroy(region);
+    mmzk_assert_pop_caption("\n");
+  }
+
+  {
+    mmzk_assert_pop_caption("Builders and zipped lists in a region:\n");
+    mmzk_region_t *region = mmzk_region_new();
+    mmzk_list_builder_t *builder = mmzk_list_builder_new_in(region, int_funs);
+    mmzk_list_builder_append_many(builder, 100, _1_100);
+    mmzk_list_t *built = mmzk_list_builder_freeze(builder);
+    mmzk_list_t *doubled = mmzk_list_zip_with(int_funs, &sum_worker, built, built, NULL);
+    mmzk_list_tuple_t unzipped = mmzk_list_unzip(int_funs, int_funs, mmzk_list_zip(built, doubled));
+    mmzk_assert_equal_int32(100, mmzk_list_length(unzipped.snd), "\tlength unzipped.snd == 100: ");
+    for (int32_t i = 0; i < 100; i += 9) {
+      CHKELM(2 * i + 2, unzipped.snd, i);
+    }
+    mmzk_assert_equal_int32(true, mmzk_list_equal(built, unzipped.fst), "\tunzipped.fst == built: ");
+    mmzk_region_destroy(region);
+    mmzk_assert_pop_caption("\n");
+  }
+
+  {
+    mmzk_assert_pop_caption("Elements without a free function are left alone:\n");
+    static int32_t values[] = { 3, 1, 2 };
+    mmzk_funs_t static_funs = { .eq_fun = &int_eq, .copy_fun = &int_alias, .free_fun = NULL };
+    mmzk_region_t *region = mmzk_region_new();
+    mmzk_list_t *list = mmzk_list_new_in(region, static_funs);
+    for (int32_t i = 0; i < 3; i++) {
+      list = mmzk_list_cons(&values[i], list);
+    }
+    mmzk_assert_equal_int32(true, mmzk_list_get(list, 0) == &values[2], "\thead is values[2]: ");
+    mmzk_list_free(list);
+    mmzk_region_destroy(region);
+    mmzk_assert_pop_caption("\n");
+  }
+
+  free_arr(_1_100, 100);
+}
+
 static void composition_test(void) {
   mmzk_list_t *nil = mmzk_list_new(int_funs);
   MKINT(1);
@@ -339,6 +740,71 @@ static void take_drop_test(void) {
   mmzk_list_free(one_to_ten);
 }
 
+static void trim_test(void) {
+  void **_1_100 = make_range(1, 100);
+  mmzk_list_t *one_to_hundred = mmzk_list_from_array(int_funs, 100, _1_100);
+  free_arr(_1_100, 100);
+
+  {
+    mmzk_assert_pop_caption("Trimming a prefix releases the rest of the chain:\n");
+    mmzk_list_t *take10 = mmzk_list_take(10, one_to_hundred);
+    mmzk_list_t *trimmed = mmzk_list_trim(take10);
+    mmzk_list_memory_report_t report = mmzk_list_memory_report(trimmed);
+    mmzk_assert_equal_int32(10, (int32_t)report.reachable, "\ttrimmed reachable == 10: ");
+    mmzk_assert_equal_int32(10, (int32_t)report.unique, "\ttrimmed unique == 10: ");
+    mmzk_assert_equal_int32(true, mmzk_list_equal(take10, trimmed), "\ttrimmed == take10: ");
+    mmzk_list_t *again = mmzk_list_trim(trimmed);
+    report = mmzk_list_memory_report_many(2, (mmzk_list_t *[]) { trimmed, again });
+    mmzk_assert_equal_int32(10, (int32_t)report.reachable, "\ttrimming a trimmed list shares it: ");
+    mmzk_list_free(again);
+    mmzk_list_free(trimmed);
+    mmzk_list_free(take10);
+    mmzk_assert_pop_caption("\n");
+  }
+
+  {
+    mmzk_assert_pop_caption("Trimming a non-persistent view reuses its own nodes:\n");
+    mmzk_list_t *copy = mmzk_list_map(int_funs, &copy_worker, one_to_hundred, NULL);
+    mmzk_list_set_persistence(copy, false);
+    mmzk_list_t *init = mmzk_list_init(mmzk_list_take(30, mmzk_list_drop(50, copy)));
+    mmzk_list_t *trimmed = mmzk_list_trim(init);
+    mmzk_list_set_persistence(trimmed, true);
+    mmzk_assert_equal_int32(29, (int32_t)mmzk_list_memory_report(trimmed).reachable, "\ttrimmed reachable == 29: ");
+    for (int32_t i = 0; i < 29; i++) {
+      CHKELM(i + 51, trimmed, i);
+    }
+    mmzk_list_free(trimmed);
+    mmzk_assert_pop_caption("\n");
+  }
+
+  {
+    mmzk_assert_pop_caption("Take and init trim according to the ratio:\n");
+    mmzk_list_set_trim_ratio(4);
+    mmzk_list_t *take10 = mmzk_list_take(10, one_to_hundred);
+    mmzk_list_t *take50 = mmzk_list_take(50, one_to_hundred);
+    mmzk_list_t *init = mmzk_list_init(take50);
+    mmzk_list_t *drop_end = mmzk_list_drop_end(95, one_to_hundred);
+    mmzk_list_t *take0 = mmzk_list_take(0, one_to_hundred);
+    mmzk_assert_equal_int32(10, (int32_t)mmzk_list_memory_report(take10).reachable, "\ttake10 reachable == 10: ");
+    mmzk_assert_equal_int32(100, (int32_t)mmzk_list_memory_report(take50).reachable, "\ttake50 reachable == 100: ");
+    mmzk_assert_equal_int32(100, (int32_t)mmzk_list_memory_report(init).reachable, "\tinit reachable == 100: ");
+    mmzk_assert_equal_int32(5, (int32_t)mmzk_list_memory_report(drop_end).reachable, "\tdrop_end reachable == 5: ");
+    mmzk_assert_equal_int32(0, (int32_t)mmzk_list_memory_report(take0).reachable, "\ttake0 reachable == 0: ");
+    for (int32_t i = 0; i < 10; i++) {
+      CHKELM(i + 1, take10, i);
+    }
+    mmzk_list_set_trim_ratio(0);
+    mmzk_list_free(take10);
+    mmzk_list_free(take50);
+    mmzk_list_free(init);
+    mmzk_list_free(drop_end);
+    mmzk_list_free(take0);
+    mmzk_assert_pop_caption("\n");
+  }
+
+  mmzk_list_free(one_to_hundred);
+}
+
 static void split_span_test(void) {
   mmzk_list_t *nil = mmzk_list_new(int_funs);
   void **_1_10 = make_range(1, 10);
@@ -448,11 +914,989 @@ static void split_span_test(void) {
   mmzk_list_free(one_to_ten);
 }
 
+static void update_test(void) {
+  void **_1_10 = make_range(1, 10);
+  mmzk_list_t *one_to_ten = mmzk_list_from_array(int_funs, 10, _1_10);
+  free_arr(_1_10, 10);
+
+  {
+    mmzk_assert_pop_caption("Can set an element of a persistent list:\n");
+    int32_t zero = 0;
+    mmzk_list_t *set0 = mmzk_list_set(0, &zero, one_to_ten);
+    mmzk_list_t *set4 = mmzk_list_set(4, &zero, one_to_ten);
+    mmzk_list_t *set9 = mmzk_list_set(9, &zero, one_to_ten);
+    mmzk_list_t *set10 = mmzk_list_set(10, &zero, one_to_ten);
+    mmzk_assert_equal_ptr(NULL, set10, "\tset10 is NULL: ");
+    mmzk_assert_equal_int32(10, mmzk_list_length(set4), "\tlength set4 == 10: ");
+    for (int32_t i = 0; i < 10; i++) {
+      CHKELM(i == 0 ? 0 : i + 1, set0, i);
+      CHKELM(i == 4 ? 0 : i + 1, set4, i);
+      CHKELM(i == 9 ? 0 : i + 1, set9, i);
+      CHKELM(i + 1, one_to_ten, i);
+    }
+    mmzk_list_free(set0);
+    mmzk_list_free(set4);
+    mmzk_list_free(set9);
+    mmzk_assert_pop_caption("\n");
+  }
+
+  {
+    mmzk_assert_pop_caption("Can set many elements at once, the last update winning:\n");
+    int32_t values[] = { 100, 200, 300, 400 };
+    void *elems[] = { &values[0], &values[1], &values[2], &values[3] };
+    size_t indices[] = { 1, 3, 3, 6 };
+    mmzk_list_t *updated = mmzk_list_set_many(4, indices, elems, one_to_ten);
+    int32_t expected[] = { 1, 100, 3, 300, 5, 6, 400, 8, 9, 10 };
+    for (int32_t i = 0; i < 10; i++) {
+      CHKELM(expected[i], updated, i);
+    }
+    mmzk_list_t *unchanged = mmzk_list_set_many(0, NULL, NULL, one_to_ten);
+    mmzk_assert_equal_int32(true, mmzk_list_equal(unchanged, one_to_ten), "\tno updates: ");
+    size_t out_of_bound[] = { 2, 10 };
+    mmzk_assert_equal_ptr(NULL, mmzk_list_set_many(2, out_of_bound, elems, one_to_ten), "\tout of bound: ");
+    mmzk_list_free(updated);
+    mmzk_list_free(unchanged);
+    mmzk_assert_pop_caption("\n");
+  }
+
+  {
+    mmzk_assert_pop_caption("Non-persistent lists are updated without disturbing shared nodes:\n");
+    int32_t zero = 0;
+    mmzk_list_t *copy = mmzk_list_copy(one_to_ten);
+    mmzk_list_set_persistence(copy, false);
+    mmzk_list_t *shared = mmzk_list_drop(5, one_to_ten);
+    mmzk_list_t *taken = mmzk_list_take(3, one_to_ten);
+    mmzk_list_set_persistence(taken, false);
+    copy = mmzk_list_concat(taken, copy);
+    size_t indices[] = { 0, 2, 7 };
+    copy = mmzk_list_set_many(3, indices, (void *[]) { &zero, &zero, &zero }, copy);
+    int32_t expected[] = { 0, 2, 0, 1, 2, 3, 4, 0, 6, 7, 8, 9, 10 };
+    mmzk_assert_equal_int32(13, mmzk_list_length(copy), "\tlength == 13: ");
+    for (int32_t i = 0; i < 13; i++) {
+      CHKELM(expected[i], copy, i);
+    }
+    for (int32_t i = 0; i < 5; i++) {
+      CHKELM(i + 6, shared, i);
+    }
+    mmzk_list_t *short_list = mmzk_list_take(4, copy);
+    mmzk_list_set_persistence(short_list, false);
+    short_list = mmzk_list_set(3, &zero, short_list);
+    mmzk_assert_equal_int32(4, mmzk_list_length(short_list), "\tlength of short list == 4: ");
+    CHKELM(0, short_list, 3);
+    mmzk_list_free(short_list);
+    mmzk_list_free(shared);
+    mmzk_assert_pop_caption("\n");
+  }
+
+  mmzk_list_free(one_to_ten);
+}
+
+static void memory_report_test(void) {
+  void **_1_10 = make_range(1, 10);
+  mmzk_list_t *one_to_ten = mmzk_list_from_array(int_funs, 10, _1_10);
+  free_arr(_1_10, 10);
+
+  {
+    mmzk_assert_pop_caption("A list owning all of its nodes:\n");
+    mmzk_list_memory_report_t report = mmzk_list_memory_report(one_to_ten);
+    mmzk_assert_equal_int32(10, (int32_t)report.reachable, "\treachable == 10: ");
+    mmzk_assert_equal_int32(10, (int32_t)report.unique, "\tunique == 10: ");
+    mmzk_assert_equal_int32(0, (int32_t)report.shared, "\tshared == 0: ");
+    mmzk_assert_equal_int32(0, (int32_t)report.beyond_length, "\tbeyond_length == 0: ");
+    mmzk_assert_pop_caption("\n");
+  }
+
+  {
+    mmzk_assert_pop_caption("Truncated and consed lists pin shared nodes:\n");
+    int32_t zero = 0;
+    mmzk_list_t *take3 = mmzk_list_take(3, one_to_ten);
+    mmzk_list_t *consed = mmzk_list_cons(&zero, one_to_ten);
+    mmzk_list_memory_report_t report = mmzk_list_memory_report(take3);
+    mmzk_assert_equal_int32(10, (int32_t)report.reachable, "\ttake3 reachable == 10: ");
+    mmzk_assert_equal_int32(10, (int32_t)report.shared, "\ttake3 shared == 10: ");
+    mmzk_assert_equal_int32(7, (int32_t)report.beyond_length, "\ttake3 beyond_length == 7: ");
+    report = mmzk_list_memory_report(consed);
+    mmzk_assert_equal_int32(11, (int32_t)report.reachable, "\tconsed reachable == 11: ");
+    mmzk_assert_equal_int32(1, (int32_t)report.unique, "\tconsed unique == 1: ");
+    report = mmzk_list_memory_report_many(3, (mmzk_list_t *[]) { take3, one_to_ten, consed });
+    mmzk_assert_equal_int32(11, (int32_t)report.reachable, "\tall reachable == 11: ");
+    mmzk_assert_equal_int32(11, (int32_t)report.unique, "\tall unique == 11: ");
+    mmzk_assert_equal_int32(0, (int32_t)report.beyond_length, "\tall beyond_length == 0: ");
+    mmzk_list_free(take3);
+    mmzk_list_free(consed);
+    mmzk_assert_pop_caption("\n");
+  }
+
+  {
+    mmzk_assert_pop_caption("Dropped lists only reach their suffix:\n");
+    mmzk_list_t *drop5 = mmzk_list_drop(5, one_to_ten);
+    mmzk_list_memory_report_t report = mmzk_list_memory_report(drop5);
+    mmzk_assert_equal_int32(5, (int32_t)report.reachable, "\tdrop5 reachable == 5: ");
+    mmzk_assert_equal_int32(5, (int32_t)report.shared, "\tdrop5 shared == 5: ");
+    report = mmzk_list_memory_report(one_to_ten);
+    mmzk_assert_equal_int32(5, (int32_t)report.unique, "\tone_to_ten unique == 5: ");
+    mmzk_assert_equal_int32(true, report.node_bytes > 0 && report.bytes_beyond_length == 0, "\tbyte counts: ");
+    mmzk_list_free(drop5);
+    mmzk_assert_pop_caption("\n");
+  }
+
+  mmzk_list_free(one_to_ten);
+}
+
+static void query_test(void) {
+  void **_0_99 = make_range(0, 99);
+  mmzk_list_t *plain = mmzk_list_from_array(int_funs, 100, _0_99);
+  mmzk_list_t *hashed = mmzk_list_from_array(int_hash_funs, 100, _0_99);
+  free_arr(_0_99, 100);
+
+  {
+    mmzk_assert_pop_caption("Can find elements by linear search and by hash index:\n");
+    for (int32_t round = 0; round < 8; round++) {
+      for (int32_t i = -5; i < 105; i++) {
+        bool expected = i >= 0 && i < 100;
+        mmzk_assert_equal_int32(expected, mmzk_list_is_elem(&i, plain), "\tis_elem in plain: ");
+        mmzk_assert_equal_int32(expected, mmzk_list_is_elem(&i, hashed), "\tis_elem in hashed: ");
+        int32_t index = (int32_t)mmzk_list_elem_index(&i, hashed);
+        mmzk_assert_equal_int32(expected ? i : -1, index, "\telem_index in hashed: ");
+      }
+    }
+    mmzk_assert_pop_caption("\n");
+  }
+
+  {
+    mmzk_assert_pop_caption("Lists starting from the same node respect their own lengths:\n");
+    mmzk_list_t *take40 = mmzk_list_take(40, hashed);
+    mmzk_list_t *take60 = mmzk_list_take(60, hashed);
+    for (int32_t round = 0; round < 8; round++) {
+      for (int32_t i = 0; i < 100; i++) {
+        mmzk_assert_equal_int32(i < 40, mmzk_list_is_elem(&i, take40), "\tis_elem in take40: ");
+        mmzk_assert_equal_int32(i < 60, mmzk_list_is_elem(&i, take60), "\tis_elem in take60: ");
+      }
+    }
+    mmzk_list_free(take40);
+    mmzk_list_free(take60);
+    mmzk_assert_pop_caption("\n");
+  }
+
+  {
+    mmzk_assert_pop_caption("Longer lists do not reuse the hash index of a shorter one:\n");
+    void **_0_999 = make_range(0, 999);
+    mmzk_list_t *list = mmzk_list_from_array((mmzk_funs_t){&counted_eq, &int_copy, &int_free, &int_hash}, 1000, _0_999);
+    free_arr(_0_999, 1000);
+    mmzk_list_t *take50 = mmzk_list_take(50, list);
+    int32_t last = 999;
+    for (int32_t round = 0; round < 8; round++) {
+      mmzk_assert_equal_int32(false, mmzk_list_is_elem(&last, take50), "\tis_elem in take50: ");
+      mmzk_assert_equal_int32(true, mmzk_list_is_elem(&last, list), "\tis_elem in list: ");
+    }
+    eq_calls = 0;
+    mmzk_assert_equal_int32(999, (int32_t)mmzk_list_elem_index(&last, list), "\telem_index in list: ");
+    mmzk_assert_equal_int32(1, eq_calls, "\tfound by index: ");
+    eq_calls = 0;
+    mmzk_assert_equal_int32(-1, (int32_t)mmzk_list_elem_index(&last, take50), "\telem_index in take50: ");
+    mmzk_assert_equal_int32(0, eq_calls, "\tmissed by index: ");
+    mmzk_list_free(take50);
+    mmzk_list_free(list);
+    mmzk_assert_pop_caption("\n");
+  }
+
+  {
+    mmzk_assert_pop_caption("Hash functions may query other indexed lists:\n");
+    void **_0_99 = make_range(0, 99);
+    nested_list = mmzk_list_from_array(int_hash_funs, 100, _0_99);
+    mmzk_list_t *list = mmzk_list_from_array((mmzk_funs_t){&int_eq, &int_copy, &int_free, &nested_hash}, 100, _0_99);
+    free_arr(_0_99, 100);
+    for (int32_t round = 0; round < 8; round++) {
+      for (int32_t i = 0; i < 100; i += 7) {
+        mmzk_assert_equal_int32(i, (int32_t)mmzk_list_elem_index(&i, list), "\telem_index in list: ");
+      }
+    }
+    mmzk_list_free(list);
+    mmzk_list_free(nested_list);
+    mmzk_assert_pop_caption("\n");
+  }
+
+  {
+    mmzk_assert_pop_caption("The same list can be queried from several threads:\n");
+    for (int32_t round = 0; round < 8; round++) {
+      void **_0_99 = make_range(0, 99);
+      mmzk_list_t *list = mmzk_list_from_array(int_hash_funs, 100, _0_99);
+      free_arr(_0_99, 100);
+      pthread_t readers[4];
+      for (int32_t i = 0; i < 4; i++) {
+        pthread_create(&readers[i], NULL, &query_reader, list);
+      }
+      for (int32_t i = 0; i < 4; i++) {
+        void *result;
+        pthread_join(readers[i], &result);
+        mmzk_assert_equal_ptr(NULL, result, "\tanswers are right: ");
+      }
+      mmzk_list_free(list);
+    }
+    mmzk_assert_pop_caption("\n");
+  }
+
+  {
+    mmzk_assert_pop_caption("elem_index finds the first occurrence:\n");
+    void **elems = malloc(64 * sizeof(void *));
+    for (int32_t i = 0; i < 64; i++) {
+      elems[i] = malloc(sizeof(int32_t));
+      *(int32_t *)elems[i] = i % 16;
+    }
+    mmzk_list_t *list = mmzk_list_from_array(int_hash_funs, 64, elems);
+    mmzk_list_t *dropped = mmzk_list_drop(20, list);
+    for (int32_t round = 0; round < 8; round++) {
+      for (int32_t i = 0; i < 16; i++) {
+        mmzk_assert_equal_int32(i, (int32_t)mmzk_list_elem_index(&i, list), "\telem_index in list: ");
+        mmzk_assert_equal_int32((i + 12) % 16, (int32_t)mmzk_list_elem_index(&i, dropped), "\telem_index in dropped: ");
+      }
+    }
+    mmzk_list_free(list);
+    mmzk_list_free(dropped);
+    free_arr(elems, 64);
+    mmzk_assert_pop_caption("\n");
+  }
+
+  {
+    mmzk_assert_pop_caption("Positional access stays correct once the skip index is built:\n");
+    mmzk_list_t *take70 = mmzk_list_take(70, plain);
+    for (int32_t round = 0; round < 8; round++) {
+      for (int32_t i = 0; i < 100; i += 3) {
+        CHKELM(i, plain, i);
+        int32_t *end = mmzk_list_get_end(plain, (size_t)i);
+        mmzk_assert_equal_int32(99 - i, *end, "\tget_end check: ");
+        int_free(end);
+        mmzk_list_t *dropped = mmzk_list_drop((size_t)i, plain);
+        mmzk_assert_equal_int32(100 - i, mmzk_list_length(dropped), "\tlength of dropped: ");
+        CHKELM(i, dropped, 0);
+        mmzk_list_free(dropped);
+        mmzk_list_tuple_t split = mmzk_list_split_at((size_t)i, take70);
+        mmzk_assert_equal_int32(i < 70 ? 70 - i : 0, mmzk_list_length(split.snd), "\tlength of second half: ");
+        if (i < 70) {
+          CHKELM(i, split.snd, 0);
+        }
+        mmzk_list_free(split.fst);
+        mmzk_list_free(split.snd);
+      }
+    }
+    mmzk_assert_equal_ptr(NULL, mmzk_list_get(take70, 70), "\tget out of bound: ");
+
+    mmzk_assert_equal_ptr(NULL, mmzk_list_get_end(take70, 70), "\tget_end out of bound: ");
+    mmzk_list_t *one = mmzk_list_take(1, plain);
+    int32_t *last = mmzk_list_last(one);
+    mmzk_assert_equal_int32(0, *last, "\tlast of singleton: ");
+    int_free(last);
+    mmzk_list_free(one);
+    mmzk_list_free(take70);
+    mmzk_assert_pop_caption("\n");
+  }
+
+  {
+    mmzk_assert_pop_caption("Longer lists do not reuse the skip index of a shorter one:\n");
+    void **_0_999 = make_range(0, 999);
+    mmzk_list_t *list = mmzk_list_from_array(int_funs, 1000, _0_999);
+    free_arr(_0_999, 1000);
+    mmzk_list_t *take100 = mmzk_list_take(100, list);
+    for (int32_t round = 0; round < 8; round++) {
+      CHKELM(99, take100, 99);
+    }
+    for (int32_t round = 0; round < 8; round++) {
+      for (int32_t i = 0; i < 1000; i += 37) {
+        CHKELM(i, list, i);
+      }
+    }
+    int32_t *end = mmzk_list_get_end(list, 0);
+    mmzk_assert_equal_int32(999, *end, "\tget_end check: ");
+    int_free(end);
+    mmzk_list_t *dropped = mmzk_list_drop(998, list);
+    CHKELM(999, dropped, 1);
+    mmzk_list_free(dropped);
+    mmzk_list_free(take100);
+    mmzk_list_free(list);
+    mmzk_assert_pop_caption("\n");
+  }
+
+  {
+    mmzk_assert_pop_caption("The same list can be accessed by position from several threads:\n");
+    for (int32_t round = 0; round < 8; round++) {
+      void **_0_999 = make_range(0, 999);
+      mmzk_list_t *list = mmzk_list_from_array(int_funs, 1000, _0_999);
+      free_arr(_0_999, 1000);
+      pthread_t readers[4];
+      for (int32_t i = 0; i < 4; i++) {
+        pthread_create(&readers[i], NULL, &seek_reader, list);
+      }
+      for (int32_t i = 0; i < 4; i++) {
+        void *result;
+        pthread_join(readers[i], &result);
+        mmzk_assert_equal_ptr(NULL, result, "\telements are right: ");
+      }
+      mmzk_list_free(list);
+    }
+    mmzk_assert_pop_caption("\n");
+  }
+
+  {
+    mmzk_assert_pop_caption("Can gather elements at many indices:\n");
+    size_t indices[] = { 42, 7, 99, 100, 7, 0, 1000 };
+    void *borrowed[7];
+    void *copied[7];
+    mmzk_list_gather(plain, 7, indices, borrowed, false);
+    mmzk_list_gather(plain, 7, indices, copied, true);
+    for (int32_t j = 0; j < 7; j++) {
+      if (indices[j] < 100) {
+        mmzk_assert_equal_int32((int32_t)indices[j], *(int32_t *)borrowed[j], "\tborrowed element: ");
+        mmzk_assert_equal_int32((int32_t)indices[j], *(int32_t *)copied[j], "\tcopied element: ");
+        mmzk_assert_equal_int32(true, borrowed[j] != copied[j], "\tcopied is not borrowed: ");
+        int_free(copied[j]);
+      } else {
+        mmzk_assert_equal_ptr(NULL, borrowed[j], "\tout of bound is NULL: ");
+        mmzk_assert_equal_ptr(NULL, copied[j], "\tout of bound is NULL: ");
+      }
+    }
+    mmzk_assert_pop_caption("\n");
+  }
+
+  mmzk_list_free(plain);
+  mmzk_list_free(hashed);
+}
+
+static mmzk_list_t *from_ints(size_t len, int32_t ints[]) {
+  void **elems = malloc(len * sizeof(void *));
+  for (size_t i = 0; i < len; i++) {
+    elems[i] = &ints[i];
+  }
+  mmzk_list_t *list = mmzk_list_from_array(int_funs, len, elems);
+  free(elems);
+
+  return list;
+}
+
+static void sorted_set_test(void) {
+  mmzk_list_t *list1 = from_ints(5, (int32_t[]) { 1, 2, 2, 4, 6 });
+  mmzk_list_t *list2 = from_ints(7, (int32_t[]) { 2, 3, 4, 4, 7, 8, 9 });
+
+  {
+    mmzk_assert_pop_caption("Can merge sorted lists, sharing the rest of the longer one:\n");
+    int32_t expected[] = { 1, 2, 2, 2, 3, 4, 4, 4, 6, 7, 8, 9 };
+    mmzk_list_t *merged = mmzk_list_merge(&int_cmp, list1, list2);
+    mmzk_assert_equal_int32(12, mmzk_list_length(merged), "\tlength merged == 12: ");
+    for (int32_t i = 0; i < 12; i++) {
+      CHKELM(expected[i], merged, i);
+    }
+    mmzk_list_memory_report_t report = mmzk_list_memory_report_many(2, (mmzk_list_t *[]) { merged, list2 });
+    mmzk_assert_equal_int32(16, (int32_t)report.reachable, "\tthree nodes are shared: ");
+    mmzk_list_free(merged);
+    mmzk_assert_pop_caption("\n");
+  }
+
+  {
+    mmzk_assert_pop_caption("Merging is stable:\n");
+    mmzk_list_t *tens1 = from_ints(2, (int32_t[]) { 11, 25 });
+    mmzk_list_t *tens2 = from_ints(2, (int32_t[]) { 12, 21 });
+    int32_t expected[] = { 11, 12, 25, 21 };
+    mmzk_list_t *merged = mmzk_list_merge(&tens_cmp, tens1, tens2);
+    for (int32_t i = 0; i < 4; i++) {
+      CHKELM(expected[i], merged, i);
+    }
+    mmzk_list_free(merged);
+    mmzk_list_free(tens1);
+    mmzk_list_free(tens2);
+    mmzk_assert_pop_caption("\n");
+  }
+
+  {
+    mmzk_assert_pop_caption("Can take the union and the intersection:\n");
+    int32_t expected_union[] = { 1, 2, 2, 3, 4, 4, 6, 7, 8, 9 };
+    int32_t expected_intersection[] = { 2, 4 };
+    mmzk_list_t *union_list = mmzk_list_union_sorted(&int_cmp, list1, list2);
+    mmzk_list_t *intersection = mmzk_list_intersect_sorted(&int_cmp, list2, list1);
+    mmzk_assert_equal_int32(10, mmzk_list_length(union_list), "\tlength union_list == 10: ");
+    for (int32_t i = 0; i < 10; i++) {
+      CHKELM(expected_union[i], union_list, i);
+    }
+    mmzk_assert_equal_int32(2, mmzk_list_length(intersection), "\tlength intersection == 2: ");
+    for (int32_t i = 0; i < 2; i++) {
+      CHKELM(expected_intersection[i], intersection, i);
+    }
+    mmzk_list_free(union_list);
+    mmzk_list_free(intersection);
+    mmzk_assert_pop_caption("\n");
+  }
+
+  {
+    mmzk_assert_pop_caption("Can take the difference of non-persistent lists:\n");
+    int32_t expected1[] = { 1, 2, 6 };
+    int32_t expected2[] = { 3, 4, 7, 8, 9 };
+    mmzk_list_t *copy1 = mmzk_list_copy(list1);
+    mmzk_list_t *copy2 = mmzk_list_copy(list2);
+    mmzk_list_set_persistence(copy1, false);
+    mmzk_list_set_persistence(copy2, false);
+    mmzk_list_t *diff1 = mmzk_list_diff_sorted(&int_cmp, list1, list2);
+    mmzk_list_t *diff2 = mmzk_list_diff_sorted(&int_cmp, copy2, copy1);
+    mmzk_list_set_persistence(diff2, true);
+    for (int32_t i = 0; i < 3; i++) {
+      CHKELM(expected1[i], diff1, i);
+    }
+    mmzk_assert_equal_int32(5, mmzk_list_length(diff2), "\tlength diff2 == 5: ");
+    for (int32_t i = 0; i < 5; i++) {
+      CHKELM(expected2[i], diff2, i);
+    }
+    mmzk_list_free(diff1);
+    mmzk_list_free(diff2);
+    mmzk_assert_pop_caption("\n");
+  }
+
+  {
+    mmzk_assert_pop_caption("Only the windows of views are combined:\n");
+    mmzk_list_t *take3 = mmzk_list_take(3, list2);
+    mmzk_list_t *merged = mmzk_list_merge(&int_cmp, list1, take3);
+    mmzk_assert_equal_int32(8, mmzk_list_length(merged), "\tlength merged == 8: ");
+    CHKELM(6, merged, 7);
+    mmzk_list_free(take3);
+    mmzk_list_free(merged);
+    mmzk_assert_pop_caption("\n");
+  }
+
+  mmzk_list_free(list1);
+  mmzk_list_free(list2);
+}
+
+static void split_many_test(void) {
+  void **_1_10 = make_range(1, 10);
+  mmzk_list_t *one_to_ten = mmzk_list_from_array(int_funs, 10, _1_10);
+  free_arr(_1_10, 10);
+
+  {
+    mmzk_assert_pop_caption("Can split a list at many indices:\n");
+    size_t indices[] = { 0, 3, 3, 7, 12 };
+    int32_t lengths[] = { 0, 3, 0, 4, 3, 0 };
+    mmzk_list_t *slices[6];
+    mmzk_list_split_many(5, indices, one_to_ten, slices);
+    int32_t next = 1;
+    for (int32_t j = 0; j < 6; j++) {
+      mmzk_assert_equal_int32(lengths[j], mmzk_list_length(slices[j]), "\tlength of slice: ");
+      for (int32_t i = 0; i < lengths[j]; i++) {
+        CHKELM(next++, slices[j], i);
+      }
+      mmzk_list_free(slices[j]);
+    }
+    mmzk_assert_pop_caption("\n");
+  }
+
+  {
+    mmzk_assert_pop_caption("Splitting a non-persistent list consumes it:\n");
+    mmzk_list_t *copy = mmzk_list_copy(one_to_ten);
+    mmzk_list_set_persistence(copy, false);
+    size_t indices[] = { 5 };
+    mmzk_list_t *slices[2];
+    mmzk_list_split_many(1, indices, copy, slices);
+    mmzk_list_free(one_to_ten);
+    for (int32_t i = 0; i < 5; i++) {
+      CHKELM(i + 1, slices[0], i);
+      CHKELM(i + 6, slices[1], i);
+    }
+    mmzk_list_free(slices[0]);
+    mmzk_list_free(slices[1]);
+    mmzk_assert_pop_caption("\n");
+  }
+}
+
+static void zip_test(void) {
+  void **_1_10 = make_range(1, 10);
+  mmzk_list_t *one_to_ten = mmzk_list_from_array(int_funs, 10, _1_10);
+  mmzk_list_t *one_to_six = mmzk_list_from_array(int_funs, 6, _1_10);
+  free_arr(_1_10, 10);
+
+  {
+    mmzk_assert_pop_caption("Can zip lists with worker:\n");
+    mmzk_list_t *sums = mmzk_list_zip_with(int_funs, &sum_worker, one_to_ten, one_to_six, NULL);
+    mmzk_assert_equal_int32(6, mmzk_list_length(sums), "\tlength sums == 6: ");
+    for (int32_t i = 0; i < 6; i++) {
+      CHKELM(2 * i + 2, sums, i);
+    }
+
+    mmzk_list_free(sums);
+    mmzk_assert_pop_caption("\n");
+  }
+
+  {
+    mmzk_assert_pop_caption("Can zip and unzip lists:\n");
+    mmzk_list_t *tail = mmzk_list_tail(one_to_six);
+    mmzk_list_t *zipped = mmzk_list_zip(one_to_ten, tail);
+    mmzk_assert_equal_int32(5, mmzk_list_length(zipped), "\tlength zipped == 5: ");
+    for (int32_t i = 0; i < 5; i++) {
+      mmzk_pair_t *pair = mmzk_list_get(zipped, i);
+      mmzk_assert_equal_int32(i + 1, *(int32_t *)mmzk_pair_fst(pair), "\tfst check: ");
+      mmzk_assert_equal_int32(i + 2, *(int32_t *)mmzk_pair_snd(pair), "\tsnd check: ");
+      (mmzk_pair_funs.free_fun)(pair);
+    }
+
+    mmzk_list_tuple_t unzipped = mmzk_list_unzip(int_funs, int_funs, zipped);
+    mmzk_assert_equal_int32(5, mmzk_list_length(unzipped.fst), "\tlength $ fst unzipped == 5: ");
+    mmzk_assert_equal_int32(5, mmzk_list_length(unzipped.snd), "\tlength $ snd unzipped == 5: ");
+    for (int32_t i = 0; i < 5; i++) {
+      CHKELM(i + 1, unzipped.fst, i);
+      CHKELM(i + 2, unzipped.snd, i);
+    }
+
+    mmzk_list_free(tail);
+    mmzk_list_free(zipped);
+    mmzk_list_free(unzipped.fst);
+    mmzk_list_free(unzipped.snd);
+    mmzk_assert_pop_caption("\n");
+  }
+
+  {
+    mmzk_assert_pop_caption("Zipping non-persistent lists keeps shared nodes intact:\n");
+    MKINT(0);
+    mmzk_list_t *copy = mmzk_list_copy(one_to_six);
+    mmzk_list_set_persistence(copy, false);
+    mmzk_list_t *zero_to_six = mmzk_list_cons(_0, copy);
+    mmzk_list_t *tail = mmzk_list_tail(one_to_ten);
+    mmzk_list_set_persistence(tail, false);
+    mmzk_list_t *zipped = mmzk_list_zip(zero_to_six, tail);
+    mmzk_assert_equal_int32(7, mmzk_list_length(zipped), "\tlength zipped == 7: ");
+    for (int32_t i = 0; i < 7; i++) {
+      mmzk_pair_t *pair = mmzk_list_get(zipped, i);
+      mmzk_assert_equal_int32(i, *(int32_t *)mmzk_pair_fst(pair), "\tfst check: ");
+      mmzk_assert_equal_int32(i + 2, *(int32_t *)mmzk_pair_snd(pair), "\tsnd check: ");
+      (mmzk_pair_funs.free_fun)(pair);
+    }
+    for (int32_t i = 0; i < 6; i++) {
+      CHKELM(i + 1, one_to_six, i);
+    }
+
+    FRINT(0);
+    mmzk_list_free(zipped);
+    mmzk_assert_pop_caption("\n");
+  }
+
+  mmzk_list_free(one_to_ten);
+  mmzk_list_free(one_to_six);
+}
+
+static void grouping_test(void) {
+  mmzk_list_t *list = from_ints(8, (int32_t[]) { 12, 3, 15, 3, 27, 12, 8, 21 });
+
+  {
+    mmzk_assert_pop_caption("Can remove duplicates, keeping the first occurrences:\n");
+    int32_t expected[] = { 12, 3, 15, 27, 8, 21 };
+    void **elems = mmzk_list_to_array(list, NULL, NULL);
+    mmzk_list_t *hashed = mmzk_list_from_array(int_hash_funs, 8, elems);
+    free_arr(elems, 8);
+    mmzk_list_t *nubbed = mmzk_list_nub(hashed);
+    mmzk_list_t *nubbed_slow = mmzk_list_nub(list);
+    mmzk_assert_equal_int32(6, mmzk_list_length(nubbed), "\tlength nubbed == 6: ");
+    for (int32_t i = 0; i < 6; i++) {
+      CHKELM(expected[i], nubbed, i);
+    }
+    mmzk_assert_equal_int32(true, mmzk_list_equal(nubbed, nubbed_slow), "\tthe same without a hash function: ");
+
+    void **_1_1000 = make_range(1, 1000);
+    mmzk_list_t *long_list = mmzk_list_from_array(int_hash_funs, 1000, _1_1000);
+    mmzk_list_t *doubled = mmzk_list_concat(long_list, long_list);
+    mmzk_list_t *long_nubbed = mmzk_list_nub(doubled);
+    mmzk_assert_equal_int32(true, mmzk_list_equal(long_list, long_nubbed), "\tnub (xs ++ xs) == xs: ");
+    free_arr(_1_1000, 1000);
+
+    mmzk_list_free(hashed);
+    mmzk_list_free(nubbed);
+    mmzk_list_free(nubbed_slow);
+    mmzk_list_free(long_list);
+    mmzk_list_free(doubled);
+    mmzk_list_free(long_nubbed);
+    mmzk_assert_pop_caption("\n");
+  }
+
+  {
+    mmzk_assert_pop_caption("Can group elements by key:\n");
+    int32_t expected_keys[] = { 1, 0, 2 };
+    int32_t expected_lens[] = { 3, 3, 2 };
+    int32_t expected_elems[][3] = { { 12, 15, 12 }, { 3, 3, 8 }, { 27, 21 } };
+    mmzk_list_t *copy = mmzk_list_copy(list);
+    mmzk_list_set_persistence(copy, false);
+    mmzk_list_t *groups = mmzk_list_group_by_key(int_hash_funs, &tens_key, copy, NULL);
+    mmzk_assert_equal_int32(3, mmzk_list_length(groups), "\tlength groups == 3: ");
+    for (int32_t i = 0; i < 3; i++) {
+      mmzk_pair_t *pair = mmzk_list_get(groups, i);
+      mmzk_list_t *group = (mmzk_list_t *)mmzk_pair_snd(pair);
+      mmzk_assert_equal_int32(expected_keys[i], *(int32_t *)mmzk_pair_fst(pair), "\tkey check: ");
+      mmzk_assert_equal_int32(expected_lens[i], mmzk_list_length(group), "\tgroup length check: ");
+      for (int32_t j = 0; j < expected_lens[i]; j++) {
+        CHKELM(expected_elems[i][j], group, j);
+      }
+      (mmzk_pair_funs.free_fun)(pair);
+    }
+    mmzk_assert_equal_int32(8, mmzk_list_length(list), "\tthe original list is intact: ");
+
+    mmzk_list_free(groups);
+    mmzk_assert_pop_caption("\n");
+  }
+
+  {
+    mmzk_assert_pop_caption("Can partition a list in one pass:\n");
+    int32_t expected_fst[] = { 3, 3 };
+    int32_t expected_snd[] = { 12, 15, 27, 12, 8, 21 };
+    mmzk_list_tuple_t parts = mmzk_list_partition(&less_than_five, list);
+    mmzk_assert_equal_int32(2, mmzk_list_length(parts.fst), "\tlength $ fst parts == 2: ");
+    mmzk_assert_equal_int32(6, mmzk_list_length(parts.snd), "\tlength $ snd parts == 6: ");
+    for (int32_t i = 0; i < 2; i++) {
+      CHKELM(expected_fst[i], parts.fst, i);
+    }
+    for (int32_t i = 0; i < 6; i++) {
+      CHKELM(expected_snd[i], parts.snd, i);
+    }
+
+    mmzk_list_t *copy = mmzk_list_copy(list);
+    mmzk_list_set_persistence(copy, false);
+    mmzk_list_tuple_t moved = mmzk_list_partition(&not_less_than_five, copy);
+    mmzk_assert_equal_int32(true, mmzk_list_equal(parts.fst, moved.snd), "\tthe same for non-persistent lists: ");
+    mmzk_assert_equal_int32(true, mmzk_list_equal(parts.snd, moved.fst), "\tthe same for non-persistent lists: ");
+
+    mmzk_list_free(parts.fst);
+    mmzk_list_free(parts.snd);
+    mmzk_list_free(moved.fst);
+    mmzk_list_free(moved.snd);
+    mmzk_assert_pop_caption("\n");
+  }
+
+  mmzk_list_free(list);
+}
+
+static void iteration_test(void) {
+  void **_1_1000 = make_range(1, 1000);
+  mmzk_list_t *one_to_thousand = mmzk_list_from_array(int_funs, 1000, _1_1000);
+  free_arr(_1_1000, 1000);
+
+  {
+    mmzk_assert_pop_caption("Can yield elements in blocks:\n");
+    mmzk_list_iterator_t iter = mmzk_list_iterator(one_to_thousand);
+    void *buf[64];
+    int32_t expected = 1;
+    size_t count;
+    size_t blocks = 0;
+    bool is_matching = true;
+    while ((count = mmzk_list_yield_many(&iter, buf, 64)) > 0) {
+      for (size_t i = 0; i < count; i++) {
+        is_matching &= *(int32_t *)buf[i] == expected++;
+      }
+      blocks++;
+    }
+    mmzk_assert_equal_int32(true, is_matching, "\telements in order: ");
+    mmzk_assert_equal_int32(1001, expected, "\tall elements yielded: ");
+    mmzk_assert_equal_int32(16, (int32_t)blocks, "\tblocks == 16: ");
+    mmzk_assert_equal_int32(false, mmzk_list_has_next(iter), "\titerator exhausted: ");
+
+    mmzk_list_t *tail = mmzk_list_drop(997, one_to_thousand);
+    iter = mmzk_list_iterator(tail);
+    mmzk_assert_equal_int32(1, (int32_t)mmzk_list_yield_many(&iter, buf, 1), "\tyield one: ");
+    mmzk_assert_equal_int32(998, *(int32_t *)buf[0], "\telem check: ");
+    mmzk_assert_equal_int32(2, (int32_t)mmzk_list_yield_many(&iter, buf, 64), "\tyield the rest: ");
+    mmzk_assert_equal_int32(1000, *(int32_t *)buf[1], "\telem check: ");
+    mmzk_list_free(tail);
+    mmzk_assert_pop_caption("\n");
+  }
+
+  {
+    mmzk_assert_pop_caption("Can fold and filter long lists:\n");
+    int32_t sum = 0;
+    mmzk_list_fold_left(&add_left, &sum, one_to_thousand);
+    mmzk_assert_equal_int32(500500, sum, "\tfoldl (+) 0 [1..1000]: ");
+    int32_t first = 1001;
+    mmzk_list_fold_right(&first_below_right, &first, one_to_thousand);
+    mmzk_assert_equal_int32(1, first, "\tfoldr from the right: ");
+
+    mmzk_list_t *filtered = mmzk_list_filter(&less_than_five, one_to_thousand);
+    mmzk_assert_equal_int32(4, mmzk_list_length(filtered), "\tlength filtered == 4: ");
+    for (int32_t i = 0; i < 4; i++) {
+      CHKELM(i + 1, filtered, i);
+    }
+    mmzk_list_free(filtered);
+    filtered = mmzk_list_filter(&not_less_than_five, one_to_thousand);
+    mmzk_assert_equal_int32(996, mmzk_list_length(filtered), "\tlength filtered == 996: ");
+    CHKELM(5, filtered, 0);
+    CHKELM(1000, filtered, 995);
+    mmzk_list_free(filtered);
+    mmzk_assert_pop_caption("\n");
+  }
+
+  mmzk_list_free(one_to_thousand);
+}
+
+static void scan_test(void) {
+  {
+    mmzk_assert_pop_caption("Can scan from both ends:\n");
+    void **_1_3 = make_range(1, 3);
+    mmzk_list_t *one_to_three = mmzk_list_from_array(int_funs, 3, _1_3);
+    free_arr(_1_3, 3);
+    int32_t zero = 0;
+
+    mmzk_list_t *scanned = mmzk_list_scan_left(int_funs, &append_digit_left, &zero, one_to_three, NULL);
+    mmzk_assert_equal_int32(4, mmzk_list_length(scanned), "\tlength of scanl == 4: ");
+    CHKELM(0, scanned, 0);
+    CHKELM(1, scanned, 1);
+    CHKELM(12, scanned, 2);
+    CHKELM(123, scanned, 3);
+    mmzk_list_free(scanned);
+
+    scanned = mmzk_list_scan_right(int_funs, &append_digit_right, &zero, one_to_three, NULL);
+    mmzk_assert_equal_int32(4, mmzk_list_length(scanned), "\tlength of scanr == 4: ");
+    CHKELM(321, scanned, 0);
+    CHKELM(32, scanned, 1);
+    CHKELM(3, scanned, 2);
+    CHKELM(0, scanned, 3);
+    mmzk_list_free(scanned);
+
+    mmzk_list_t *empty = mmzk_list_new(int_funs);
+    scanned = mmzk_list_scan_left(int_funs, &plus, &zero, empty, NULL);
+    mmzk_assert_equal_int32(1, mmzk_list_length(scanned), "\tscanl of empty list: ");
+    CHKELM(0, scanned, 0);
+    mmzk_list_free(scanned);
+    scanned = mmzk_list_scan_right(int_funs, &plus, &zero, empty, NULL);
+    mmzk_assert_equal_int32(1, mmzk_list_length(scanned), "\tscanr of empty list: ");
+    CHKELM(0, scanned, 0);
+    mmzk_list_free(scanned);
+
+    mmzk_list_free(empty);
+    mmzk_list_free(one_to_three);
+    mmzk_assert_pop_caption("\n");
+  }
+
+  {
+    mmzk_assert_pop_caption("Can scan long lists in parallel:\n");
+    void **_1_12300 = make_range(1, 12300);
+    mmzk_list_t *long_list = mmzk_list_from_array(int_funs, 12300, _1_12300);
+    free_arr(_1_12300, 12300);
+    int32_t zero = 0;
+
+    mmzk_list_t *serial = mmzk_list_scan_left(int_funs, &plus, &zero, long_list, NULL);
+    mmzk_list_t *parallel = mmzk_list_scan_left_parallel(int_funs, &plus, &zero, long_list, NULL, 4);
+    mmzk_assert_equal_int32(12301, mmzk_list_length(parallel), "\tlength of scan == 12301: ");
+    mmzk_assert_equal_int32(true, mmzk_list_equal(serial, parallel), "\tsame as serial scan: ");
+    CHKELM(75651150, parallel, 12300);
+    mmzk_list_free(parallel);
+
+    parallel = mmzk_list_scan_left_parallel(int_funs, &second, &zero, long_list, NULL, 3);
+    bool is_matching = true;
+    int32_t expected = 0;
+    mmzk_list_iterator_t iter = mmzk_list_iterator(parallel);
+    while (mmzk_list_has_next(iter)) {
+      is_matching &= *(int32_t *)mmzk_list_yield(&iter) == expected++;
+    }
+    mmzk_assert_equal_int32(true, is_matching, "\tsegments in order: ");
+    mmzk_list_free(parallel);
+
+    mmzk_list_set_persistence(long_list, false);
+    parallel = mmzk_list_scan_left_parallel(int_funs, &plus, &zero, long_list, NULL, 64);
+    mmzk_assert_equal_int32(true, mmzk_list_equal(serial, parallel), "\tconsuming non-persistent list: ");
+    mmzk_list_free(parallel);
+    mmzk_list_free(serial);
+    mmzk_assert_pop_caption("\n");
+  }
+}
+
+static void ref_test(void) {
+  {
+    mmzk_assert_pop_caption("Can load, store and update atomic references:\n");
+    mmzk_list_t *empty = mmzk_list_new(int_funs);
+    mmzk_list_ref_t *ref = mmzk_list_ref_new(empty);
+    mmzk_list_t *snapshot = mmzk_list_ref_load(ref);
+    mmzk_assert_equal_int32(0, mmzk_list_length(snapshot), "\tlength snapshot == 0: ");
+
+    mmzk_list_ref_update(ref, &cons_next, NULL);
+    mmzk_list_ref_update(ref, &cons_next, NULL);
+    mmzk_list_t *updated = mmzk_list_ref_load(ref);
+    mmzk_assert_equal_int32(0, mmzk_list_length(snapshot), "\told snapshot unchanged: ");
+    mmzk_assert_equal_int32(2, mmzk_list_length(updated), "\tlength updated == 2: ");
+    CHKELM(2, updated, 0);
+    CHKELM(1, updated, 1);
+
+    void **_1_10 = make_range(1, 10);
+    mmzk_list_t *one_to_ten = mmzk_list_from_array(int_funs, 10, _1_10);
+    mmzk_list_ref_store(ref, one_to_ten);
+    mmzk_list_free(one_to_ten);
+    free_arr(_1_10, 10);
+    mmzk_list_t *stored = mmzk_list_ref_load(ref);
+    mmzk_assert_equal_int32(10, mmzk_list_length(stored), "\tlength stored == 10: ");
+    for (int32_t i = 0; i < 10; i++) {
+      CHKELM(i + 1, stored, i);
+    }
+    CHKELM(2, updated, 0);
+
+    mmzk_list_ref_release(ref, snapshot);
+    mmzk_list_ref_release(ref, updated);
+    mmzk_list_ref_release(ref, stored);
+    mmzk_list_ref_free(ref);
+    mmzk_list_free(empty);
+    mmzk_assert_pop_caption("\n");
+  }
+
+  {
+    mmzk_assert_pop_caption("Readers see whole lists while a writer updates:\n");
+    mmzk_list_t *empty = mmzk_list_new(int_funs);
+    mmzk_list_ref_t *ref = mmzk_list_ref_new(empty);
+    int32_t target = 2000;
+    void *arg[] = { ref, &target };
+    pthread_t readers[3];
+    for (size_t i = 0; i < 3; i++) {
+      pthread_create(&readers[i], NULL, &ref_reader, arg);
+    }
+    for (int32_t i = 0; i < target; i++) {
+      mmzk_list_ref_update(ref, &cons_next, NULL);
+    }
+    for (size_t i = 0; i < 3; i++) {
+      void *result;
+      pthread_join(readers[i], &result);
+      mmzk_assert_equal_ptr(NULL, result, "\tsnapshots are whole: ");
+    }
+
+    mmzk_list_t *snapshot = mmzk_list_ref_load(ref);
+    mmzk_assert_equal_int32(target, mmzk_list_length(snapshot), "\tall updates applied: ");
+    mmzk_list_ref_release(ref, snapshot);
+    mmzk_list_ref_free(ref);
+    mmzk_list_free(empty);
+    mmzk_assert_pop_caption("\n");
+  }
+
+  {
+    mmzk_assert_pop_caption("Snapshots are queried without building indices:\n");
+    void **_0_99 = make_range(0, 99);
+    mmzk_list_t *list = mmzk_list_from_array((mmzk_funs_t){&counted_eq, &int_copy, &int_free, &int_hash}, 100, _0_99);
+    free_arr(_0_99, 100);
+    mmzk_list_ref_t *ref = mmzk_list_ref_new(list);
+    mmzk_list_t *snapshot = mmzk_list_ref_load(ref);
+    int32_t last = 99;
+    for (int32_t round = 0; round < 8; round++) {
+      mmzk_assert_equal_int32(true, mmzk_list_is_elem(&last, snapshot), "\tis_elem in snapshot: ");
+      CHKELM(last, snapshot, last);
+    }
+    eq_calls = 0;
+    mmzk_assert_equal_int32(99, (int32_t)mmzk_list_elem_index(&last, snapshot), "\telem_index in snapshot: ");
+    mmzk_assert_equal_int32(100, eq_calls, "\tfound by linear search: ");
+    mmzk_list_ref_release(ref, snapshot);
+    mmzk_list_ref_free(ref);
+    mmzk_list_free(list);
+    mmzk_assert_pop_caption("\n");
+  }
+}
+
+static void sort_test(void) {
+  {
+    mmzk_assert_pop_caption("Can sort persistent list without modifying it:\n");
+    int32_t values[8] = { 5, 3, 9, 1, 8, 2, 7, 4 };
+    void *elems[8];
+    for (int32_t i = 0; i < 8; i++) {
+      elems[i] = &values[i];
+    }
+    mmzk_list_t *list = mmzk_list_from_array(int_funs, 8, elems);
+    mmzk_list_t *sorted = mmzk_list_sort(&int_cmp, list);
+    mmzk_assert_equal_int32(8, mmzk_list_length(sorted), "\tlength sorted == 8: ");
+    int32_t expected[8] = { 1, 2, 3, 4, 5, 7, 8, 9 };
+    for (int32_t i = 0; i < 8; i++) {
+      CHKELM(expected[i], sorted, i);
+      CHKELM(values[i], list, i);
+    }
+
+    mmzk_list_free(list);
+    mmzk_list_free(sorted);
+    mmzk_assert_pop_caption("\n");
+  }
+
+  {
+    mmzk_assert_pop_caption("Sorting is stable:\n");
+    int32_t values[8] = { 31, 12, 33, 14, 35, 16, 37, 18 };
+    void *elems[8];
+    for (int32_t i = 0; i < 8; i++) {
+      elems[i] = &values[i];
+    }
+    mmzk_list_t *list = mmzk_list_from_array(int_funs, 8, elems);
+    mmzk_list_t *sorted = mmzk_list_sort(&tens_cmp, list);
+    int32_t expected[8] = { 12, 14, 16, 18, 31, 33, 35, 37 };
+    for (int32_t i = 0; i < 8; i++) {
+      CHKELM(expected[i], sorted, i);
+    }
+
+    mmzk_list_free(list);
+    mmzk_list_free(sorted);
+    mmzk_assert_pop_caption("\n");
+  }
+
+  {
+    mmzk_assert_pop_caption("Sorting non-persistent list keeps the shared suffix intact:\n");
+    MKINT(7);
+    MKINT(8);
+    MKINT(9);
+    int32_t values[3] = { 3, 1, 2 };
+    void *elems[3] = { &values[0], &values[1], &values[2] };
+    mmzk_list_t *suffix = mmzk_list_from_array(int_funs, 3, elems);
+    mmzk_list_t *list = mmzk_list_copy(suffix);
+    mmzk_list_set_persistence(list, false);
+    list = mmzk_list_sort(&int_cmp, mmzk_list_cons(_9, mmzk_list_cons(_7, mmzk_list_cons(_8, list))));
+    mmzk_list_set_persistence(list, true);
+    int32_t expected[6] = { 1, 2, 3, 7, 8, 9 };
+    for (int32_t i = 0; i < 6; i++) {
+      CHKELM(expected[i], list, i);
+    }
+    for (int32_t i = 0; i < 3; i++) {
+      CHKELM(values[i], suffix, i);
+    }
+
+    FRINT(7);
+    FRINT(8);
+    FRINT(9);
+    mmzk_list_free(list);
+    mmzk_list_free(suffix);
+    mmzk_assert_pop_caption("\n");
+  }
+
+  {
+    mmzk_assert_pop_caption("Parallel sort agrees with sequential sort:\n");
+    int32_t len = 100000;
+    int32_t *values = malloc(len * sizeof(int32_t));
+    void **elems = malloc(len * sizeof(void *));
+    uint32_t seed = 1526;
+    for (int32_t i = 0; i < len; i++) {
+      seed = seed * 1103515245 + 12345;
+      values[i] = (int32_t)(seed >> 16) % 1000;
+      elems[i] = &values[i];
+    }
+    mmzk_list_t *list = mmzk_list_from_array(int_funs, len, elems);
+    mmzk_list_t *sorted = mmzk_list_sort(&int_cmp, list);
+    mmzk_list_t *par_sorted = mmzk_list_sort_parallel(&int_cmp, list, 4);
+    mmzk_assert_equal_int32(len, mmzk_list_length(par_sorted), "\tlength par_sorted == 100000: ");
+    mmzk_assert_equal_int32(true, is_sorted(sorted), "\tsorted is sorted: ");
+    mmzk_assert_equal_int32(true, mmzk_list_equal(sorted, par_sorted), "\tsorted == par_sorted: ");
+
+    mmzk_list_free(list);
+    mmzk_list_free(sorted);
+    mmzk_list_free(par_sorted);
+    free(values);
+    free(elems);
+    mmzk_assert_pop_caption("\n");
+  }
+}
+
 static void test_summary(void) {
   mmzk_test_summary(construction_test, "Test list construction and array conversion:\n");
+  mmzk_test_summary(builder_test, "Test list builder:\n");
+  mmzk_test_summary(compact_test, "Test list compaction:\n");
+  mmzk_test_summary(region_test, "Test lists in regions:\n");
   mmzk_test_summary(composition_test, "Test list prepending and concatenation:\n");
   mmzk_test_summary(take_drop_test, "Test take/drop functions:\n");
+  mmzk_test_summary(trim_test, "Test trimming of views:\n");
   mmzk_test_summary(split_span_test, "Test split/span functions:\n");
+  mmzk_test_summary(update_test, "Test element updates:\n");
+  mmzk_test_summary(memory_report_test, "Test memory reports:\n");
+  mmzk_test_summary(query_test, "Test membership queries:\n");
+  mmzk_test_summary(sorted_set_test, "Test sorted set operations:\n");
+  mmzk_test_summary(split_many_test, "Test splitting at many indices:\n");
+  mmzk_test_summary(zip_test, "Test zip functions:\n");
+  mmzk_test_summary(grouping_test, "Test grouping functions:\n");
+  mmzk_test_summary(iteration_test, "Test iteration in blocks:\n");
+  mmzk_test_summary(scan_test, "Test scan functions:\n");
+  mmzk_test_summary(ref_test, "Test atomic references:\n");
+  mmzk_test_summary(sort_test, "Test sort functions:\n");
 }
 
 int32_t main(int32_t argc, char **argv) {
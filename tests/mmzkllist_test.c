@@ -0,0 +1,514 @@
+#include <errno.h>
+#include <fcntl.h>
+#include <iso646.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+#include "../mmzkllist.h"
+#include "mmzktestbase.h"
+
+// Longer than the initial buffer of a stream, so that the buffer has to grow.
+#define LONG_RECORD_SIZE 100000
+
+// Long enough for the background thread of a readahead to wrap around its ring many times.
+#define STREAM_LENGTH 100000
+
+static bool int_eq(const void *i1, const void *i2) {
+  return *(int32_t *)i1 == *(int32_t *)i2;
+}
+
+static void *int_copy(const void *i1) {
+  int32_t *result = malloc(sizeof(int32_t));
+  *result = *(int32_t *)i1;
+  return result;
+}
+
+static void int_free(void *i1) {
+  free(i1);
+}
+
+static mmzk_funs_t int_funs = (mmzk_funs_t){&int_eq, &int_copy, &int_free};
+
+// 1, 2, 3, ... without end.
+static const void *succ(const void *i1) {
+  int32_t *result = malloc(sizeof(int32_t));
+  *result = i1 == NULL ? 1 : *(int32_t *)i1 + 1;
+  return result;
+}
+
+// 1, 2, ..., STREAM_LENGTH.
+static const void *succ_to_length(const void *i1) {
+  if (i1 != NULL && *(int32_t *)i1 == STREAM_LENGTH) {
+    return NULL;
+  }
+  return succ(i1);
+}
+
+// The number of elements copied by counted_funs and not yet freed, and the number of copies made in total. The copies
+// may be made by the thread of a readahead.
+static atomic_int live_count = 0;
+static atomic_int copy_count = 0;
+
+static void *counted_copy(const void *i1) {
+  live_count++;
+  copy_count++;
+  return int_copy(i1);
+}
+
+static void counted_free(void *i1) {
+  live_count--;
+  int_free(i1);
+}
+
+static mmzk_funs_t counted_funs = (mmzk_funs_t){&int_eq, &counted_copy, &counted_free};
+
+// The number of calls to the retention hook, and the count it was last called with.
+static int32_t hook_calls = 0;
+static size_t hook_memoized = 0;
+
+static void record_retention(size_t memoized) {
+  hook_calls++;
+  hook_memoized = memoized;
+}
+
+static void *add(void *accum, const void *i1) {
+  *(int64_t *)accum += *(int32_t *)i1;
+  return accum;
+}
+
+static void *add_record(void *accum, const void *r) {
+  *(int64_t *)accum += atoi(((const mmzk_record_t *)r)->data);
+  return accum;
+}
+
+// Write LEN bytes of DATA to a new pipe and close its write end. Returns the read end.
+static int pipe_of(const char *data, size_t len) {
+  int fds[2];
+  if (pipe(fds) != 0) {
+    return -1;
+  }
+  if (len > 0 && write(fds[1], data, len) != (ssize_t)len) {
+    len = 0;
+  }
+  close(fds[1]);
+
+  return fds[0];
+}
+
+// Write LEN bytes of DATA to a new temporary file, whose path is stored in PATH. Returns false if it fails.
+static bool temp_file_of(const char *data, size_t len, char path[]) {
+  strcpy(path, "/tmp/mmzkllist_test_XXXXXX");
+  int fd = mkstemp(path);
+  if (fd < 0) {
+    return false;
+  }
+
+  bool is_written = write(fd, data, len) == (ssize_t)len;
+  close(fd);
+
+  return is_written;
+}
+
+// Whether FD is an open file descriptor.
+static bool is_open(int fd) {
+  return fcntl(fd, F_GETFD) != -1 || errno != EBADF;
+}
+
+// Wait up to a second for FD to be closed by another thread. Returns whether it is.
+static bool wait_closed(int fd) {
+  for (int32_t i = 0; i < 1000 && is_open(fd); i++) {
+    nanosleep(&(struct timespec){ .tv_sec = 0, .tv_nsec = 1000000 }, NULL);
+  }
+
+  return !is_open(fd);
+}
+
+// The lowest file descriptor that is not open, which is the next one to be opened.
+static int next_fd(void) {
+  int fd = dup(STDIN_FILENO);
+  close(fd);
+
+  return fd;
+}
+
+// Whether the records in LIST are exactly the COUNT strings in EXPECTED. LIST is consumed.
+static bool records_are(mmzk_llist_t *list, size_t count, const char *expected[]) {
+  mmzk_llist_iterator_t iter = mmzk_llist_iterator(list);
+  size_t i = 0;
+  bool is_matching = true;
+
+  while (mmzk_llist_has_next(&iter)) {
+    const mmzk_record_t *record = mmzk_llist_yield(&iter);
+    is_matching &= i < count && record->size == strlen(expected[i]) && strcmp(record->data, expected[i]) == 0;
+    i++;
+  }
+
+  return is_matching && i == count;
+}
+
+static void stream_test(void) {
+  {
+    mmzk_assert_pop_caption("Can read lines from a pipe:\n");
+    const char *data = "alpha\nbeta\n\ngamma";
+    int fd = pipe_of(data, strlen(data));
+    mmzk_llist_t *lines = mmzk_llist_from_fd(fd, MMZK_RECORD_LINE);
+    mmzk_record_t *first = mmzk_llist_head(lines);
+    mmzk_assert_equal_int32(5, (int32_t)first->size, "\tsize of first line: ");
+    mmzk_assert_equal_int32(0, strcmp("alpha", first->data), "\tfirst line: ");
+    (mmzk_record_funs.free_fun)(first);
+
+    const char *expected[] = { "alpha", "beta", "", "gamma" };
+    mmzk_assert_equal_int32(true, records_are(lines, 4, expected), "\tlast line without separator: ");
+    mmzk_assert_equal_int32(true, is_open(fd), "\tfd left open: ");
+    close(fd);
+    mmzk_assert_pop_caption("\n");
+  }
+
+  {
+    mmzk_assert_pop_caption("Can read frames from a pipe:\n");
+    const char data[] = "\0\0\0\3abc" "\0\0\0\0" "\0\0\0\2de" "\0\0\0\11trunc";
+    int fd = pipe_of(data, sizeof(data) - 1);
+    const char *expected[] = { "abc", "", "de" };
+    mmzk_llist_t *frames = mmzk_llist_from_fd(fd, MMZK_RECORD_FRAME);
+    mmzk_assert_equal_int32(true, records_are(frames, 3, expected), "\ttruncated last frame ignored: ");
+    close(fd);
+    mmzk_assert_pop_caption("\n");
+  }
+
+  {
+    mmzk_assert_pop_caption("Empty inputs:\n");
+    int fd = pipe_of("", 0);
+    mmzk_llist_t *lines = mmzk_llist_from_fd(fd, MMZK_RECORD_LINE);
+    mmzk_assert_equal_int32(true, mmzk_llist_is_empty(lines), "\tno lines: ");
+    mmzk_assert_equal_ptr(NULL, mmzk_llist_head(lines), "\tno head: ");
+    mmzk_llist_free(lines);
+    close(fd);
+
+    fd = pipe_of("", 0);
+    mmzk_llist_t *frames = mmzk_llist_from_fd(fd, MMZK_RECORD_FRAME);
+    mmzk_assert_equal_int32(true, mmzk_llist_is_empty(frames), "\tno frames: ");
+    mmzk_llist_free(frames);
+    close(fd);
+    mmzk_assert_pop_caption("\n");
+  }
+
+  {
+    mmzk_assert_pop_caption("Can read lines from a temporary file:\n");
+    char *data = malloc(LONG_RECORD_SIZE + 8);
+    memset(data, 'x', LONG_RECORD_SIZE);
+    memcpy(data + LONG_RECORD_SIZE, "\nshort\n", 8);
+    FILE *file = tmpfile();
+    fwrite(data, 1, LONG_RECORD_SIZE + 7, file);
+    fflush(file);
+    lseek(fileno(file), 0, SEEK_SET);
+
+    mmzk_llist_t *lines = mmzk_llist_from_fd(fileno(file), MMZK_RECORD_LINE);
+    mmzk_llist_t *rest = mmzk_llist_tail(lines);
+    mmzk_record_t *record = mmzk_llist_head(lines);
+    mmzk_assert_equal_int32(LONG_RECORD_SIZE, (int32_t)record->size, "\tline longer than buffer: ");
+    mmzk_assert_equal_int32('x', record->data[LONG_RECORD_SIZE - 1], "\tend of long line: ");
+    mmzk_assert_equal_int32('\0', record->data[LONG_RECORD_SIZE], "\tNUL terminated: ");
+    (mmzk_record_funs.free_fun)(record);
+    const char *expected[] = { "short" };
+    mmzk_assert_equal_int32(true, records_are(rest, 1, expected), "\tline after long line: ");
+
+    mmzk_llist_free(lines);
+    fclose(file);
+    free(data);
+    mmzk_assert_pop_caption("\n");
+  }
+
+  {
+    mmzk_assert_pop_caption("Files are closed by their lists:\n");
+    mmzk_assert_equal_ptr(NULL, mmzk_llist_from_file("/nonexistent/mmzkllist", MMZK_RECORD_LINE), "\tmissing file: ");
+
+    char path[32];
+    const char *data = "one\ntwo\nthree\n";
+    mmzk_assert_equal_int32(true, temp_file_of(data, strlen(data), path), "\tfile written: ");
+    int fd = next_fd();
+    mmzk_llist_t *lines = mmzk_llist_from_file(path, MMZK_RECORD_LINE);
+    mmzk_assert_equal_int32(true, is_open(fd), "\tfile opened: ");
+    const char *expected[] = { "one", "two", "three" };
+    mmzk_assert_equal_int32(true, records_are(lines, 3, expected), "\tlines of file: ");
+    mmzk_assert_equal_int32(false, is_open(fd), "\tclosed when exhausted: ");
+
+    fd = next_fd();
+    lines = mmzk_llist_from_file(path, MMZK_RECORD_LINE);
+    mmzk_llist_t *rest = mmzk_llist_tail(lines);
+    mmzk_llist_free(lines);
+    mmzk_assert_equal_int32(true, is_open(fd), "\topen while referred to: ");
+    mmzk_llist_free(rest);
+    mmzk_assert_equal_int32(false, is_open(fd), "\tclosed when freed early: ");
+
+    unlink(path);
+    mmzk_assert_pop_caption("\n");
+  }
+}
+
+// Whether the elements of LIST are FROM, FROM + 1, ..., TO. LIST is consumed.
+static bool ints_are(mmzk_llist_t *list, int32_t from, int32_t to) {
+  mmzk_llist_iterator_t iter = mmzk_llist_iterator(list);
+  int32_t expected = from;
+  bool is_matching = true;
+
+  while (mmzk_llist_has_next(&iter)) {
+    is_matching &= *(int32_t *)mmzk_llist_yield(&iter) == expected && expected <= to;
+    expected++;
+  }
+
+  return is_matching && expected == to + 1;
+}
+
+static void readahead_test(void) {
+  {
+    mmzk_assert_pop_caption("Can read ahead of generators:\n");
+    mmzk_llist_t *nats = mmzk_llist_from_generator(int_funs, &succ_to_length, NULL);
+    mmzk_assert_equal_int32(true, mmzk_llist_readahead(nats, 16), "\treadahead started: ");
+    mmzk_assert_equal_int32(true, ints_are(nats, 1, STREAM_LENGTH), "\tall elements in order: ");
+
+    nats = mmzk_llist_from_generator(int_funs, &succ_to_length, NULL);
+    mmzk_assert_equal_int32(true, mmzk_llist_readahead(nats, 1), "\treadahead of one element: ");
+    mmzk_assert_equal_int32(true, ints_are(nats, 1, STREAM_LENGTH), "\tall elements in order: ");
+
+    nats = mmzk_llist_from_generator(int_funs, &succ_to_length, NULL);
+    mmzk_llist_t *rest = mmzk_llist_tail(nats);
+    mmzk_llist_t *shared = mmzk_llist_copy(rest);
+    mmzk_assert_equal_int32(true, mmzk_llist_readahead(nats, 64), "\treadahead after evaluated head: ");
+    mmzk_assert_equal_int32(true, ints_are(rest, 2, STREAM_LENGTH), "\tfirst list sharing the rest: ");
+    mmzk_assert_equal_int32(true, ints_are(shared, 2, STREAM_LENGTH), "\tsecond list sharing the rest: ");
+    int32_t *head = mmzk_llist_head(nats);
+    mmzk_assert_equal_int32(1, *head, "\thead unaffected: ");
+    int_free(head);
+    mmzk_llist_free(nats);
+
+    int32_t *ints = malloc(1000 * sizeof(int32_t));
+    const void **elems = malloc(1000 * sizeof(void *));
+    for (int32_t i = 0; i < 1000; i++) {
+      ints[i] = i + 1;
+      elems[i] = &ints[i];
+    }
+    nats = mmzk_llist_from_array(counted_funs, 1000, elems);
+    shared = mmzk_llist_copy(nats);
+    copy_count = 0;
+    mmzk_llist_readahead(nats, 16);
+    mmzk_assert_equal_int32(true, ints_are(nats, 1, 1000), "\tmemoizing for another list: ");
+    mmzk_assert_equal_int32(1000, copy_count, "\telements copied once: ");
+    mmzk_assert_equal_int32(1000, live_count, "\tmemoized elements kept: ");
+    mmzk_llist_free(shared);
+    mmzk_assert_equal_int32(0, live_count, "\tmemoized elements freed: ");
+    free(elems);
+    free(ints);
+
+    mmzk_llist_t *empty = mmzk_llist_new(int_funs);
+    mmzk_assert_equal_int32(false, mmzk_llist_readahead(empty, 16), "\tnothing to read ahead: ");
+    mmzk_llist_free(empty);
+    mmzk_assert_pop_caption("\n");
+  }
+
+  {
+    mmzk_assert_pop_caption("Can read ahead of streams:\n");
+    FILE *file = tmpfile();
+    for (int32_t i = 0; i < STREAM_LENGTH; i++) {
+      char frame[32];
+      int len = sprintf(frame + 4, "record %d", i);
+      frame[0] = frame[1] = frame[2] = 0;
+      frame[3] = (char)len;
+      fwrite(frame, 1, 4 + len, file);
+    }
+    fflush(file);
+    lseek(fileno(file), 0, SEEK_SET);
+
+    mmzk_llist_t *frames = mmzk_llist_from_fd(fileno(file), MMZK_RECORD_FRAME);
+    mmzk_assert_equal_int32(true, mmzk_llist_readahead(frames, 32), "\treadahead started: ");
+    mmzk_llist_iterator_t iter = mmzk_llist_iterator(frames);
+    int32_t count = 0;
+    bool is_matching = true;
+    while (mmzk_llist_has_next(&iter)) {
+      const mmzk_record_t *record = mmzk_llist_yield(&iter);
+      char expected[32];
+      sprintf(expected, "record %d", count++);
+      is_matching &= strcmp(expected, record->data) == 0;
+    }
+    mmzk_assert_equal_int32(STREAM_LENGTH, count, "\tnumber of frames: ");
+    mmzk_assert_equal_int32(true, is_matching, "\tframes in order: ");
+
+    fclose(file);
+    mmzk_assert_pop_caption("\n");
+  }
+
+  {
+    mmzk_assert_pop_caption("Can stop reading ahead early:\n");
+    mmzk_llist_t *nats = mmzk_llist_from_generator(int_funs, &succ, NULL);
+    mmzk_llist_readahead(nats, 8);
+    mmzk_llist_iterator_t iter = mmzk_llist_iterator(nats);
+    int32_t sum = 0;
+    for (int32_t i = 0; i < 1000 && mmzk_llist_has_next(&iter); i++) {
+      sum += *(int32_t *)mmzk_llist_yield(&iter);
+    }
+    mmzk_llist_iterator_close(&iter);
+    mmzk_assert_equal_int32(500500, sum, "\tclosed iterator: ");
+
+    // The thread is still producing, and may be blocked on a full ring, when the lists are freed.
+    nats = mmzk_llist_from_generator(int_funs, &succ, NULL);
+    mmzk_assert_equal_int32(true, mmzk_llist_readahead(nats, 1024), "\tfreed before forced: ");
+    mmzk_llist_free(nats);
+
+    nats = mmzk_llist_from_generator(int_funs, &succ, NULL);
+    mmzk_llist_readahead(nats, 4);
+    mmzk_llist_t *rest = mmzk_llist_tail(nats);
+    mmzk_llist_t *next = mmzk_llist_tail(rest);
+    int32_t *head = mmzk_llist_head(next);
+    mmzk_assert_equal_int32(3, *head, "\tfreed after forced: ");
+    int_free(head);
+    mmzk_llist_free(rest);
+    mmzk_llist_free(nats);
+    mmzk_llist_free(next);
+
+    // The thread is blocked reading a FIFO that is still open for writing, which must not block freeing the list.
+    char path[32];
+    strcpy(path, "/tmp/mmzkllist_test_XXXXXX");
+    mmzk_assert_equal_int32(0, mkstemp(path) < 0 || unlink(path) != 0 || mkfifo(path, 0600) != 0, "\tFIFO made: ");
+    int writer = open(path, O_RDWR);
+    const char *data = "a\nb\n";
+    mmzk_assert_equal_int32(4, (int32_t)write(writer, data, 4), "\tFIFO written: ");
+    int fd = next_fd();
+    mmzk_llist_t *lines = mmzk_llist_from_file(path, MMZK_RECORD_LINE);
+    mmzk_llist_readahead(lines, 4);
+    mmzk_llist_iterator_t lines_iter = mmzk_llist_iterator(lines);
+    int32_t count = 0;
+    while (count < 2 && mmzk_llist_has_next(&lines_iter)) {
+      count += ((const mmzk_record_t *)mmzk_llist_yield(&lines_iter))->size == 1;
+    }
+    mmzk_llist_iterator_close(&lines_iter);
+    mmzk_assert_equal_int32(2, count, "\tfreed while blocked: ");
+    mmzk_assert_equal_int32(true, is_open(fd), "\tfile open while blocked: ");
+    close(writer);
+    mmzk_assert_equal_int32(true, wait_closed(fd), "\tfile closed once unblocked: ");
+    unlink(path);
+    mmzk_assert_pop_caption("\n");
+  }
+}
+
+static void consumption_test(void) {
+  void **ints = malloc(1000 * sizeof(void *));
+  for (int32_t i = 0; i < 1000; i++) {
+    ints[i] = malloc(sizeof(int32_t));
+    *(int32_t *)ints[i] = i + 1;
+  }
+  mmzk_llist_set_retention_hook(&record_retention);
+
+  {
+    mmzk_assert_pop_caption("Ephemeral iterators free what they move past:\n");
+    mmzk_llist_t *list = mmzk_llist_from_array(counted_funs, 1000, (const void **)ints);
+    mmzk_llist_iterator_t iter = mmzk_llist_iterator(list);
+    bool is_constant = true;
+    while (mmzk_llist_has_next(&iter)) {
+      mmzk_llist_yield(&iter);
+      is_constant &= live_count == 0;
+    }
+    mmzk_assert_equal_int32(true, is_constant, "\tunshared list builds no nodes: ");
+    mmzk_assert_equal_int32(0, hook_calls, "\tno retention: ");
+
+    list = mmzk_llist_from_array(counted_funs, 1000, (const void **)ints);
+    mmzk_assert_equal_int32(true, ints_are(mmzk_llist_copy(list), 1, 1000), "\tmemoizing for another list: ");
+    mmzk_assert_equal_int32(1000, live_count, "\tall nodes kept: ");
+    iter = mmzk_llist_iterator(list);
+    int32_t behind = 0;
+    bool is_freeing = true;
+    while (mmzk_llist_has_next(&iter)) {
+      mmzk_llist_yield(&iter);
+      // Only the node of the current element is kept from those the iterator has reached.
+      is_freeing &= live_count == 1000 - behind;
+      behind++;
+    }
+    mmzk_assert_equal_int32(true, is_freeing, "\tnodes behind cursor freed: ");
+    mmzk_assert_equal_int32(0, live_count, "\tall nodes freed: ");
+    mmzk_assert_pop_caption("\n");
+  }
+
+  {
+    mmzk_assert_pop_caption("Retention hook reports memoized elements:\n");
+    mmzk_llist_t *list = mmzk_llist_from_array(counted_funs, 1000, (const void **)ints);
+    mmzk_llist_t *retained = mmzk_llist_copy(list);
+    hook_calls = 0;
+    mmzk_assert_equal_int32(true, ints_are(list, 1, 1000), "\telements in order: ");
+    mmzk_assert_equal_int32(1, hook_calls, "\thook called: ");
+    mmzk_assert_equal_int32(1000, (int32_t)hook_memoized, "\tcount of exhausted iterator: ");
+
+    mmzk_llist_t *rest = mmzk_llist_copy(retained);
+    mmzk_llist_iterator_t iter = mmzk_llist_iterator(rest);
+    for (int32_t i = 0; i < 10 && mmzk_llist_has_next(&iter); i++) {
+      mmzk_llist_yield(&iter);
+    }
+    mmzk_llist_iterator_close(&iter);
+    mmzk_llist_iterator_close(&iter);
+    mmzk_assert_equal_int32(1, hook_calls, "\tnothing new memoized: ");
+
+    mmzk_llist_free(retained);
+    mmzk_assert_equal_int32(0, live_count, "\tfreed with retaining list: ");
+
+    list = mmzk_llist_from_generator(int_funs, &succ, NULL);
+    retained = mmzk_llist_copy(list);
+    iter = mmzk_llist_iterator(list);
+    for (int32_t i = 0; i < 10 && mmzk_llist_has_next(&iter); i++) {
+      mmzk_llist_yield(&iter);
+    }
+    mmzk_llist_iterator_close(&iter);
+    mmzk_assert_equal_int32(2, hook_calls, "\thook called on early close: ");
+    mmzk_assert_equal_int32(10, (int32_t)hook_memoized, "\tcount of closed iterator: ");
+    mmzk_llist_free(retained);
+    mmzk_assert_pop_caption("\n");
+  }
+
+  {
+    mmzk_assert_pop_caption("Can fold lazy lists:\n");
+    int64_t sum = 0;
+    mmzk_llist_fold_left(&add, &sum, mmzk_llist_from_generator(int_funs, &succ_to_length, NULL));
+    mmzk_assert_equal_int32(true, sum == (int64_t)STREAM_LENGTH * (STREAM_LENGTH + 1) / 2, "\tsum of generator: ");
+
+    char data[4000];
+    size_t len = 0;
+    for (int32_t i = 1; i <= 500; i++) {
+      len += sprintf(data + len, "%d\n", i);
+    }
+    int fd = pipe_of(data, len);
+    sum = 0;
+    mmzk_llist_fold_left(&add_record, &sum, mmzk_llist_from_fd(fd, MMZK_RECORD_LINE));
+    mmzk_assert_equal_int32(125250, (int32_t)sum, "\tsum of lines: ");
+    close(fd);
+
+    sum = 0;
+    mmzk_llist_t *nats = mmzk_llist_from_generator(int_funs, &succ_to_length, NULL);
+    mmzk_llist_readahead(nats, 16);
+    mmzk_llist_fold_left(&add, &sum, nats);
+    mmzk_assert_equal_int32(true, sum == (int64_t)STREAM_LENGTH * (STREAM_LENGTH + 1) / 2, "\tsum with readahead: ");
+
+    sum = 7;
+    mmzk_llist_fold_left(&add, &sum, mmzk_llist_new(int_funs));
+    mmzk_assert_equal_int32(7, (int32_t)sum, "\tfold of empty list: ");
+    mmzk_assert_equal_int32(2, hook_calls, "\tno retention: ");
+    mmzk_assert_pop_caption("\n");
+  }
+
+  mmzk_llist_set_retention_hook(NULL);
+  for (int32_t i = 0; i < 1000; i++) {
+    free(ints[i]);
+  }
+  free(ints);
+}
+
+static void test_summary(void) {
+  mmzk_test_summary(stream_test, "Test lists of records from streams:\n");
+  mmzk_test_summary(readahead_test, "Test readahead:\n");
+  mmzk_test_summary(consumption_test, "Test ephemeral iteration and folds:\n");
+}
+
+int32_t main(int32_t argc, char **argv) {
+  return mmzk_test_report(test_summary, argc, argv);
+}
@@ -0,0 +1,258 @@
+#include <iso646.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../mmzkmap.h"
+#include "mmzktestbase.h"
+
+// Large enough for the tree to be rebalanced at many levels.
+#define MAP_SIZE 1000
+
+static bool int_eq(const void *i1, const void *i2) {
+  return *(int32_t *)i1 == *(int32_t *)i2;
+}
+
+static void *int_copy(const void *i1) {
+  int32_t *result = malloc(sizeof(int32_t));
+  *result = *(int32_t *)i1;
+  return result;
+}
+
+static void int_free(void *i1) {
+  free(i1);
+}
+
+static int int_cmp(const void *i1, const void *i2) {
+  int32_t x = *(int32_t *)i1;
+  int32_t y = *(int32_t *)i2;
+  return (x > y) - (x < y);
+}
+
+static mmzk_funs_t int_funs = (mmzk_funs_t){&int_eq, &int_copy, &int_free};
+
+// The keys 0, 1, ..., MAP_SIZE - 1 in a scrambled order.
+static int32_t scrambled(int32_t i) {
+  return (int32_t)(((int64_t)i * 7919) % MAP_SIZE);
+}
+
+// Whether KEYS is the list LOW, LOW + STEP, ..., up to HIGH.
+static bool keys_are(mmzk_list_t *keys, int32_t low, int32_t high, int32_t step) {
+  mmzk_list_iterator_t iter = mmzk_list_iterator(keys);
+  int32_t expected = low;
+
+  while (mmzk_list_has_next(iter)) {
+    if (expected > high || *(int32_t *)mmzk_list_yield(&iter) != expected) {
+      return false;
+    }
+    expected += step;
+  }
+
+  return expected > high;
+}
+
+static void construction_test(void) {
+  mmzk_map_t *map = mmzk_map_new(int_funs, int_funs, &int_cmp);
+  mmzk_map_set_persistence(map, false);
+  for (int32_t i = 0; i < MAP_SIZE; i++) {
+    int32_t key = scrambled(i);
+    int32_t value = key * 2;
+    map = mmzk_map_insert(&key, &value, map);
+  }
+  mmzk_map_set_persistence(map, true);
+
+  {
+    mmzk_assert_pop_caption("Can insert and look up keys:\n");
+    mmzk_assert_equal_int32(MAP_SIZE, (int32_t)mmzk_map_size(map), "\tsize of map: ");
+    for (int32_t key = 0; key < MAP_SIZE; key += 37) {
+      void *value = NULL;
+      mmzk_assert_equal_int32(true, mmzk_map_lookup(&key, map, &value), "\tkey found: ");
+      mmzk_assert_equal_int32(key * 2, *(int32_t *)value, "\tvalue check: ");
+      int_free(value);
+    }
+    int32_t missing = MAP_SIZE;
+    void *value = NULL;
+    mmzk_assert_equal_int32(false, mmzk_map_lookup(&missing, map, &value), "\tmissing key: ");
+    mmzk_assert_equal_ptr(NULL, value, "\tresult untouched: ");
+    mmzk_assert_pop_caption("\n");
+  }
+
+  {
+    mmzk_assert_pop_caption("Can list keys and values in order:\n");
+    mmzk_list_t *keys = mmzk_map_keys(map);
+    mmzk_assert_equal_int32(true, keys_are(keys, 0, MAP_SIZE - 1, 1), "\tkeys are sorted: ");
+    mmzk_list_t *pairs = mmzk_map_to_list(map);
+    mmzk_assert_equal_int32(MAP_SIZE, (int32_t)mmzk_list_length(pairs), "\tlength of pairs: ");
+    mmzk_list_iterator_t iter = mmzk_list_iterator(pairs);
+    bool is_matching = true;
+    while (mmzk_list_has_next(iter)) {
+      mmzk_pair_t *pair = mmzk_list_yield(&iter);
+      is_matching &= *(int32_t *)mmzk_pair_snd(pair) == *(int32_t *)mmzk_pair_fst(pair) * 2;
+    }
+    mmzk_assert_equal_int32(true, is_matching, "\tvalues match keys: ");
+
+    mmzk_map_t *built = mmzk_map_from_sorted_list(int_funs, int_funs, &int_cmp, pairs);
+    mmzk_list_t *rebuilt = mmzk_map_to_list(built);
+    mmzk_assert_equal_int32(true, mmzk_list_equal(pairs, rebuilt), "\tbulk build from sorted list: ");
+
+    mmzk_list_free(keys);
+    mmzk_list_free(pairs);
+    mmzk_list_free(rebuilt);
+    mmzk_map_free(built);
+    mmzk_assert_pop_caption("\n");
+  }
+
+  {
+    mmzk_assert_pop_caption("Can extract ranges:\n");
+    int32_t low = 100;
+    int32_t high = 199;
+    mmzk_list_t *keys = mmzk_map_keys_range(&low, &high, map);
+    mmzk_assert_equal_int32(true, keys_are(keys, 100, 199, 1), "\tkeys in [100, 199]: ");
+    mmzk_list_t *pairs = mmzk_map_range(&low, &high, map);
+    mmzk_assert_equal_int32(100, (int32_t)mmzk_list_length(pairs), "\tlength of pairs: ");
+    mmzk_list_free(keys);
+    mmzk_list_free(pairs);
+
+    low = -5;
+    high = 3;
+    keys = mmzk_map_keys_range(&low, &high, map);
+    mmzk_assert_equal_int32(true, keys_are(keys, 0, 3, 1), "\tkeys in [-5, 3]: ");
+    mmzk_list_free(keys);
+
+    low = 20;
+    high = 10;
+    keys = mmzk_map_keys_range(&low, &high, map);
+    mmzk_assert_equal_int32(0, (int32_t)mmzk_list_length(keys), "\tempty range: ");
+    mmzk_list_free(keys);
+    mmzk_assert_pop_caption("\n");
+  }
+
+  mmzk_map_free(map);
+}
+
+static void persistence_test(void) {
+  mmzk_map_t *map = mmzk_map_new(int_funs, int_funs, &int_cmp);
+  for (int32_t i = 0; i < MAP_SIZE; i++) {
+    int32_t key = scrambled(i);
+    int32_t value = key + 1;
+    mmzk_map_t *next = mmzk_map_insert(&key, &value, map);
+    mmzk_map_free(map);
+    map = next;
+  }
+
+  {
+    mmzk_assert_pop_caption("Old versions are not affected by updates:\n");
+    int32_t key = 500;
+    int32_t value = -1;
+    mmzk_map_t *replaced = mmzk_map_insert(&key, &value, map);
+    mmzk_map_t *deleted = mmzk_map_delete(&key, map);
+    void *result = NULL;
+    mmzk_assert_equal_int32(true, mmzk_map_lookup(&key, replaced, &result), "\tkey in new version: ");
+    mmzk_assert_equal_int32(-1, *(int32_t *)result, "\tvalue replaced: ");
+    int_free(result);
+    mmzk_assert_equal_int32(MAP_SIZE, (int32_t)mmzk_map_size(replaced), "\tsize unchanged: ");
+    mmzk_assert_equal_int32(false, mmzk_map_member(&key, deleted), "\tkey deleted: ");
+    mmzk_assert_equal_int32(MAP_SIZE - 1, (int32_t)mmzk_map_size(deleted), "\tsize of deleted: ");
+    mmzk_assert_equal_int32(true, mmzk_map_lookup(&key, map, &result), "\tkey in old version: ");
+    mmzk_assert_equal_int32(501, *(int32_t *)result, "\tvalue in old version: ");
+    int_free(result);
+    mmzk_assert_equal_int32(MAP_SIZE, (int32_t)mmzk_map_size(map), "\tsize of old version: ");
+
+    key = MAP_SIZE;
+    mmzk_map_t *unchanged = mmzk_map_delete(&key, map);
+    mmzk_assert_equal_int32(MAP_SIZE, (int32_t)mmzk_map_size(unchanged), "\tdeleting missing key: ");
+
+    mmzk_map_free(replaced);
+    mmzk_map_free(deleted);
+    mmzk_map_free(unchanged);
+    mmzk_assert_pop_caption("\n");
+  }
+
+  {
+    mmzk_assert_pop_caption("Can delete keys:\n");
+    mmzk_map_t *odds = mmzk_map_copy(map);
+    mmzk_map_set_persistence(odds, false);
+    for (int32_t i = 0; i < MAP_SIZE; i++) {
+      int32_t key = scrambled(i);
+      if (key % 2 == 0) {
+        odds = mmzk_map_delete(&key, odds);
+      }
+    }
+    mmzk_map_set_persistence(odds, true);
+    mmzk_assert_equal_int32(MAP_SIZE / 2, (int32_t)mmzk_map_size(odds), "\tsize of odds: ");
+    mmzk_list_t *keys = mmzk_map_keys(odds);
+    mmzk_assert_equal_int32(true, keys_are(keys, 1, MAP_SIZE - 1, 2), "\todd keys remain: ");
+    mmzk_list_free(keys);
+    keys = mmzk_map_keys(map);
+    mmzk_assert_equal_int32(true, keys_are(keys, 0, MAP_SIZE - 1, 1), "\toriginal keeps all keys: ");
+    mmzk_list_free(keys);
+
+    int32_t low = 10;
+    int32_t high = 20;
+    keys = mmzk_map_keys_range(&low, &high, odds);
+    mmzk_assert_equal_int32(true, keys_are(keys, 11, 19, 2), "\todd keys in [10, 20]: ");
+    mmzk_list_free(keys);
+    mmzk_map_free(odds);
+    mmzk_assert_pop_caption("\n");
+  }
+
+  mmzk_map_free(map);
+}
+
+static void set_test(void) {
+  int32_t ints[] = { 1, 3, 3, 5, 8, 8, 8, 13 };
+  void *elems[8];
+  for (size_t i = 0; i < 8; i++) {
+    elems[i] = &ints[i];
+  }
+  mmzk_list_t *list = mmzk_list_from_array(int_funs, 8, elems);
+
+  {
+    mmzk_assert_pop_caption("Can build sets from sorted lists:\n");
+    mmzk_map_t *set = mmzk_set_from_sorted_list(int_funs, &int_cmp, list);
+    mmzk_assert_equal_int32(5, (int32_t)mmzk_map_size(set), "\tduplicates dropped: ");
+    int32_t key = 8;
+    mmzk_assert_equal_int32(true, mmzk_map_member(&key, set), "\t8 is in set: ");
+    key = 4;
+    mmzk_assert_equal_int32(false, mmzk_map_member(&key, set), "\t4 is not in set: ");
+
+    mmzk_map_t *bigger = mmzk_map_insert(&key, NULL, set);
+    mmzk_list_t *keys = mmzk_map_keys(bigger);
+    int32_t expected[] = { 1, 3, 4, 5, 8, 13 };
+    mmzk_assert_equal_int32(6, (int32_t)mmzk_list_length(keys), "\tlength of keys: ");
+    for (size_t i = 0; i < 6; i++) {
+      void *elem = mmzk_list_get(keys, i);
+      mmzk_assert_equal_int32(expected[i], *(int32_t *)elem, "\tkey check: ");
+      int_free(elem);
+    }
+
+    mmzk_list_free(keys);
+    mmzk_map_free(set);
+    mmzk_map_free(bigger);
+    mmzk_assert_pop_caption("\n");
+  }
+
+  {
+    mmzk_assert_pop_caption("Empty sets:\n");
+    mmzk_map_t *set = mmzk_set_new(int_funs, &int_cmp);
+    mmzk_list_t *keys = mmzk_map_keys(set);
+    mmzk_assert_equal_int32(0, (int32_t)mmzk_map_size(set), "\tsize of empty set: ");
+    mmzk_assert_equal_int32(0, (int32_t)mmzk_list_length(keys), "\tno keys: ");
+    mmzk_list_free(keys);
+    mmzk_map_free(set);
+    mmzk_assert_pop_caption("\n");
+  }
+
+  mmzk_list_free(list);
+}
+
+static void test_summary(void) {
+  mmzk_test_summary(construction_test, "Test map construction, lookup and ranges:\n");
+  mmzk_test_summary(persistence_test, "Test map persistence and deletion:\n");
+  mmzk_test_summary(set_test, "Test sets:\n");
+}
+
+int32_t main(int32_t argc, char **argv) {
+  return mmzk_test_report(test_summary, argc, argv);
+}
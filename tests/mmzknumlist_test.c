@@ -0,0 +1,430 @@
+#include <iso646.h>
+#include <math.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../mmzknumlist.h"
+#include "mmzktestbase.h"
+
+// Long enough to span several chunks and leave a ragged tail for the kernels.
+#define LONG_LENGTH 5003
+
+static const mmzk_cmp_op_t ops[] = { MMZK_LT, MMZK_LE, MMZK_GT, MMZK_GE, MMZK_EQ, MMZK_NE };
+
+static int32_t *make_int32s(size_t len) {
+  int32_t *result = malloc(len * sizeof(int32_t));
+
+  for (size_t i = 0; i < len; i++) {
+    result[i] = (int32_t)((i * 7919) % 1000) - 500;
+  }
+
+  return result;
+}
+
+static int64_t *make_int64s(size_t len) {
+  int64_t *result = malloc(len * sizeof(int64_t));
+
+  for (size_t i = 0; i < len; i++) {
+    result[i] = ((int64_t)((i * 7919) % 1000) - 500) * 10000000000LL;
+  }
+
+  return result;
+}
+
+static double *make_doubles(size_t len) {
+  double *result = malloc(len * sizeof(double));
+
+  for (size_t i = 0; i < len; i++) {
+    result[i] = (double)((int32_t)((i * 7919) % 1000) - 500) / 4;
+  }
+
+  return result;
+}
+
+static bool int_eq(const void *i1, const void *i2) {
+  return *(int32_t *)i1 == *(int32_t *)i2;
+}
+
+static void *int_copy(const void *i1) {
+  int32_t *result = malloc(sizeof(int32_t));
+  *result = *(int32_t *)i1;
+  return result;
+}
+
+static void int_free(void *i1) {
+  free(i1);
+}
+
+static bool int32_op(mmzk_cmp_op_t op, int32_t x, int32_t c) {
+  switch (op) {
+    case MMZK_LT: return x < c;
+    case MMZK_LE: return x <= c;
+    case MMZK_GT: return x > c;
+    case MMZK_GE: return x >= c;
+    case MMZK_EQ: return x == c;
+    default: return x != c;
+  }
+}
+
+static bool int64_op(mmzk_cmp_op_t op, int64_t x, int64_t c) {
+  switch (op) {
+    case MMZK_LT: return x < c;
+    case MMZK_LE: return x <= c;
+    case MMZK_GT: return x > c;
+    case MMZK_GE: return x >= c;
+    case MMZK_EQ: return x == c;
+    default: return x != c;
+  }
+}
+
+static bool double_op(mmzk_cmp_op_t op, double x, double c) {
+  switch (op) {
+    case MMZK_LT: return x < c;
+    case MMZK_LE: return x <= c;
+    case MMZK_GT: return x > c;
+    case MMZK_GE: return x >= c;
+    case MMZK_EQ: return x == c;
+    default: return x != c;
+  }
+}
+
+static void construction_test(void) {
+  int32_t *int32s = make_int32s(LONG_LENGTH);
+  mmzk_numlist_t *nil = mmzk_numlist_new(MMZK_INT32);
+  mmzk_numlist_t *list = mmzk_numlist_from_array(MMZK_INT32, LONG_LENGTH, int32s);
+
+  {
+    mmzk_assert_pop_caption("Can construct lists from arrays:\n");
+    mmzk_assert_equal_int32(0, (int32_t)mmzk_numlist_length(nil), "\tlength of nil: ");
+    mmzk_assert_equal_int32(LONG_LENGTH, (int32_t)mmzk_numlist_length(list), "\tlength of list: ");
+    mmzk_assert_equal_int32(MMZK_INT32, mmzk_numlist_type(list), "\ttype of list: ");
+    for (size_t i = 0; i < LONG_LENGTH; i += 97) {
+      int32_t elem = 0;
+      mmzk_assert_equal_int32(true, mmzk_numlist_get(list, i, &elem), "\tget in bound: ");
+      mmzk_assert_equal_int32(int32s[i], elem, "\telem check: ");
+    }
+    int32_t elem = 42;
+    mmzk_assert_equal_int32(false, mmzk_numlist_get(list, LONG_LENGTH, &elem), "\tget out of bound: ");
+    mmzk_assert_equal_int32(42, elem, "\tresult untouched: ");
+    mmzk_assert_pop_caption("\n");
+  }
+
+  {
+    mmzk_assert_pop_caption("Can convert lists back to arrays:\n");
+    size_t len = 0;
+    int32_t *array = mmzk_numlist_to_array(list, &len);
+    mmzk_assert_equal_int32(LONG_LENGTH, (int32_t)len, "\tlength of array: ");
+    mmzk_assert_equal_int32(0, memcmp(array, int32s, LONG_LENGTH * sizeof(int32_t)), "\tarray content: ");
+    free(array);
+    mmzk_assert_pop_caption("\n");
+  }
+
+  {
+    mmzk_assert_pop_caption("Can convert boxed lists:\n");
+    void **elems = malloc(LONG_LENGTH * sizeof(void *));
+    for (size_t i = 0; i < LONG_LENGTH; i++) {
+      elems[i] = &int32s[i];
+    }
+    mmzk_list_t *boxed = mmzk_list_from_array((mmzk_funs_t) { int_eq, int_copy, int_free }, LONG_LENGTH, elems);
+    mmzk_numlist_t *unboxed = mmzk_numlist_from_list(MMZK_INT32, boxed);
+    mmzk_assert_equal_int32(true, mmzk_numlist_equal(list, unboxed), "\tequal to the original: ");
+    mmzk_numlist_free(unboxed);
+    mmzk_list_free(boxed);
+    free(elems);
+    mmzk_assert_pop_caption("\n");
+  }
+
+  mmzk_numlist_free(nil);
+  mmzk_numlist_free(list);
+  free(int32s);
+}
+
+static void composition_test(void) {
+  int32_t *int32s = make_int32s(LONG_LENGTH);
+  mmzk_numlist_t *first = mmzk_numlist_from_array(MMZK_INT32, 1000, int32s);
+  mmzk_numlist_t *second = mmzk_numlist_from_array(MMZK_INT32, LONG_LENGTH - 1000, int32s + 1000);
+  mmzk_numlist_t *whole = mmzk_numlist_from_array(MMZK_INT32, LONG_LENGTH, int32s);
+
+  {
+    mmzk_assert_pop_caption("Concatenation shares the second list:\n");
+    mmzk_numlist_t *concat = mmzk_numlist_concat(first, second);
+    mmzk_assert_equal_int32(LONG_LENGTH, (int32_t)mmzk_numlist_length(concat), "\tlength of concat: ");
+    mmzk_assert_equal_int32(true, mmzk_numlist_equal(concat, whole), "\tequal across unaligned chunks: ");
+    mmzk_numlist_t *copy = mmzk_numlist_copy(concat);
+    mmzk_assert_equal_int32(true, mmzk_numlist_equal(copy, concat), "\tequal to its copy: ");
+    mmzk_numlist_free(copy);
+    mmzk_numlist_free(concat);
+    int32_t elem = 0;
+    mmzk_numlist_get(second, 0, &elem);
+    mmzk_assert_equal_int32(int32s[1000], elem, "\tsecond list survives: ");
+    mmzk_assert_pop_caption("\n");
+  }
+
+  {
+    mmzk_assert_pop_caption("Lists of different types or contents are not equal:\n");
+    mmzk_numlist_t *other = mmzk_numlist_from_array(MMZK_INT64, 0, NULL);
+    mmzk_numlist_t *nil = mmzk_numlist_new(MMZK_INT32);
+    mmzk_assert_equal_int32(false, mmzk_numlist_equal(nil, other), "\tdifferent types: ");
+    mmzk_assert_equal_int32(false, mmzk_numlist_equal(first, whole), "\tdifferent lengths: ");
+    int32s[LONG_LENGTH - 1]++;
+    mmzk_numlist_t *changed = mmzk_numlist_from_array(MMZK_INT32, LONG_LENGTH, int32s);
+    mmzk_assert_equal_int32(false, mmzk_numlist_equal(changed, whole), "\tdifferent last element: ");
+    mmzk_numlist_free(changed);
+    mmzk_numlist_free(other);
+    mmzk_numlist_free(nil);
+    mmzk_assert_pop_caption("\n");
+  }
+
+  {
+    mmzk_assert_pop_caption("Non-persistent lists are consumed:\n");
+    mmzk_numlist_t *temp1 = mmzk_numlist_copy(first);
+    mmzk_numlist_t *temp2 = mmzk_numlist_copy(second);
+    mmzk_numlist_set_persistence(temp1, false);
+    mmzk_numlist_set_persistence(temp2, false);
+    mmzk_numlist_t *concat = mmzk_numlist_concat(temp1, temp2);
+    mmzk_assert_equal_int32(LONG_LENGTH, (int32_t)mmzk_numlist_length(concat), "\tlength of concat: ");
+    int64_t sum = 0;
+    mmzk_numlist_sum(concat, &sum);
+    int64_t expected = 0;
+    mmzk_numlist_sum(whole, &expected);
+    mmzk_assert_equal_int32(true, sum == expected, "\tsum: ");
+    mmzk_assert_pop_caption("\n");
+  }
+
+  mmzk_numlist_free(first);
+  mmzk_numlist_free(second);
+  mmzk_numlist_free(whole);
+  free(int32s);
+}
+
+static void int32_test(void) {
+  int32_t *int32s = make_int32s(LONG_LENGTH);
+  mmzk_numlist_t *list = mmzk_numlist_from_array(MMZK_INT32, LONG_LENGTH, int32s);
+
+  {
+    mmzk_assert_pop_caption("Can search for elements:\n");
+    for (int32_t x = -510; x < 510; x += 7) {
+      size_t expected = SIZE_MAX;
+      for (size_t i = 0; i < LONG_LENGTH; i++) {
+        if (int32s[i] == x) {
+          expected = i;
+          break;
+        }
+      }
+      mmzk_assert_equal_int32(expected == SIZE_MAX, !mmzk_numlist_is_elem(&x, list), "\tis_elem: ");
+      mmzk_assert_equal_int32(true, mmzk_numlist_elem_index(&x, list) == expected, "\telem_index: ");
+    }
+    mmzk_assert_pop_caption("\n");
+  }
+
+  {
+    mmzk_assert_pop_caption("Can filter by comparison:\n");
+    for (size_t o = 0; o < sizeof(ops) / sizeof(ops[0]); o++) {
+      int32_t c = 17;
+      mmzk_numlist_t *filtered = mmzk_numlist_filter(ops[o], &c, list);
+      size_t len = 0;
+      int32_t *array = mmzk_numlist_to_array(filtered, &len);
+      size_t k = 0;
+      bool ok = true;
+      for (size_t i = 0; i < LONG_LENGTH; i++) {
+        if (int32_op(ops[o], int32s[i], c)) {
+          ok = ok && k < len && array[k++] == int32s[i];
+        }
+      }
+      mmzk_assert_equal_int32(true, ok && k == len, "\tfilter: ");
+      free(array);
+      mmzk_numlist_free(filtered);
+    }
+    mmzk_assert_pop_caption("\n");
+  }
+
+  {
+    mmzk_assert_pop_caption("Can compute sum, minimum and maximum:\n");
+    int64_t sum = 0;
+    int32_t min = INT32_MAX;
+    int32_t max = INT32_MIN;
+    for (size_t i = 0; i < LONG_LENGTH; i++) {
+      sum += int32s[i];
+      min = int32s[i] < min ? int32s[i] : min;
+      max = int32s[i] > max ? int32s[i] : max;
+    }
+    int64_t actual_sum = 0;
+    int32_t actual_min = 0;
+    int32_t actual_max = 0;
+    mmzk_numlist_sum(list, &actual_sum);
+    mmzk_assert_equal_int32(true, sum == actual_sum, "\tsum: ");
+    mmzk_assert_equal_int32(true, mmzk_numlist_min(list, &actual_min), "\tmin exists: ");
+    mmzk_assert_equal_int32(min, actual_min, "\tmin: ");
+    mmzk_assert_equal_int32(true, mmzk_numlist_max(list, &actual_max), "\tmax exists: ");
+    mmzk_assert_equal_int32(max, actual_max, "\tmax: ");
+    mmzk_numlist_t *nil = mmzk_numlist_new(MMZK_INT32);
+    mmzk_assert_equal_int32(false, mmzk_numlist_min(nil, &actual_min), "\tmin of nil: ");
+    mmzk_assert_equal_int32(false, mmzk_numlist_max(nil, &actual_max), "\tmax of nil: ");
+    mmzk_numlist_sum(nil, &actual_sum);
+    mmzk_assert_equal_int32(true, actual_sum == 0, "\tsum of nil: ");
+    mmzk_numlist_free(nil);
+    mmzk_assert_pop_caption("\n");
+  }
+
+  {
+    mmzk_assert_pop_caption("Sums of int32 lists do not overflow:\n");
+    int32_t big[9];
+    for (int32_t i = 0; i < 9; i++) {
+      big[i] = INT32_MAX;
+    }
+    mmzk_numlist_t *bigs = mmzk_numlist_from_array(MMZK_INT32, 9, big);
+    int64_t sum = 0;
+    mmzk_numlist_sum(bigs, &sum);
+    mmzk_assert_equal_int32(true, sum == 9 * (int64_t)INT32_MAX, "\tsum: ");
+    mmzk_numlist_free(bigs);
+    mmzk_assert_pop_caption("\n");
+  }
+
+  mmzk_numlist_free(list);
+  free(int32s);
+}
+
+static void int64_test(void) {
+  int64_t *int64s = make_int64s(LONG_LENGTH);
+  mmzk_numlist_t *list = mmzk_numlist_from_array(MMZK_INT64, LONG_LENGTH, int64s);
+
+  {
+    mmzk_assert_pop_caption("Can search for elements:\n");
+    for (int64_t x = -510; x < 510; x += 7) {
+      int64_t value = x * 10000000000LL;
+      size_t expected = SIZE_MAX;
+      for (size_t i = 0; i < LONG_LENGTH; i++) {
+        if (int64s[i] == value) {
+          expected = i;
+          break;
+        }
+      }
+      mmzk_assert_equal_int32(true, mmzk_numlist_elem_index(&value, list) == expected, "\telem_index: ");
+    }
+    mmzk_assert_pop_caption("\n");
+  }
+
+  {
+    mmzk_assert_pop_caption("Can filter by comparison:\n");
+    for (size_t o = 0; o < sizeof(ops) / sizeof(ops[0]); o++) {
+      int64_t c = -30000000000LL;
+      mmzk_numlist_t *filtered = mmzk_numlist_filter(ops[o], &c, list);
+      size_t len = 0;
+      int64_t *array = mmzk_numlist_to_array(filtered, &len);
+      size_t k = 0;
+      bool ok = true;
+      for (size_t i = 0; i < LONG_LENGTH; i++) {
+        if (int64_op(ops[o], int64s[i], c)) {
+          ok = ok && k < len && array[k++] == int64s[i];
+        }
+      }
+      mmzk_assert_equal_int32(true, ok && k == len, "\tfilter: ");
+      free(array);
+      mmzk_numlist_free(filtered);
+    }
+    mmzk_assert_pop_caption("\n");
+  }
+
+  {
+    mmzk_assert_pop_caption("Can compute sum, minimum and maximum:\n");
+    int64_t sum = 0;
+    int64_t min = INT64_MAX;
+    int64_t max = INT64_MIN;
+    for (size_t i = 0; i < LONG_LENGTH; i++) {
+      sum += int64s[i];
+      min = int64s[i] < min ? int64s[i] : min;
+      max = int64s[i] > max ? int64s[i] : max;
+    }
+    int64_t actual_sum = 0;
+    int64_t actual_min = 0;
+    int64_t actual_max = 0;
+    mmzk_numlist_sum(list, &actual_sum);
+    mmzk_numlist_min(list, &actual_min);
+    mmzk_numlist_max(list, &actual_max);
+    mmzk_assert_equal_int32(true, sum == actual_sum, "\tsum: ");
+    mmzk_assert_equal_int32(true, min == actual_min, "\tmin: ");
+    mmzk_assert_equal_int32(true, max == actual_max, "\tmax: ");
+    mmzk_assert_pop_caption("\n");
+  }
+
+  mmzk_numlist_free(list);
+  free(int64s);
+}
+
+static void double_test(void) {
+  double *doubles = make_doubles(LONG_LENGTH);
+  mmzk_numlist_t *list = mmzk_numlist_from_array(MMZK_DOUBLE, LONG_LENGTH, doubles);
+
+  {
+    mmzk_assert_pop_caption("Can search for elements:\n");
+    double half = 0.1;
+    double quarter = -0.25;
+    double nan = NAN;
+    mmzk_assert_equal_int32(false, mmzk_numlist_is_elem(&half, list), "\tabsent element: ");
+    mmzk_assert_equal_int32(true, mmzk_numlist_is_elem(&quarter, list), "\tpresent element: ");
+    mmzk_assert_equal_int32(false, mmzk_numlist_is_elem(&nan, list), "\tNaN is never found: ");
+    mmzk_assert_pop_caption("\n");
+  }
+
+  {
+    mmzk_assert_pop_caption("Can filter by comparison, NaN included:\n");
+    doubles[LONG_LENGTH / 2] = NAN;
+    mmzk_numlist_t *with_nan = mmzk_numlist_from_array(MMZK_DOUBLE, LONG_LENGTH, doubles);
+    for (size_t o = 0; o < sizeof(ops) / sizeof(ops[0]); o++) {
+      double c = 3.25;
+      mmzk_numlist_t *filtered = mmzk_numlist_filter(ops[o], &c, with_nan);
+      size_t len = 0;
+      double *array = mmzk_numlist_to_array(filtered, &len);
+      size_t k = 0;
+      bool ok = true;
+      for (size_t i = 0; i < LONG_LENGTH; i++) {
+        if (double_op(ops[o], doubles[i], c)) {
+          ok = ok && k < len && memcmp(&array[k++], &doubles[i], sizeof(double)) == 0;
+        }
+      }
+      mmzk_assert_equal_int32(true, ok && k == len, "\tfilter: ");
+      free(array);
+      mmzk_numlist_free(filtered);
+    }
+    mmzk_numlist_t *another = mmzk_numlist_from_array(MMZK_DOUBLE, LONG_LENGTH, doubles);
+    mmzk_assert_equal_int32(false, mmzk_numlist_equal(with_nan, another), "\tNaN is not equal to itself: ");
+    mmzk_numlist_free(another);
+    mmzk_numlist_free(with_nan);
+    mmzk_assert_pop_caption("\n");
+  }
+
+  {
+    mmzk_assert_pop_caption("Can compute sum, minimum and maximum:\n");
+    double actual_sum = 0;
+    double actual_min = 0;
+    double actual_max = 0;
+    mmzk_numlist_sum(list, &actual_sum);
+    mmzk_numlist_min(list, &actual_min);
+    mmzk_numlist_max(list, &actual_max);
+    double sum = 0;
+    for (size_t i = 0; i < LONG_LENGTH; i++) {
+      sum += (double)((int32_t)((i * 7919) % 1000) - 500) / 4;
+    }
+    mmzk_assert_equal_int32(true, fabs(sum - actual_sum) < 1e-6, "\tsum: ");
+    mmzk_assert_equal_int32(true, actual_min == -125.0, "\tmin: ");
+    mmzk_assert_equal_int32(true, actual_max == 124.75, "\tmax: ");
+    mmzk_assert_pop_caption("\n");
+  }
+
+  mmzk_numlist_free(list);
+  free(doubles);
+}
+
+static void test_summary(void) {
+  mmzk_test_summary(construction_test, "Test numeric list construction and array conversion:\n");
+  mmzk_test_summary(composition_test, "Test numeric list concatenation and equality:\n");
+  mmzk_test_summary(int32_test, "Test int32 kernels:\n");
+  mmzk_test_summary(int64_test, "Test int64 kernels:\n");
+  mmzk_test_summary(double_test, "Test double kernels:\n");
+}
+
+int32_t main(int32_t argc, char **argv) {
+  return mmzk_test_report(test_summary, argc, argv);
+}